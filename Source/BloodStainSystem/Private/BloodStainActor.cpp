@@ -128,9 +128,10 @@ void ABloodStainActor::StartReplay()
 	{
 		if (UBloodStainSubsystem* Subsystem = World->GetGameInstance()->GetSubsystem<UBloodStainSubsystem>())
 		{
-			if (bAllowMultiplePlayback || !Subsystem->IsPlaying(LastPlaybackKey))
+			if (bAllowMultiplePlayback || (!Subsystem->IsPlaying(LastPlaybackKey) && !Subsystem->IsReplayLoading(LastPlaybackKey)))
 			{
-				Subsystem->StartReplayByBloodStain(InteractingPlayerController, this, LastPlaybackKey);
+				// The replay file is loaded in the background, the ghosts appear once it is decoded
+				LastPlaybackKey = Subsystem->StartReplayFromFileAsync(InteractingPlayerController, ReplayFileName, LevelName, FOnReplayStarted(), PlaybackOptions);
 				if (GetOwner())
 				{
 					Client_HideInteractionWidget();
@@ -5,8 +5,10 @@
 
 #include "BloodStainFileUtils.h"
 #include "BloodStainCompressionUtils.h"
+#include "BloodStainRecordDataUtils.h"
 #include "BloodStainSystem.h"
 #include "QuantizationHelper.h"
+#include "Async/ParallelFor.h"
 #include "Serialization/BufferArchive.h"
 
 namespace BloodStainFileUtils_Internal
@@ -54,6 +56,364 @@ namespace BloodStainFileUtils_Internal
 		const FString Dir = GetSaveDirectory();
 		return Dir / (RelativeFilePath + FILE_EXTENSION);
 	}
+
+	bool CheckFileHeader(const FBloodStainFileHeader& FileHeader, const FString& Path)
+	{
+		if (!FileHeader.IsValid())
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Not a BloodStain file or unsupported version %u (magic 0x%08x): %s"), FileHeader.Version, FileHeader.Magic, *Path);
+			return false;
+		}
+		return true;
+	}
+
+	/** Appends a section, compressed with Compression unless it does not get any smaller */
+	void AddSection(TArray<FBloodStainFileSection>& Sections, TArray<TArray<uint8>>& SectionData, uint8 Type, int32 ActorIndex, TArray<uint8>&& RawBytes, ECompressionMethod Compression)
+	{
+		FBloodStainFileSection& Section = Sections.AddDefaulted_GetRef();
+		Section.Type = Type;
+		Section.ActorIndex = ActorIndex;
+		Section.UncompressedSize = RawBytes.Num();
+
+		TArray<uint8>& Data = SectionData.AddDefaulted_GetRef();
+		if (Compression != ECompressionMethod::None
+			&& BloodStainCompressionUtils::CompressBuffer(RawBytes, Data, Compression)
+			&& Data.Num() < RawBytes.Num())
+		{
+			Section.Compression = Compression;
+		}
+		else
+		{
+			Data = MoveTemp(RawBytes);
+		}
+		Section.Size = Data.Num();
+	}
+
+	/** Compresses RawBytes as AddSection does and writes it to the file, its offset being relative to the start of the payload */
+	bool WriteSection(FArchive& FileWriter, int64 PayloadStart, TArray<FBloodStainFileSection>& Sections, uint8 Type, int32 ActorIndex, TArray<uint8>&& RawBytes, ECompressionMethod Compression)
+	{
+		TArray<TArray<uint8>> SectionData;
+		AddSection(Sections, SectionData, Type, ActorIndex, MoveTemp(RawBytes), Compression);
+		Sections.Last().Offset = FileWriter.Tell() - PayloadStart;
+		FileWriter.Serialize(SectionData[0].GetData(), SectionData[0].Num());
+		return !FileWriter.IsError();
+	}
+
+	FBloodStainActorIndexEntry MakeIndexEntry(const FRecordActorSaveData& ActorData)
+	{
+		FBloodStainActorIndexEntry Entry;
+		Entry.NumFrames = ActorData.RecordedFrames.Num();
+		Entry.StartTime = Entry.NumFrames > 0 ? ActorData.RecordedFrames[0].TimeStamp : 0.f;
+		Entry.EndTime = Entry.NumFrames > 0 ? ActorData.RecordedFrames.Last().TimeStamp : 0.f;
+		return Entry;
+	}
+
+	/** Index section : [int32 NumActors][FBloodStainActorIndexEntry...] */
+	void SerializeIndexSection(FArchive& Ar, TArray<FBloodStainActorIndexEntry>& IndexEntries)
+	{
+		int32 NumEntries = IndexEntries.Num();
+		Ar << NumEntries;
+		for (FBloodStainActorIndexEntry& Entry : IndexEntries)
+		{
+			Ar << Entry;
+		}
+	}
+
+	/** Metadata section : [StringTable][int32 NumActors][actor metadata...], the table is only complete once every actor is written */
+	void SerializeMetadataSection(FBufferArchive& Ar, TArray<FRecordActorSaveData>& Actors)
+	{
+		FBloodStainStringTable StringTable;
+		FBufferArchive ActorsAr;
+		int32 NumEntries = Actors.Num();
+		ActorsAr << NumEntries;
+		for (FRecordActorSaveData& ActorData : Actors)
+		{
+			SerializeActorMetadata(ActorsAr, ActorData, &StringTable);
+		}
+
+		Ar << StringTable;
+		Ar.Append(ActorsAr);
+	}
+
+	/**
+	 * Writes [int32 HeaderByteSize][FileHeader][RecordHeader][int32 NumSections][section table], the start of every file.
+	 * @return HeaderByteSize, the payload (section table) starts at this offset
+	 */
+	int32 SerializeFileHeaders(FBufferArchive& Ar, FBloodStainFileHeader& FileHeader, FRecordHeaderData& RecordHeader, TArray<FBloodStainFileSection>& Sections)
+	{
+		const int64 StartPos = Ar.Tell();
+		int32 HeaderByteSize = 0;
+		Ar << HeaderByteSize;
+
+		Ar << FileHeader;
+		Ar << RecordHeader;
+
+		const int64 EndPos = Ar.Tell();
+		HeaderByteSize = static_cast<int32>(EndPos - StartPos);
+
+		Ar.Seek(StartPos);
+		Ar << HeaderByteSize;
+		Ar.Seek(EndPos);
+
+		int32 NumSections = Sections.Num();
+		Ar << NumSections;
+		for (FBloodStainFileSection& Section : Sections)
+		{
+			Ar << Section;
+		}
+		return HeaderByteSize;
+	}
+
+	/**
+	 * Splits SaveData into the sections of an EBloodStainFileVersion::SectionTable payload, the actor sections being encoded in parallel.
+	 * Returns the section table (offsets included) and the data of each section, in payload order.
+	 */
+	void EncodeSections(FRecordSaveData& SaveData, const FBloodStainFileOptions& Options, TArray<FBloodStainFileSection>& OutSections, TArray<TArray<uint8>>& OutSectionData)
+	{
+		ComputeRanges(SaveData);
+
+		const int32 NumActors = SaveData.RecordActorDataArray.Num();
+		OutSections.Reset(NumActors + 2);
+		OutSectionData.Reset(NumActors + 2);
+
+		{
+			TArray<FBloodStainActorIndexEntry> IndexEntries;
+			IndexEntries.Reserve(NumActors);
+			for (const FRecordActorSaveData& ActorData : SaveData.RecordActorDataArray)
+			{
+				IndexEntries.Add(MakeIndexEntry(ActorData));
+			}
+
+			FBufferArchive IndexAr;
+			SerializeIndexSection(IndexAr, IndexEntries);
+			AddSection(OutSections, OutSectionData, EBloodStainFileSection::Index, INDEX_NONE, MoveTemp(IndexAr), ECompressionMethod::None);
+		}
+
+		{
+			FBufferArchive MetadataAr;
+			SerializeMetadataSection(MetadataAr, SaveData.RecordActorDataArray);
+			AddSection(OutSections, OutSectionData, EBloodStainFileSection::Metadata, INDEX_NONE, MoveTemp(MetadataAr), Options.CompressionOption);
+		}
+
+		TArray<TArray<FBloodStainFileSection>> ActorSections;
+		TArray<TArray<TArray<uint8>>> ActorSectionData;
+		ActorSections.SetNum(NumActors);
+		ActorSectionData.SetNum(NumActors);
+		ParallelFor(NumActors, [&](int32 ActorIndex)
+		{
+			FBufferArchive FramesAr;
+			SerializeActorFrames(FramesAr, SaveData.RecordActorDataArray[ActorIndex], Options);
+			AddSection(ActorSections[ActorIndex], ActorSectionData[ActorIndex], EBloodStainFileSection::ActorFrames, ActorIndex, MoveTemp(FramesAr), Options.CompressionOption);
+		});
+		for (int32 ActorIndex = 0; ActorIndex < NumActors; ++ActorIndex)
+		{
+			OutSections.Append(MoveTemp(ActorSections[ActorIndex]));
+			OutSectionData.Append(MoveTemp(ActorSectionData[ActorIndex]));
+		}
+
+		// Sections follow the table, whose serialized size does not depend on the offsets
+		FBufferArchive TableAr;
+		int32 NumSections = OutSections.Num();
+		TableAr << NumSections;
+		for (FBloodStainFileSection& Section : OutSections)
+		{
+			TableAr << Section;
+		}
+
+		int64 Offset = TableAr.Num();
+		for (FBloodStainFileSection& Section : OutSections)
+		{
+			Section.Offset = Offset;
+			Offset += Section.Size;
+		}
+	}
+
+	/** Reads the section table at the start of a SectionTable payload and checks every section lies within PayloadSize */
+	bool ReadSectionTable(FArchive& Ar, int64 PayloadSize, TArray<FBloodStainFileSection>& OutSections)
+	{
+		int32 NumSections = 0;
+		Ar << NumSections;
+		if (Ar.IsError() || NumSections < 0 || NumSections > PayloadSize)
+		{
+			return false;
+		}
+
+		OutSections.SetNum(NumSections);
+		for (FBloodStainFileSection& Section : OutSections)
+		{
+			Ar << Section;
+			if (Section.Offset < 0 || Section.Size < 0 || Section.UncompressedSize < 0 || Section.Offset + Section.Size > PayloadSize)
+			{
+				return false;
+			}
+		}
+		return !Ar.IsError();
+	}
+
+	bool DecompressSection(const FBloodStainFileSection& Section, TArray<uint8>&& Data, TArray<uint8>& OutRawBytes)
+	{
+		if (Section.Compression == ECompressionMethod::None)
+		{
+			OutRawBytes = MoveTemp(Data);
+			return true;
+		}
+		return BloodStainCompressionUtils::DecompressBuffer(Section.UncompressedSize, Data, OutRawBytes, Section.Compression);
+	}
+
+	bool DecodeSection(const TArray<uint8>& Payload, const FBloodStainFileSection& Section, TArray<uint8>& OutRawBytes)
+	{
+		TArray<uint8> Data(Payload.GetData() + Section.Offset, static_cast<int32>(Section.Size));
+		return DecompressSection(Section, MoveTemp(Data), OutRawBytes);
+	}
+
+	bool DecodeMetadata(const TArray<uint8>& RawBytes, uint32 Version, FRecordSaveData& OutData)
+	{
+		FMemoryReader MetadataReader(RawBytes, true);
+
+		// SectionTable files store the component metadata strings inline
+		FBloodStainStringTable StringTable;
+		const bool bHasStringTable = Version >= EBloodStainFileVersion::StringTable;
+		if (bHasStringTable)
+		{
+			MetadataReader << StringTable;
+		}
+
+		int32 NumActors = 0;
+		MetadataReader << NumActors;
+		if (MetadataReader.IsError() || NumActors < 0 || NumActors > RawBytes.Num())
+		{
+			return false;
+		}
+
+		OutData.RecordActorDataArray.SetNum(NumActors);
+		for (FRecordActorSaveData& ActorData : OutData.RecordActorDataArray)
+		{
+			SerializeActorMetadata(MetadataReader, ActorData, bHasStringTable ? &StringTable : nullptr);
+		}
+		return !MetadataReader.IsError();
+	}
+
+	/** Decodes an EBloodStainFileSection::ActorFrameBlocks section, the frames of each block are padded to the actor's track table */
+	bool DecodeFrameBlocks(const TArray<uint8>& RawBytes, FRecordActorSaveData& ActorData, const FBloodStainFileOptions& Options)
+	{
+		FMemoryReader Reader(RawBytes, true);
+		int32 NumBlocks = 0;
+		Reader << NumBlocks;
+		if (Reader.IsError() || NumBlocks < 0 || NumBlocks > RawBytes.Num())
+		{
+			return false;
+		}
+
+		ActorData.RecordedFrames.Reset();
+		for (int32 BlockIndex = 0; BlockIndex < NumBlocks; ++BlockIndex)
+		{
+			int64 UncompressedSize = 0;
+			int64 Size = 0;
+			Reader << UncompressedSize;
+			Reader << Size;
+			if (Reader.IsError() || Size < 0 || UncompressedSize < 0 || Size > Reader.TotalSize() - Reader.Tell())
+			{
+				return false;
+			}
+
+			TArray<uint8> Data(RawBytes.GetData() + Reader.Tell(), static_cast<int32>(Size));
+			Reader.Seek(Reader.Tell() + Size);
+
+			TArray<uint8> BlockBytes;
+			if (Options.CompressionOption == ECompressionMethod::None)
+			{
+				BlockBytes = MoveTemp(Data);
+			}
+			else if (!BloodStainCompressionUtils::DecompressBuffer(UncompressedSize, Data, BlockBytes, Options.CompressionOption))
+			{
+				return false;
+			}
+
+			// Tracks are only ever appended, the table of a block is a prefix of the actor's
+			FMemoryReader BlockReader(BlockBytes, true);
+			FRecordActorSaveData Block;
+			if (!DeserializeFrameBlock(BlockReader, Block, Options) || Block.ComponentTracks.Num() > ActorData.ComponentTracks.Num())
+			{
+				return false;
+			}
+			ActorData.RecordedFrames.Append(MoveTemp(Block.RecordedFrames));
+		}
+
+		BloodStainRecordDataUtils::NormalizeFrameLayout(ActorData);
+		return true;
+	}
+
+	/** Decodes a SectionTable payload, the actor sections in parallel */
+	bool DecodeSections(const TArray<uint8>& Payload, const FBloodStainFileHeader& FileHeader, FRecordSaveData& OutData)
+	{
+		TArray<FBloodStainFileSection> Sections;
+		FMemoryReader TableReader(Payload, true);
+		if (!ReadSectionTable(TableReader, Payload.Num(), Sections))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Corrupted section table"));
+			return false;
+		}
+
+		const FBloodStainFileSection* MetadataSection = Sections.FindByPredicate([](const FBloodStainFileSection& Section) { return Section.Type == EBloodStainFileSection::Metadata; });
+		TArray<uint8> MetadataBytes;
+		if (MetadataSection == nullptr || !DecodeSection(Payload, *MetadataSection, MetadataBytes) || !DecodeMetadata(MetadataBytes, FileHeader.Version, OutData))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Missing or corrupted metadata section"));
+			return false;
+		}
+
+		TArray<const FBloodStainFileSection*> FrameSections;
+		FrameSections.Init(nullptr, OutData.RecordActorDataArray.Num());
+		for (const FBloodStainFileSection& Section : Sections)
+		{
+			const bool bFrameSection = Section.Type == EBloodStainFileSection::ActorFrames || Section.Type == EBloodStainFileSection::ActorFrameBlocks;
+			if (bFrameSection && FrameSections.IsValidIndex(Section.ActorIndex))
+			{
+				FrameSections[Section.ActorIndex] = &Section;
+			}
+		}
+
+		TArray<bool> Decoded;
+		Decoded.Init(false, FrameSections.Num());
+		ParallelFor(FrameSections.Num(), [&](int32 ActorIndex)
+		{
+			TArray<uint8> RawBytes;
+			if (FrameSections[ActorIndex] != nullptr && DecodeSection(Payload, *FrameSections[ActorIndex], RawBytes))
+			{
+				if (FrameSections[ActorIndex]->Type == EBloodStainFileSection::ActorFrameBlocks)
+				{
+					Decoded[ActorIndex] = DecodeFrameBlocks(RawBytes, OutData.RecordActorDataArray[ActorIndex], FileHeader.Options);
+				}
+				else
+				{
+					FMemoryReader FramesReader(RawBytes, true);
+					Decoded[ActorIndex] = DeserializeActorFrames(FramesReader, OutData.RecordActorDataArray[ActorIndex], FileHeader.Options);
+				}
+			}
+		});
+
+		const int32 FailedActor = Decoded.Find(false);
+		if (FailedActor != INDEX_NONE)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] Missing or corrupted frame section (actor %d)"), FailedActor);
+			return false;
+		}
+		return true;
+	}
+
+	/** Decompresses the single-blob payload of the versions before SectionTable */
+	bool DecodeBlob(const TArray<uint8>& Payload, const FBloodStainFileHeader& FileHeader, FRecordSaveData& OutData)
+	{
+		TArray<uint8> RawBytes;
+		if (!BloodStainCompressionUtils::DecompressBuffer(FileHeader.UncompressedSize, Payload, RawBytes, FileHeader.Options.CompressionOption))
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] DecompressBuffer failed"));
+			return false;
+		}
+
+		FMemoryReader MemoryReader(RawBytes, true);
+		return DeserializeSaveData(MemoryReader, OutData, FileHeader);
+	}
 }
 
 bool BloodStainFileUtils::SaveToFile(
@@ -62,61 +422,47 @@ bool BloodStainFileUtils::SaveToFile(
     const FString&               FileName,
     const FBloodStainFileOptions& Options)
 {
+	// Quantization ranges are computed into the data being saved
     FRecordSaveData LocalCopy = SaveData;
-	FBloodStainFileOptions LocalOptions = Options;
-	FBufferArchive BufferAr;
-
-	BloodStainFileUtils_Internal::SerializeSaveData(BufferAr, LocalCopy,LocalOptions.QuantizationOption);
+	return SaveToFile(MoveTemp(LocalCopy), LevelName, FileName, Options);
+}
 
-    TArray<uint8> RawBytes;
-    RawBytes.Append(BufferAr.GetData(), BufferAr.Num());
-	
-    TArray<uint8> Payload;
-    if (Options.CompressionOption == ECompressionMethod::None)
-    {
-        Payload = MoveTemp(RawBytes);
-    }
-    else
-    {
-        if (!BloodStainCompressionUtils::CompressBuffer(RawBytes, Payload, Options.CompressionOption))
-        {
-            UE_LOG(LogBloodStain, Error, TEXT("[BS] CompressBuffer failed"));
-            return false;
-        }
-    }
+bool BloodStainFileUtils::SaveToFile(
+    FRecordSaveData&&            SaveData,
+    const FString&               LevelName,
+    const FString&               FileName,
+    const FBloodStainFileOptions& Options)
+{
+	TArray<FBloodStainFileSection> Sections;
+	TArray<TArray<uint8>> SectionData;
+	BloodStainFileUtils_Internal::EncodeSections(SaveData, Options, Sections, SectionData);
 
     FBloodStainFileHeader FileHeader;
     FileHeader.Options          = Options;
-    FileHeader.UncompressedSize = RawBytes.Num();
+    for (const FBloodStainFileSection& Section : Sections)
+    {
+        FileHeader.UncompressedSize += Section.UncompressedSize;
+    }
 
     FBufferArchive FileAr;
-
-	FileAr.SetIsSaving(true);
-
-	int64 StartPos = FileAr.Tell();
-	int32 HeaderByteSize = 0;
-	FileAr << HeaderByteSize;
-	
-    FileAr << FileHeader;
-	FileAr << LocalCopy.Header;
-
-	int64 EndPos = FileAr.Tell();
-	HeaderByteSize = static_cast<int32>(EndPos - StartPos);
-
-	FileAr.Seek(StartPos);
-	FileAr << HeaderByteSize;
-
-	FileAr.Seek(EndPos);
-
-    FileAr.Serialize(Payload.GetData(), Payload.Num());
+	BloodStainFileUtils_Internal::SerializeFileHeaders(FileAr, FileHeader, SaveData.Header, Sections);
 
     const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
 
 	const FString SaveDir = BloodStainFileUtils_Internal::GetSaveDirectory(LevelName);
 	IFileManager::Get().MakeDirectory(*SaveDir, /*Tree*/true);
-	
-    bool bOK = FFileHelper::SaveArrayToFile(FileAr, *Path);
-    FileAr.FlushCache(); FileAr.Empty();
+
+	// Headers, section table and sections are streamed to the file, the payload is never copied into a file-sized buffer
+    bool bOK = false;
+    if (const TUniquePtr<FArchive> FileWriter = TUniquePtr<FArchive>(IFileManager::Get().CreateFileWriter(*Path)))
+    {
+        FileWriter->Serialize(FileAr.GetData(), FileAr.Num());
+        for (TArray<uint8>& Data : SectionData)
+        {
+            FileWriter->Serialize(Data.GetData(), Data.Num());
+        }
+        bOK = FileWriter->Close();
+    }
 
     if (!bOK)
     {
@@ -131,11 +477,7 @@ bool BloodStainFileUtils::SaveToFile(
             ? RecordActorData.RecordedFrames.Last().TimeStamp - RecordActorData.RecordedFrames[0].TimeStamp 
             : 0.0f;
 
-        int32 BoneCount = 0;
-        if (NumFrames > 0)
-        {
-            BoneCount = RecordActorData.RecordedFrames[0].RelativeTransforms.Num();
-        }
+        const int32 BoneCount = RecordActorData.ComponentTracks.Num();
 
         UE_LOG(LogBloodStain, Log, TEXT("[BloodStain] Saved recording to %s"), *Path);
         UE_LOG(LogBloodStain, Log, TEXT("[BloodStain] ▶ Duration: %.2f sec | Frames: %d | Sockets: %d"), 
@@ -145,6 +487,97 @@ bool BloodStainFileUtils::SaveToFile(
     return bOK;
 }
 
+bool BloodStainFileUtils::SaveFrameBlocksToFile(FRecordSaveData& SaveData, TArray<FBloodStainActorIndexEntry>& IndexEntries,
+	const TFunctionRef<bool(int32 ActorIndex, FArchive& FileWriter)>& WriteActorBlocks,
+	const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options)
+{
+	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
+	IFileManager::Get().MakeDirectory(*BloodStainFileUtils_Internal::GetSaveDirectory(LevelName), /*Tree*/true);
+
+	const TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*Path));
+	if (!FileWriter)
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] SaveFrameBlocksToFile failed: %s"), *Path);
+		return false;
+	}
+
+	// Frame sections of every actor, then the index and the metadata
+	const int32 NumActors = SaveData.RecordActorDataArray.Num();
+	TArray<FBloodStainFileSection> Sections;
+	Sections.SetNum(NumActors + 2);
+
+	// The headers and the section table are written again once every section is known, their size does not change
+	FBloodStainFileHeader FileHeader;
+	FileHeader.Options = Options;
+	FBufferArchive HeadersAr;
+	const int64 PayloadStart = BloodStainFileUtils_Internal::SerializeFileHeaders(HeadersAr, FileHeader, SaveData.Header, Sections);
+	FileWriter->Serialize(HeadersAr.GetData(), HeadersAr.Num());
+	Sections.Reset();
+
+	bool bOK = !FileWriter->IsError() && IndexEntries.Num() == NumActors;
+	for (int32 ActorIndex = 0; ActorIndex < NumActors && bOK; ++ActorIndex)
+	{
+		// The blocks are already compressed one by one, the section is not compressed again
+		const int64 SectionStart = FileWriter->Tell();
+		if (!WriteActorBlocks(ActorIndex, *FileWriter) || FileWriter->IsError())
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BS] SaveFrameBlocksToFile failed to write the blocks of actor %d: %s"), ActorIndex, *Path);
+			bOK = false;
+			break;
+		}
+
+		FBloodStainFileSection& Section = Sections.AddDefaulted_GetRef();
+		Section.Type = EBloodStainFileSection::ActorFrameBlocks;
+		Section.ActorIndex = ActorIndex;
+		Section.Offset = SectionStart - PayloadStart;
+		Section.Size = FileWriter->Tell() - SectionStart;
+		Section.UncompressedSize = Section.Size;
+
+		const FBloodStainActorIndexEntry& Entry = IndexEntries[ActorIndex];
+		UE_LOG(LogBloodStain, Log, TEXT("[BloodStain] ▶ Duration: %.2f sec | Frames: %d | Sockets: %d"),
+			Entry.EndTime - Entry.StartTime, Entry.NumFrames, SaveData.RecordActorDataArray[ActorIndex].ComponentTracks.Num());
+	}
+
+	if (bOK)
+	{
+		FBufferArchive IndexAr;
+		BloodStainFileUtils_Internal::SerializeIndexSection(IndexAr, IndexEntries);
+		FBufferArchive MetadataAr;
+		BloodStainFileUtils_Internal::SerializeMetadataSection(MetadataAr, SaveData.RecordActorDataArray);
+
+		bOK = BloodStainFileUtils_Internal::WriteSection(*FileWriter, PayloadStart, Sections, EBloodStainFileSection::Index, INDEX_NONE, MoveTemp(IndexAr), ECompressionMethod::None)
+			&& BloodStainFileUtils_Internal::WriteSection(*FileWriter, PayloadStart, Sections, EBloodStainFileSection::Metadata, INDEX_NONE, MoveTemp(MetadataAr), Options.CompressionOption);
+	}
+
+	if (bOK)
+	{
+		for (const FBloodStainFileSection& Section : Sections)
+		{
+			FileHeader.UncompressedSize += Section.UncompressedSize;
+		}
+
+		FBufferArchive FinalHeadersAr;
+		BloodStainFileUtils_Internal::SerializeFileHeaders(FinalHeadersAr, FileHeader, SaveData.Header, Sections);
+		bOK = FinalHeadersAr.Num() == HeadersAr.Num();
+		if (bOK)
+		{
+			FileWriter->Seek(0);
+			FileWriter->Serialize(FinalHeadersAr.GetData(), FinalHeadersAr.Num());
+		}
+	}
+
+	bOK = FileWriter->Close() && bOK;
+	if (!bOK)
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] SaveFrameBlocksToFile failed: %s"), *Path);
+		IFileManager::Get().Delete(*Path);
+		return false;
+	}
+
+	UE_LOG(LogBloodStain, Log, TEXT("[BloodStain] Saved recording to %s"), *Path);
+	return true;
+}
+
 bool BloodStainFileUtils::LoadFromFile(const FString& FileName, const FString& LevelName, FRecordSaveData& OutData)
 {
 	const FString RelativeFilePath = GetRelativeFilePath(FileName, LevelName);
@@ -170,6 +603,10 @@ bool BloodStainFileUtils::LoadFromFile(const FString& RelativeFilePath, FRecordS
 	
 	MemR << HeaderByteSize;
 	MemR << FileHeader;
+	if (!BloodStainFileUtils_Internal::CheckFileHeader(FileHeader, Path))
+	{
+		return false;
+	}
 	MemR << OutData.Header;
 	
 	FString FileNameWithoutExtension = FPaths::GetBaseFilename(RelativeFilePath);
@@ -183,23 +620,75 @@ bool BloodStainFileUtils::LoadFromFile(const FString& RelativeFilePath, FRecordS
 	Compressed.SetNumUninitialized(Remain);
 	FMemory::Memcpy(Compressed.GetData(), Ptr, Remain);
 
-	TArray<uint8> RawBytes;
-	if (FileHeader.Options.CompressionOption == ECompressionMethod::None)
+	if (!DecodePayload(Compressed, FileHeader, OutData))
 	{
-		RawBytes = MoveTemp(Compressed);
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadFromFile failed to deserialize: %s"), *Path);
+		return false;
 	}
-	else
+	return true;
+}
+
+bool BloodStainFileUtils::LoadBodyFromFile(const FString& FileName, const FString& LevelName, FRecordSaveData& OutData)
+{
+	FBloodStainFileHeader FileHeader;
+	TArray<uint8> Payload;
+	if (!LoadPayloadFromFile(FileName, LevelName, FileHeader, Payload))
 	{
-		if (!BloodStainCompressionUtils::DecompressBuffer(FileHeader.UncompressedSize, Compressed, RawBytes, FileHeader.Options.CompressionOption))
-		{
-			UE_LOG(LogBloodStain, Error, TEXT("[BS] DecompressBuffer failed"));
-			return false;
-		}
+		return false;
 	}
 
-	FMemoryReader MemoryReader(RawBytes, true);
-	BloodStainFileUtils_Internal::DeserializeSaveData(MemoryReader,OutData,FileHeader.Options.QuantizationOption);
-	
+	if (!DecodePayload(Payload, FileHeader, OutData))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadBodyFromFile failed to deserialize: %s"), *BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName));
+		return false;
+	}
+	return true;
+}
+
+bool BloodStainFileUtils::DecodePayload(const TArray<uint8>& Payload, const FBloodStainFileHeader& FileHeader, FRecordSaveData& OutData)
+{
+	if (!FileHeader.IsValid())
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] Not a BloodStain file or unsupported version %u"), FileHeader.Version);
+		return false;
+	}
+
+	if (FileHeader.Version < EBloodStainFileVersion::SectionTable)
+	{
+		return BloodStainFileUtils_Internal::DecodeBlob(Payload, FileHeader, OutData);
+	}
+	return BloodStainFileUtils_Internal::DecodeSections(Payload, FileHeader, OutData);
+}
+
+bool BloodStainFileUtils::LoadPayloadFromFile(const FString& FileName, const FString& LevelName, FBloodStainFileHeader& OutFileHeader, TArray<uint8>& OutPayload)
+{
+	const FString Path = BloodStainFileUtils_Internal::GetFullFilePath(FileName, LevelName);
+	TArray<uint8> AllBytes;
+	if (!FFileHelper::LoadFileToArray(AllBytes, *Path))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadPayloadFromFile failed read: %s"), *Path);
+		return false;
+	}
+
+	int32 HeaderByteSize = 0;
+	FMemoryReader MemR(AllBytes, true);
+	MemR << HeaderByteSize;
+	MemR << OutFileHeader;
+	if (!BloodStainFileUtils_Internal::CheckFileHeader(OutFileHeader, Path))
+	{
+		return false;
+	}
+
+	// HeaderByteSize covers the record header as well, which is skipped
+	if (MemR.IsError() || HeaderByteSize < MemR.Tell() || HeaderByteSize > AllBytes.Num())
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] LoadPayloadFromFile invalid header size %d: %s"), HeaderByteSize, *Path);
+		return false;
+	}
+
+	const int32 PayloadSize = AllBytes.Num() - HeaderByteSize;
+	OutPayload.SetNumUninitialized(PayloadSize);
+	FMemory::Memcpy(OutPayload.GetData(), AllBytes.GetData() + HeaderByteSize, PayloadSize);
 	return true;
 }
 
@@ -221,6 +710,10 @@ bool BloodStainFileUtils::LoadRawPayloadFromFile(const FString& FileName, const
 	// Only Deserialize the file header and record header
 	MemR << HeaderByteSize;
 	MemR << OutFileHeader;
+	if (!BloodStainFileUtils_Internal::CheckFileHeader(OutFileHeader, Path))
+	{
+		return false;
+	}
 	MemR << OutRecordHeader;
 	OutRecordHeader.FileName = FName(FileName);
 	
@@ -300,6 +793,10 @@ bool BloodStainFileUtils::LoadHeaderFromFile(const FString& RelativeFilePath, FR
 	FMemoryReader MemR(HeaderBytes, true);
 	FBloodStainFileHeader FileHeader;
 	MemR << FileHeader;
+	if (!BloodStainFileUtils_Internal::CheckFileHeader(FileHeader, Path))
+	{
+		return false;
+	}
 	MemR << OutRecordHeaderData;
 	
 	FString FileNameWithoutExtension = FPaths::GetBaseFilename(RelativeFilePath);
@@ -600,6 +1097,11 @@ FString BloodStainFileUtils::GetRelativeFilePath(const FString& FileName, const
 	return LevelName/FileName;
 }
 
+FString BloodStainFileUtils::GetStreamFilePath(const FString& StreamName)
+{
+	return FPaths::ProjectSavedDir() / (GetPluginSavedDir() + TEXT("Streams")) / (StreamName + TEXT(".stream"));
+}
+
 const FString& BloodStainFileUtils::GetPluginSavedDir()
 {
 	return BloodStainFileUtils_Internal::GetPluginSavedDir();
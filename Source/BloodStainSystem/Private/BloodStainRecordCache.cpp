@@ -0,0 +1,156 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainRecordCache.h"
+#include "BloodStainSystem.h"
+#include "GhostData.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("RecordCache Trim"), STAT_RecordCache_Trim, STATGROUP_BloodStain);
+DECLARE_MEMORY_STAT(TEXT("RecordCache Size"), STAT_RecordCache_Bytes, STATGROUP_BloodStain);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RecordCache Entries"), STAT_RecordCache_Entries, STATGROUP_BloodStain);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RecordCache Hits"), STAT_RecordCache_Hits, STATGROUP_BloodStain);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RecordCache Misses"), STAT_RecordCache_Misses, STATGROUP_BloodStain);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RecordCache Evictions"), STAT_RecordCache_Evictions, STATGROUP_BloodStain);
+
+static TAutoConsoleVariable<int32> CVarRecordCacheBodyBudgetMB(
+	TEXT("BloodStain.Cache.BodyBudgetMB"),
+	256,
+	TEXT("Memory budget (MB) of the loaded replay body cache. Least recently used replays not being played are evicted above it.\n")
+	TEXT("0 disables the budget."),
+	ECVF_Default);
+
+FBloodStainRecordCache::~FBloodStainRecordCache()
+{
+	Empty();
+}
+
+TSharedPtr<const FRecordSaveData> FBloodStainRecordCache::Find(const FString& Key, const FDateTime& Timestamp)
+{
+	if (FCachedRecordData* Entry = Entries.Find(Key))
+	{
+		if (Entry->Timestamp == Timestamp)
+		{
+			Entry->LastAccess = ++AccessCounter;
+			++NumHits;
+			INC_DWORD_STAT(STAT_RecordCache_Hits);
+			return Entry->RecordData;
+		}
+
+		UE_LOG(LogBloodStain, Warning, TEXT("Stale cache detected for %s. Removing old entry and reloading."), *Key);
+		Remove(Key);
+	}
+
+	++NumMisses;
+	INC_DWORD_STAT(STAT_RecordCache_Misses);
+	return nullptr;
+}
+
+void FBloodStainRecordCache::Add(const FString& Key, const TSharedRef<const FRecordSaveData>& Data, const FDateTime& Timestamp)
+{
+	Remove(Key);
+
+	FCachedRecordData& Entry = Entries.Add(Key);
+	Entry.RecordData = Data;
+	Entry.Timestamp = Timestamp;
+	Entry.NumBytes = GetAllocatedSize(*Data);
+	Entry.LastAccess = ++AccessCounter;
+
+	NumBytes += Entry.NumBytes;
+	INC_MEMORY_STAT_BY(STAT_RecordCache_Bytes, Entry.NumBytes);
+	INC_DWORD_STAT(STAT_RecordCache_Entries);
+
+	Trim();
+}
+
+void FBloodStainRecordCache::Remove(const FString& Key)
+{
+	if (const FCachedRecordData* Entry = Entries.Find(Key))
+	{
+		RemoveEntry(Key, Entry->NumBytes);
+	}
+}
+
+void FBloodStainRecordCache::Empty()
+{
+	DEC_MEMORY_STAT_BY(STAT_RecordCache_Bytes, NumBytes);
+	DEC_DWORD_STAT_BY(STAT_RecordCache_Entries, Entries.Num());
+	Entries.Empty();
+	NumBytes = 0;
+}
+
+void FBloodStainRecordCache::Trim()
+{
+	SCOPE_CYCLE_COUNTER(STAT_RecordCache_Trim);
+
+	const int64 BudgetBytes = static_cast<int64>(FMath::Max(CVarRecordCacheBodyBudgetMB.GetValueOnGameThread(), 0)) * 1024 * 1024;
+	if (BudgetBytes == 0 || NumBytes <= BudgetBytes)
+	{
+		return;
+	}
+
+	TArray<TPair<uint64, FString>> Candidates;
+	for (const auto& [Key, Entry] : Entries)
+	{
+		if (!Entry.IsPinned())
+		{
+			Candidates.Emplace(Entry.LastAccess, Key);
+		}
+	}
+	Candidates.Sort([](const TPair<uint64, FString>& A, const TPair<uint64, FString>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	for (const TPair<uint64, FString>& Candidate : Candidates)
+	{
+		if (NumBytes <= BudgetBytes)
+		{
+			break;
+		}
+
+		const FString& Key = Candidate.Value;
+		const int64 EntryBytes = Entries[Key].NumBytes;
+		RemoveEntry(Key, EntryBytes);
+
+		++NumEvictions;
+		INC_DWORD_STAT(STAT_RecordCache_Evictions);
+		UE_LOG(LogBloodStain, Verbose, TEXT("[RecordCache] Evicted %s (%lld bytes), %lld bytes cached"), *Key, EntryBytes, NumBytes);
+		OnEvicted.ExecuteIfBound(Key, EntryBytes);
+	}
+
+	if (NumBytes > BudgetBytes)
+	{
+		UE_LOG(LogBloodStain, Verbose, TEXT("[RecordCache] %lld bytes cached over a budget of %lld bytes, the remaining replays are being played"), NumBytes, BudgetBytes);
+	}
+}
+
+int64 FBloodStainRecordCache::GetAllocatedSize(const FRecordSaveData& Data)
+{
+	int64 Size = sizeof(FRecordSaveData) + Data.RecordActorDataArray.GetAllocatedSize();
+	for (const FRecordActorSaveData& ActorData : Data.RecordActorDataArray)
+	{
+		Size += ActorData.ComponentIntervals.GetAllocatedSize();
+		Size += ActorData.ComponentTracks.GetAllocatedSize();
+		Size += ActorData.BoneRanges.GetAllocatedSize();
+		Size += ActorData.BoneScaleRanges.GetAllocatedSize();
+		Size += ActorData.RecordedFrames.GetAllocatedSize();
+		for (const FRecordFrame& Frame : ActorData.RecordedFrames)
+		{
+			Size += Frame.ComponentTransforms.GetAllocatedSize();
+			Size += Frame.BoneTransforms.GetAllocatedSize();
+			Size += Frame.RecordedTracks.GetAllocatedSize();
+		}
+	}
+	return Size;
+}
+
+void FBloodStainRecordCache::RemoveEntry(const FString& Key, int64 EntryBytes)
+{
+	NumBytes -= EntryBytes;
+	DEC_MEMORY_STAT_BY(STAT_RecordCache_Bytes, EntryBytes);
+	DEC_DWORD_STAT(STAT_RecordCache_Entries);
+	Entries.Remove(Key);
+}
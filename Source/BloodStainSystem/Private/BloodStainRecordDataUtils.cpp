@@ -6,57 +6,81 @@
 #include "BloodStainRecordDataUtils.h"
 #include "BloodStainSystem.h"
 #include "GhostData.h"
+#include "RecordFrameSlab.h"
 
 namespace BloodStainRecordDataUtils
 {
-	bool CookQueuedFrames(float SamplingInterval, const float& ClipStartTime, TCircularQueue<FRecordFrame>* FrameQueuePtr, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals)
+	bool CookQueuedFrames(float SamplingInterval, const float& ClipStartTime, FRecordFrameSlab* FrameSlabPtr, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals)
 	{
-		FRecordFrame First;
-		if (!FrameQueuePtr->Peek(First))
+		if (FrameSlabPtr->IsEmpty())
 		{
 			UE_LOG(LogBloodStain, Warning, TEXT("No frames to save"));
 			return false;
 		}
 
-		int32 FirstIndex = -1;
+		TArray<FRecordFrame> RawFrames;
+		CopyQueuedFrames(*FrameSlabPtr, ClipStartTime, RawFrames);
+		FrameSlabPtr->Reset();
+		
+		return CookFrames(MoveTemp(RawFrames), OutGhostSaveData, OutComponentIntervals);
+	}
 
+	void CopyQueuedFrames(const FRecordFrameSlab& FrameSlab, float ClipStartTime, TArray<FRecordFrame>& OutFrames)
+	{
 		// Copy original frame datas and do normalize timestamps [0, duration)
-		TArray<FRecordFrame> RawFrames;
-		FRecordFrame Tmp;
-		while (FrameQueuePtr->Dequeue(Tmp))
+		OutFrames.Reserve(FrameSlab.Num());
+		for (int32 Index = 0; Index < FrameSlab.Num(); ++Index)
 		{
-			Tmp.TimeStamp -= ClipStartTime;
-			if (Tmp.TimeStamp < 0)
+			if (FrameSlab.GetTimeStamp(Index) - ClipStartTime < 0)
 			{
 				continue;
 			}
 
-			if (RawFrames.Num() == 0)
-			{
-				FirstIndex = Tmp.FrameIndex;
-			}
-			
-			RawFrames.Add(MoveTemp(Tmp));
+			FRecordFrame& Frame = OutFrames.AddDefaulted_GetRef();
+			FrameSlab.CopyFrame(Index, Frame);
+			Frame.TimeStamp -= ClipStartTime;
+		}
+	}
+
+	bool CookDetachedRecord(float SamplingInterval, float ClipStartTime, FDetachedRecordData& InOutRecord)
+	{
+		if (!InOutRecord.FrameSlabPtr.IsValid())
+		{
+			// Snapshot : the frames were copied out of the slab when it was taken
+			TArray<FRecordFrame> RawFrames = MoveTemp(InOutRecord.GhostSaveData.RecordedFrames);
+			InOutRecord.GhostSaveData.RecordedFrames.Reset();
+			return CookFrames(MoveTemp(RawFrames), InOutRecord.GhostSaveData, InOutRecord.ComponentIntervals);
 		}
 		
+		const bool bCooked = CookQueuedFrames(SamplingInterval, ClipStartTime, InOutRecord.FrameSlabPtr.Get(), InOutRecord.GhostSaveData, InOutRecord.ComponentIntervals);
+		InOutRecord.FrameSlabPtr.Reset();
+		return bCooked;
+	}
+
+	bool CookFrames(TArray<FRecordFrame>&& RawFrames, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals)
+	{
 		if (RawFrames.Num() < 2)
 		{
 			UE_LOG(LogBloodStain, Warning, TEXT("Not enough raw frames to interpolate."));
 			return false;
 		}
 		
-		OutGhostSaveData.RecordedFrames = RawFrames;
+		const int32 FirstIndex = RawFrames[0].FrameIndex;
+		OutGhostSaveData.RecordedFrames = MoveTemp(RawFrames);
+		NormalizeFrameLayout(OutGhostSaveData);
 		
 		/* Construct Initial Component Structure based on Total Component event Data */
-		BuildInitialComponentStructure(FirstIndex, OutGhostSaveData, OutComponentIntervals);
+		BuildInitialComponentStructure(FirstIndex, OutGhostSaveData.RecordedFrames.Num(), OutGhostSaveData, OutComponentIntervals);
+		RestoreIntervalBoundaryKeys(OutGhostSaveData);
+
+		// Only once the boundary keys are restored : a track reduced to a single key inside the clip window may still move
+		DetectStaticTracks(OutGhostSaveData);
 	
 		return true;
 	}
 
-	void BuildInitialComponentStructure(int32 FirstFrameIndex, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals)
+	void BuildInitialComponentStructure(int32 FirstFrameIndex, int32 NumSavedFrames, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals)
 	{
-		int32 NumSavedFrames = OutGhostSaveData.RecordedFrames.Num();
-
 		// StartIdx : first index where EndFrame > FirstFrameIndex 
 		const int32 StartIdx = Algo::UpperBoundBy(OutComponentIntervals, FirstFrameIndex, &FComponentActiveInterval::EndFrame);
 
@@ -81,6 +105,88 @@ namespace BloodStainRecordDataUtils
 		}
 	}
 
+	void NormalizeFrameLayout(FRecordActorSaveData& InOutSaveData)
+	{
+		const int32 NumTracks = InOutSaveData.ComponentTracks.Num();
+		const int32 NumTrackBones = InOutSaveData.GetNumTrackBones();
+
+		for (FRecordFrame& Frame : InOutSaveData.RecordedFrames)
+		{
+			Frame.ComponentTransforms.SetNum(NumTracks);
+			Frame.BoneTransforms.SetNum(NumTrackBones);
+			Frame.RecordedTracks.SetNum(NumTracks, false);
+		}
+	}
+
+	void DetectStaticTracks(FRecordActorSaveData& InOutSaveData)
+	{
+		const TArray<FRecordFrame>& Frames = InOutSaveData.RecordedFrames;
+		int32 NumStaticBones = 0;
+		
+		for (int32 TrackIndex = 0; TrackIndex < InOutSaveData.ComponentTracks.Num(); ++TrackIndex)
+		{
+			FRecordComponentTrack& Track = InOutSaveData.ComponentTracks[TrackIndex];
+			Track.bStaticTransform = false;
+			Track.StaticBones.Init(false, Track.NumBones);
+
+			const int32 FirstKeyFrame = Frames.IndexOfByPredicate([TrackIndex](const FRecordFrame& Frame) { return Frame.HasTrack(TrackIndex); });
+			if (FirstKeyFrame == INDEX_NONE)
+			{
+				continue;
+			}
+			
+			// Every track and bone starts as static and is cleared by the first sample that differs
+			const FRecordFrame& First = Frames[FirstKeyFrame];
+			Track.bStaticTransform = true;
+			Track.StaticBones.SetRange(0, Track.NumBones, true);
+			
+			for (int32 FrameIndex = FirstKeyFrame + 1; FrameIndex < Frames.Num(); ++FrameIndex)
+			{
+				const FRecordFrame& Frame = Frames[FrameIndex];
+				if (!Frame.HasTrack(TrackIndex))
+				{
+					continue;
+				}
+
+				if (Track.bStaticTransform && !Frame.ComponentTransforms[TrackIndex].Equals(First.ComponentTransforms[TrackIndex], UE_KINDA_SMALL_NUMBER))
+				{
+					Track.bStaticTransform = false;
+				}
+
+				for (TConstSetBitIterator<> It(Track.StaticBones); It; ++It)
+				{
+					const int32 BoneIndex = Track.BoneOffset + It.GetIndex();
+					if (!Frame.BoneTransforms[BoneIndex].Equals(First.BoneTransforms[BoneIndex], UE_KINDA_SMALL_NUMBER))
+					{
+						Track.StaticBones[It.GetIndex()] = false;
+					}
+				}
+			}
+
+			NumStaticBones += Track.StaticBones.CountSetBits();
+		}
+
+		UE_LOG(LogBloodStain, Verbose, TEXT("DetectStaticTracks: %d static bones out of %d"), NumStaticBones, InOutSaveData.GetNumTrackBones());
+	}
+
+	void RestoreIntervalBoundaryKeys(FRecordActorSaveData& InOutSaveData)
+	{
+		const int32 NumFrames = InOutSaveData.RecordedFrames.Num();
+		for (const FComponentActiveInterval& Interval : InOutSaveData.ComponentIntervals)
+		{
+			const int32 ComponentId = Interval.Meta.ComponentId;
+			const int32 FirstFrame = FMath::Max(Interval.StartFrame, 0);
+			const int32 LastFrame = FMath::Min(Interval.EndFrame, NumFrames) - 1;
+			if (!InOutSaveData.ComponentTracks.IsValidIndex(ComponentId) || FirstFrame > LastFrame)
+			{
+				continue;
+			}
+			
+			InOutSaveData.RecordedFrames[FirstFrame].RecordedTracks[ComponentId] = true;
+			InOutSaveData.RecordedFrames[LastFrame].RecordedTracks[ComponentId] = true;
+		}
+	}
+
 	void ClipActorSaveDataByGroup(TArray<FRecordActorSaveData>& Actors, float MaxGroupRecordTime, float SamplingInterval)
 	{
 		if (Actors.Num() == 0)
@@ -209,6 +315,8 @@ namespace BloodStainRecordDataUtils
 			}
 
 			Actor.ComponentIntervals = MoveTemp(NewIntervals);
+			RestoreIntervalBoundaryKeys(Actor);
+			DetectStaticTracks(Actor);
 			
 		}
 	}
@@ -0,0 +1,141 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainRecordSampler.h"
+#include "BloodStainSubsystem.h"
+#include "BloodStainSystem.h"
+#include "RecordComponent.h"
+#include "Async/ParallelFor.h"
+#include "Engine/GameInstance.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("RecordSampler Tick"), STAT_RecordSampler_Tick, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("RecordSampler CaptureSamples"), STAT_RecordSampler_CaptureSamples, STATGROUP_BloodStain);
+DECLARE_DWORD_COUNTER_STAT(TEXT("RecordSampler Samples"), STAT_RecordSampler_Samples, STATGROUP_BloodStain);
+DECLARE_DWORD_COUNTER_STAT(TEXT("RecordSampler DeferredSamples"), STAT_RecordSampler_DeferredSamples, STATGROUP_BloodStain);
+DECLARE_DWORD_COUNTER_STAT(TEXT("RecordSampler BudgetOverruns"), STAT_RecordSampler_BudgetOverruns, STATGROUP_BloodStain);
+
+static TAutoConsoleVariable<float> CVarRecordFrameBudgetMs(
+	TEXT("BloodStain.Record.FrameBudgetMs"),
+	1.0f,
+	TEXT("Game thread time (ms) the recorders may spend sampling per frame. Samples over budget are deferred to the next frame.\n")
+	TEXT("At least one sample is taken per frame. 0 disables the budget."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarRecordStaggerSamplePhases(
+	TEXT("BloodStain.Record.StaggerSamplePhases"),
+	true,
+	TEXT("If true, recorders started together are given different sampling phases so they do not all sample on the same frame."),
+	ECVF_Default);
+
+void UBloodStainRecordSampler::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RecordSampler_Tick);
+
+	const UBloodStainSubsystem* Subsystem = Cast<UBloodStainSubsystem>(GetOuter());
+	if (Subsystem == nullptr)
+	{
+		return;
+	}
+
+	const double TickStartSeconds = FPlatformTime::Seconds();
+	const double BudgetSeconds = FMath::Max(CVarRecordFrameBudgetMs.GetValueOnGameThread(), 0.f) * 0.001;
+
+	ActiveRecorders.Reset();
+	Subsystem->GetActiveRecorders(ActiveRecorders);
+
+	const int32 NumRecorders = ActiveRecorders.Num();
+	const int32 StartIndex = NumRecorders > 0 ? FirstRecorderIndex % NumRecorders : 0;
+	int32 FirstDeferredIndex = INDEX_NONE;
+	int32 NumDeferred = 0;
+	double EstimatedSeconds = 0.0;
+
+	DueRecorders.Reset();
+	for (int32 Offset = 0; Offset < NumRecorders; ++Offset)
+	{
+		const int32 RecorderIndex = (StartIndex + Offset) % NumRecorders;
+		URecordComponent* Recorder = ActiveRecorders[RecorderIndex];
+		if (!IsValid(Recorder) || !Recorder->AdvanceSampleClock(DeltaTime))
+		{
+			continue;
+		}
+
+		// The clock of a deferred recorder keeps running, it samples on a later frame with that frame's timestamp
+		if (BudgetSeconds > 0.0 && !DueRecorders.IsEmpty() && EstimatedSeconds + AverageSampleSeconds > BudgetSeconds)
+		{
+			if (FirstDeferredIndex == INDEX_NONE)
+			{
+				FirstDeferredIndex = RecorderIndex;
+			}
+			++NumDeferred;
+			continue;
+		}
+
+		Recorder->BeginSample();
+		if (Recorder->RecordOptions.bUseSignificanceSampling)
+		{
+			Recorder->SetSignificance(Subsystem->EvaluateRecordSignificance(Recorder));
+		}
+		DueRecorders.Add(Recorder);
+		EstimatedSeconds += AverageSampleSeconds;
+	}
+	FirstRecorderIndex = FirstDeferredIndex != INDEX_NONE ? FirstDeferredIndex : StartIndex;
+
+	SET_DWORD_STAT(STAT_RecordSampler_DeferredSamples, NumDeferred);
+	if (DueRecorders.IsEmpty())
+	{
+		return;
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_RecordSampler_CaptureSamples);
+		ParallelFor(DueRecorders.Num(), [this](int32 Index)
+		{
+			DueRecorders[Index]->CaptureSample();
+		});
+	}
+	SET_DWORD_STAT(STAT_RecordSampler_Samples, DueRecorders.Num());
+
+	const double ElapsedSeconds = FPlatformTime::Seconds() - TickStartSeconds;
+	const double SampleSeconds = ElapsedSeconds / DueRecorders.Num();
+	AverageSampleSeconds = AverageSampleSeconds > 0.0 ? FMath::Lerp(AverageSampleSeconds, SampleSeconds, 0.1) : SampleSeconds;
+
+	if (BudgetSeconds > 0.0 && ElapsedSeconds > BudgetSeconds)
+	{
+		++NumBudgetOverruns;
+		INC_DWORD_STAT(STAT_RecordSampler_BudgetOverruns);
+		UE_LOG(LogBloodStain, Verbose, TEXT("[RecordSampler] Sampling took %.3f ms for %d recorders (budget %.3f ms, %d deferred)"),
+			ElapsedSeconds * 1000.0, DueRecorders.Num(), BudgetSeconds * 1000.0, NumDeferred);
+	}
+}
+
+TStatId UBloodStainRecordSampler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBloodStainRecordSampler, STATGROUP_Tickables);
+}
+
+UWorld* UBloodStainRecordSampler::GetTickableGameObjectWorld() const
+{
+	const UBloodStainSubsystem* Subsystem = Cast<UBloodStainSubsystem>(GetOuter());
+	const UGameInstance* GameInstance = Subsystem ? Subsystem->GetGameInstance() : nullptr;
+	return GameInstance ? GameInstance->GetWorld() : nullptr;
+}
+
+bool UBloodStainRecordSampler::IsTickable() const
+{
+	const UBloodStainSubsystem* Subsystem = Cast<UBloodStainSubsystem>(GetOuter());
+	return Subsystem != nullptr && Subsystem->HasActiveRecordGroups();
+}
+
+float UBloodStainRecordSampler::AllocateSamplePhase()
+{
+	if (!CVarRecordStaggerSamplePhases.GetValueOnGameThread())
+	{
+		return 0.f;
+	}
+
+	// Golden ratio sequence : every new phase falls in the largest gap left by the previous ones
+	return FMath::Frac(static_cast<float>(NextPhaseIndex++) * 0.618034f);
+}
@@ -0,0 +1,261 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "BloodStainStreamWriter.h"
+#include "BloodStainCompressionUtils.h"
+#include "BloodStainRecordDataUtils.h"
+#include "BloodStainSystem.h"
+#include "GhostData.h"
+#include "QuantizationHelper.h"
+#include "RecordFrameSlab.h"
+#include "Algo/Count.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include "Serialization/BufferArchive.h"
+#include "Tasks/Task.h"
+
+DECLARE_CYCLE_STAT(TEXT("StreamWriter WriteBlock"), STAT_StreamWriter_WriteBlock, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("StreamWriter CopyActorBlocks"), STAT_StreamWriter_CopyActorBlocks, STATGROUP_BloodStain);
+
+FBloodStainStreamWriter::FBloodStainStreamWriter(const FString& InStreamFilePath, const FBloodStainFileOptions& InFileOptions)
+	: StreamFilePath(InStreamFilePath)
+	, FileOptions(InFileOptions)
+{
+}
+
+FBloodStainStreamWriter::~FBloodStainStreamWriter()
+{
+	FileHandle.Reset();
+}
+
+bool FBloodStainStreamWriter::Open()
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(StreamFilePath));
+
+	FileHandle.Reset(PlatformFile.OpenWrite(*StreamFilePath));
+	if (!FileHandle)
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[FBloodStainStreamWriter] Failed to open stream file: %s"), *StreamFilePath);
+		return false;
+	}
+	return true;
+}
+
+void FBloodStainStreamWriter::Submit(FStreamCommand&& Command)
+{
+	CommandQueue.Enqueue(MoveTemp(Command));
+	if (!bDrainScheduled.exchange(true))
+	{
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [Self = AsShared()]()
+		{
+			Self->Drain();
+		});
+	}
+}
+
+void FBloodStainStreamWriter::Drain()
+{
+	do
+	{
+		while (TOptional<FStreamCommand> Command = CommandQueue.Dequeue())
+		{
+			ProcessCommand(Command.GetValue());
+		}
+		bDrainScheduled.store(false);
+
+		// A command pushed after the last Dequeue but before the flag was cleared did not schedule a worker
+	}
+	while (!CommandQueue.IsEmpty() && !bDrainScheduled.exchange(true));
+}
+
+void FBloodStainStreamWriter::ProcessCommand(FStreamCommand& Command)
+{
+	switch (Command.Command)
+	{
+	case EStreamCommand::AppendBlock:
+		WriteBlock(Command);
+		break;
+		
+	case EStreamCommand::Finalize:
+		// The recording file copies the blocks from the closed stream
+		FileHandle.Reset();
+		Command.OnStreamClosed(!bWriteFailed, *this);
+		Blocks.Empty();
+		IFileManager::Get().Delete(*StreamFilePath);
+		break;
+		
+	case EStreamCommand::Discard:
+		FileHandle.Reset();
+		IFileManager::Get().Delete(*StreamFilePath);
+		break;
+	}
+}
+
+void FBloodStainStreamWriter::AppendBlock(int32 StreamActorIndex, int32 PrimaryComponentId, const TArray<FRecordComponentTrack>& ComponentTracks, TSharedPtr<FRecordFrameSlab>&& FrameSlab)
+{
+	FStreamCommand Command;
+	Command.Command = EStreamCommand::AppendBlock;
+	Command.StreamActorIndex = StreamActorIndex;
+	Command.PrimaryComponentId = PrimaryComponentId;
+	Command.ComponentTracks = ComponentTracks;
+	Command.FrameSlab = MoveTemp(FrameSlab);
+	Submit(MoveTemp(Command));
+}
+
+TSharedPtr<FRecordFrameSlab> FBloodStainStreamWriter::AcquireFrameSlab()
+{
+	TOptional<TSharedPtr<FRecordFrameSlab>> FrameSlab = FreeSlabs.Dequeue();
+	return FrameSlab.IsSet() ? MoveTemp(FrameSlab.GetValue()) : nullptr;
+}
+
+void FBloodStainStreamWriter::Finalize(TUniqueFunction<void(bool bSuccess, const FBloodStainStreamWriter& Stream)>&& OnStreamClosed)
+{
+	FStreamCommand Command;
+	Command.Command = EStreamCommand::Finalize;
+	Command.OnStreamClosed = MoveTemp(OnStreamClosed);
+	Submit(MoveTemp(Command));
+}
+
+void FBloodStainStreamWriter::Discard()
+{
+	FStreamCommand Command;
+	Command.Command = EStreamCommand::Discard;
+	Submit(MoveTemp(Command));
+}
+
+void FBloodStainStreamWriter::WriteBlock(FStreamCommand& Command)
+{
+	SCOPE_CYCLE_COUNTER(STAT_StreamWriter_WriteBlock);
+
+	FRecordActorSaveData Block;
+	Block.PrimaryComponentId = Command.PrimaryComponentId;
+	Block.ComponentTracks = MoveTemp(Command.ComponentTracks);
+
+	// The slab is unpacked here rather than on the game thread, then handed back for reuse
+	FRecordFrameSlab& FrameSlab = *Command.FrameSlab;
+	Block.RecordedFrames.SetNum(FrameSlab.Num());
+	for (int32 Index = 0; Index < FrameSlab.Num(); ++Index)
+	{
+		FrameSlab.CopyFrame(Index, Block.RecordedFrames[Index]);
+	}
+	FrameSlab.Reset();
+	FreeSlabs.Enqueue(MoveTemp(Command.FrameSlab));
+
+	if (bWriteFailed || !FileHandle || Block.RecordedFrames.IsEmpty())
+	{
+		return;
+	}
+
+	// A reused slab may be wider than the track table of this recorder
+	BloodStainRecordDataUtils::NormalizeFrameLayout(Block);
+
+	// Streams are never clipped and keyframe reduction keeps the boundary samples of a block, no key needs to be restored
+	BloodStainRecordDataUtils::DetectStaticTracks(Block);
+
+	FBufferArchive RawAr;
+	BloodStainFileUtils_Internal::SerializeFrameBlock(RawAr, Block, FileOptions);
+
+	int64 UncompressedSize = RawAr.Num();
+	TArray<uint8> Payload;
+	if (FileOptions.CompressionOption == ECompressionMethod::None)
+	{
+		Payload.Append(RawAr.GetData(), RawAr.Num());
+	}
+	else if (!BloodStainCompressionUtils::CompressBuffer(RawAr, Payload, FileOptions.CompressionOption))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[FBloodStainStreamWriter] CompressBuffer failed, stream %s is dropped"), *StreamFilePath);
+		bWriteFailed = true;
+		return;
+	}
+	int64 PayloadSize = Payload.Num();
+
+	FBufferArchive BlockHeaderAr;
+	BlockHeaderAr << UncompressedSize;
+	BlockHeaderAr << PayloadSize;
+
+	if (!FileHandle->Write(BlockHeaderAr.GetData(), BlockHeaderAr.Num()) || !FileHandle->Write(Payload.GetData(), Payload.Num()))
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[FBloodStainStreamWriter] Failed to write stream file: %s"), *StreamFilePath);
+		bWriteFailed = true;
+		return;
+	}
+
+	FStreamBlock& StreamBlock = Blocks.AddDefaulted_GetRef();
+	StreamBlock.StreamActorIndex = Command.StreamActorIndex;
+	StreamBlock.Offset = StreamSize;
+	StreamBlock.Size = BlockHeaderAr.Num() + PayloadSize;
+	StreamSize += StreamBlock.Size;
+
+	const FRecordFrame& FirstFrame = Block.RecordedFrames[0];
+	FStreamActorSummary& Summary = StreamBlock.Summary;
+	Summary.IndexEntry.NumFrames = Block.RecordedFrames.Num();
+	Summary.IndexEntry.StartTime = FirstFrame.TimeStamp;
+	Summary.IndexEntry.EndTime = Block.RecordedFrames.Last().TimeStamp;
+	Summary.FirstFrameIndex = FirstFrame.FrameIndex;
+	if (FirstFrame.HasTrack(Block.PrimaryComponentId))
+	{
+		Summary.FirstPrimaryTransform = FirstFrame.ComponentTransforms[Block.PrimaryComponentId];
+	}
+}
+
+FBloodStainStreamWriter::FStreamActorSummary FBloodStainStreamWriter::GetActorSummary(int32 StreamActorIndex) const
+{
+	FStreamActorSummary ActorSummary;
+	for (const FStreamBlock& StreamBlock : Blocks)
+	{
+		if (StreamBlock.StreamActorIndex != StreamActorIndex)
+		{
+			continue;
+		}
+
+		if (ActorSummary.IndexEntry.NumFrames == 0)
+		{
+			ActorSummary = StreamBlock.Summary;
+			continue;
+		}
+		ActorSummary.IndexEntry.NumFrames += StreamBlock.Summary.IndexEntry.NumFrames;
+		ActorSummary.IndexEntry.EndTime = StreamBlock.Summary.IndexEntry.EndTime;
+	}
+	return ActorSummary;
+}
+
+bool FBloodStainStreamWriter::CopyActorBlocks(int32 StreamActorIndex, FArchive& Ar) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_StreamWriter_CopyActorBlocks);
+
+	const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*StreamFilePath));
+	if (!Reader)
+	{
+		UE_LOG(LogBloodStain, Error, TEXT("[FBloodStainStreamWriter] Failed to read stream file: %s"), *StreamFilePath);
+		return false;
+	}
+
+	int32 NumBlocks = static_cast<int32>(Algo::CountIf(Blocks, [StreamActorIndex](const FStreamBlock& StreamBlock) { return StreamBlock.StreamActorIndex == StreamActorIndex; }));
+	Ar << NumBlocks;
+
+	TArray<uint8> BlockBytes;
+	for (const FStreamBlock& StreamBlock : Blocks)
+	{
+		if (StreamBlock.StreamActorIndex != StreamActorIndex)
+		{
+			continue;
+		}
+
+		if (StreamBlock.Offset + StreamBlock.Size > Reader->TotalSize())
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[FBloodStainStreamWriter] Truncated stream file: %s"), *StreamFilePath);
+			return false;
+		}
+
+		BlockBytes.SetNumUninitialized(StreamBlock.Size, EAllowShrinking::No);
+		Reader->Seek(StreamBlock.Offset);
+		Reader->Serialize(BlockBytes.GetData(), BlockBytes.Num());
+		Ar.Serialize(BlockBytes.GetData(), BlockBytes.Num());
+	}
+
+	return !Reader->IsError() && !Ar.IsError();
+}
@@ -7,6 +7,8 @@
 
 #include "BloodStainActor.h"
 #include "BloodStainFileUtils.h"
+#include "BloodStainRecordDataUtils.h"
+#include "BloodStainRecordSampler.h"
 #include "BloodStainSystem.h"
 #include "PlayComponent.h"
 #include "RecordComponent.h"
@@ -16,10 +18,13 @@
 #include "GameplayTagContainer.h"
 #include "GhostPlayerController.h"
 #include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
 #include "UObject/ConstructorHelpers.h"
 #include "Kismet/GameplayStatics.h"
 #include "Algo/BinarySearch.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Tasks/Task.h"
 
 class FSaveRecordingTask;
 
@@ -44,7 +49,20 @@ void UBloodStainSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	Super::Initialize(Collection);
 	ReplayTerminatedActorManager = NewObject<UReplayTerminatedActorManager>(this, UReplayTerminatedActorManager::StaticClass(), "ReplayDeadActorManager");
 	ReplayTerminatedActorManager->OnRecordGroupRemoveByCollecting.BindUObject(this, &UBloodStainSubsystem::CleanupInvalidRecordGroups);
+	RecordSampler = NewObject<UBloodStainRecordSampler>(this, UBloodStainRecordSampler::StaticClass(), "RecordSampler");
 	OnBloodStainReady.AddDynamic(this, &UBloodStainSubsystem::HandleBloodStainReady);
+
+	TWeakObjectPtr<UBloodStainSubsystem> WeakSubsystem(this);
+	CachedRecordings.OnEvicted.BindLambda([WeakSubsystem](const FString& RelativeFilePath, int64 NumBytes)
+	{
+		if (UBloodStainSubsystem* Subsystem = WeakSubsystem.Get())
+		{
+			FString LevelName;
+			FString FileName;
+			RelativeFilePath.Split(TEXT("/"), &LevelName, &FileName, ESearchCase::IgnoreCase, ESearchDir::FromEnd);
+			Subsystem->OnRecordBodyEvicted.Broadcast(FileName, LevelName);
+		}
+	});
 }
 
 bool UBloodStainSubsystem::StartRecording(AActor* TargetActor, FBloodStainRecordOptions RecordOptions)
@@ -73,6 +91,18 @@ bool UBloodStainSubsystem::StartRecording(AActor* TargetActor, FBloodStainRecord
 		{
 			RecordGroup.WorldBaseGroupStartTime = World->GetTimeSeconds();
 		}
+
+		if (RecordOptions.bStreamToDisk)
+		{
+			const FName GroupName = RecordOptions.RecordingGroupName == NAME_None ? DefaultGroupName : RecordOptions.RecordingGroupName;
+			const FString StreamName = FString::Printf(TEXT("%s-%s"), *GroupName.ToString(), *FDateTime::Now().ToString(TEXT("%Y%m%d-%H%M%S%s")));
+			RecordGroup.StreamWriter = MakeShared<FBloodStainStreamWriter>(BloodStainFileUtils::GetStreamFilePath(StreamName), FileSaveOptions);
+			if (!RecordGroup.StreamWriter->Open())
+			{
+				UE_LOG(LogBloodStain, Error, TEXT("[BloodStain] StartRecording failed: cannot stream group %s to disk"), *GroupName.ToString());
+				return false;
+			}
+		}
 		BloodStainRecordGroups.Add(RecordOptions.RecordingGroupName, RecordGroup);
 	}
 	
@@ -95,7 +125,16 @@ bool UBloodStainSubsystem::StartRecording(AActor* TargetActor, FBloodStainRecord
 	
 	TargetActor->AddInstanceComponent(Recorder);
 	Recorder->RegisterComponent();
-	Recorder->Initialize(RecordGroup.RecordOptions, RecordGroup.WorldBaseGroupStartTime);
+	// Bone filters are per actor, so a group can record its main actor at full fidelity and the others at a lower LOD
+	FBloodStainRecordOptions RecorderOptions = RecordGroup.RecordOptions;
+	RecorderOptions.BoneLODLevel = RecordOptions.BoneLODLevel;
+	RecorderOptions.RecordedBoneNames = RecordOptions.RecordedBoneNames;
+	Recorder->Initialize(RecorderOptions, RecordGroup.WorldBaseGroupStartTime);
+	Recorder->SetSamplePhase(RecordSampler->AllocateSamplePhase());
+	if (RecordGroup.StreamWriter.IsValid())
+	{
+		Recorder->SetStreamWriter(RecordGroup.StreamWriter, RecordGroup.NumStreamActors++);
+	}
 
 	RecordGroup.ActiveRecorders.Add(TargetActor, Recorder);
 	
@@ -133,137 +172,20 @@ void UBloodStainSubsystem::StopRecording(FName GroupName, bool bSaveRecordingDat
 
 	FBloodStainRecordGroup& BloodStainRecordGroup = BloodStainRecordGroups[GroupName];
 	
-	if (bSaveRecordingData)
+	if (bSaveRecordingData && BloodStainRecordGroup.StreamWriter.IsValid())
 	{
-		BloodStainRecordGroup.WorldBaseGroupEndTime = GetWorld()->GetTimeSeconds(); 
-		const float FrameBaseEndTime = BloodStainRecordGroup.WorldBaseGroupEndTime - BloodStainRecordGroup.WorldBaseGroupStartTime;
-		const float EffectiveStartTime = FrameBaseEndTime - BloodStainRecordGroup.RecordOptions.MaxRecordTime;
-		const float FrameBaseStartTime = EffectiveStartTime > 0 ? EffectiveStartTime : 0;
-
-		TMap<FName, int32> ActorNameToRecordDataIndexMap;
-		TArray<FRecordActorSaveData> RecordActorSaveDataArray;
-		TArray<FInstancedStruct> ActorHeaderDataArray;
-		
-		TArray<FName> TerminateActorNameArray;
-		TArray<FInstancedStruct> TerminateRecordActorUserDataArray;
-		TArray<FRecordActorSaveData> TerminatedActorSaveDataArray = ReplayTerminatedActorManager->CookQueuedFrames(GroupName, FrameBaseStartTime, TerminateActorNameArray, TerminateRecordActorUserDataArray);		
-		for (int32 Index = 0; Index < TerminatedActorSaveDataArray.Num(); Index++)
-		{
-			const FRecordActorSaveData& RecordActorSaveData = TerminatedActorSaveDataArray[Index];
-			const FName& ActorName = TerminateActorNameArray[Index];
-			const FInstancedStruct& RecordActorUserData = TerminateRecordActorUserDataArray[Index];
-
-			if (!RecordActorSaveData.IsValid())
-			{
-				UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: Frame num is 0"));
-				continue;
-			}
-
-			ActorHeaderDataArray.Add(RecordActorUserData);
-			
-			RecordActorSaveDataArray.Add(RecordActorSaveData);
-			int32 RecordDataIndex = RecordActorSaveDataArray.Num() - 1;
-			ActorNameToRecordDataIndexMap.Add(ActorName, RecordDataIndex);
-		}
-		for (const auto& [Actor, RecordComponent] : BloodStainRecordGroup.ActiveRecorders)
-		{
-			if (!Actor)
-			{
-				UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: Actor is not Valid"));
-				continue;
-			}
-
-			if (!RecordComponent)
-			{
-				UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: RecordComponent is not Valid for Actor: %s"), *Actor->GetName());
-				continue;
-			}
-
-			FRecordActorSaveData RecordActorSaveData = RecordComponent->CookQueuedFrames(FrameBaseStartTime);
-			if (RecordActorSaveData.RecordedFrames.Num() == 0)
-			{
-				UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: Frame is 0: %s"), *Actor->GetName());
-				continue;
-			}
-
-			FInstancedStruct RecordActorUserData = RecordComponent->GetRecordActorUserData();
-			ActorHeaderDataArray.Add(RecordActorUserData);
-			
-			RecordActorSaveDataArray.Add(RecordActorSaveData);
-			int32 RecordDataIndex = RecordActorSaveDataArray.Num() - 1;
-			ActorNameToRecordDataIndexMap.Add(Actor->GetFName(), RecordDataIndex);
-		}
-
-		
-		if (RecordActorSaveDataArray.Num() == 0)
+		SaveStreamedRecording(GroupName);
+	}
+	else if (bSaveRecordingData)
+	{
+		if (!SaveQueuedRecording(GroupName))
 		{
-			UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Failed: There is no Valid Recorder Group[%s]"), GetData(GroupName.ToString()));
 			return;
 		}
-		
-		const FString MapName = UGameplayStatics::GetCurrentLevelName(GetWorld());
-		FString GroupNameString = GroupName.ToString();
-		const FString UniqueTimestamp = FDateTime::Now().ToString(TEXT("%Y%m%d-%H%M%S%s"));
-
-		if (GroupName == NAME_None)
-		{
-			GroupNameString = DefaultGroupName.ToString();
-		}
-
-		if (BloodStainRecordGroup.RecordingMainActor.Get() != nullptr && ActorNameToRecordDataIndexMap.Contains(BloodStainRecordGroup.RecordingMainActor->GetFName()))
-		{
-			const int32 Index = ActorNameToRecordDataIndexMap[BloodStainRecordGroup.RecordingMainActor->GetFName()];
-			const FRecordActorSaveData& SaveData = RecordActorSaveDataArray[Index];
-			
-			BloodStainRecordGroup.SpawnPointTransform = SaveData.RecordedFrames[0].RelativeTransforms[SaveData.PrimaryComponentName.ToString()];
-		}
-		else
-		{
-			const FRecordActorSaveData& SaveData = RecordActorSaveDataArray[0];
-			BloodStainRecordGroup.SpawnPointTransform = SaveData.RecordedFrames[0].RelativeTransforms[SaveData.PrimaryComponentName.ToString()];
-		}
-	
-		if (BloodStainRecordGroup.RecordOptions.FileName == NAME_None)
-		{
-			BloodStainRecordGroup.RecordOptions.FileName = FName(FString::Printf(TEXT("%s-%s"), *GroupNameString, *UniqueTimestamp));
-		}
-		else
-		{
-			BloodStainRecordGroup.RecordOptions.FileName = FName(BloodStainRecordGroup.RecordOptions.FileName.ToString().Replace(TEXT("\\"), TEXT(" ")).Replace(TEXT("/"), TEXT(" ")));
-		}
-		
-		FRecordSaveData RecordSaveData = ConvertToSaveData(FrameBaseEndTime, GroupName, BloodStainRecordGroup.RecordOptions.FileName, FName(MapName), RecordActorSaveDataArray);
-		
-		RecordSaveData.Header.RecordGroupUserData = GetReplayUserHeaderData(GroupName);
-		RecordSaveData.Header.RecordActorUserData = ActorHeaderDataArray;
-		
-		const FString FinalFilePath = BloodStainFileUtils::GetFullFilePath(BloodStainRecordGroup.RecordOptions.FileName.ToString(), MapName);
-
-		RecordSaveData.Header.FileName = BloodStainRecordGroup.RecordOptions.FileName;
-		RecordSaveData.Header.LevelName = FName(MapName);
-		
-		auto OnSaveCompleted = [this, FinalFilePath, Header = RecordSaveData.Header]()
-		{
-			if (GetWorld())
-			{
-				if (AGhostPlayerController* PC = Cast<AGhostPlayerController>(GetWorld()->GetFirstPlayerController()))
-				{
-					if (PC->IsLocalController())
-					{
-						UE_LOG(LogBloodStain, Log, TEXT("Async save completed. Starting upload for: %s"), *FinalFilePath);
-						PC->StartFileUpload(FinalFilePath, Header);
-					}
-				}
-			}
-		};
-		
-		OnCompleteBuildRecordingHeader.Broadcast(GroupName);
-		ClearReplayUserHeaderData(GroupName);
-		
-		(new FAutoDeleteAsyncTask<FSaveRecordingTask>(
-			MoveTemp(RecordSaveData), MapName, BloodStainRecordGroup.RecordOptions.FileName.ToString(), FileSaveOptions
-			, FSimpleDelegateGraphTask::FDelegate::CreateLambda(MoveTemp(OnSaveCompleted))
-		))->StartBackgroundTask();
+	}
+	else if (BloodStainRecordGroup.StreamWriter.IsValid())
+	{
+		BloodStainRecordGroup.StreamWriter->Discard();
 	}
 
 	TMap<TObjectPtr<AActor>, TObjectPtr<URecordComponent>> Temp = BloodStainRecordGroup.ActiveRecorders;
@@ -307,8 +229,15 @@ void UBloodStainSubsystem::StopRecordComponent(URecordComponent* RecordComponent
 	BloodStainRecordGroup.ActiveRecorders.Remove(RecordComponent->GetOwner());
 	
 	if (bSaveRecordingData)
-	{	
-		ReplayTerminatedActorManager->AddToRecordGroup(GroupName, RecordComponent);	
+	{
+		if (RecordComponent->IsStreaming())
+		{
+			FinishStreamedRecorder(BloodStainRecordGroup, RecordComponent->GetOwner(), RecordComponent);
+		}
+		else
+		{
+			ReplayTerminatedActorManager->AddToRecordGroup(GroupName, RecordComponent);
+		}
 	}	
 	
 	RecordComponent->UnregisterComponent();
@@ -345,14 +274,14 @@ bool UBloodStainSubsystem::StartReplayFromFile(APlayerController* RequestingCont
 
 	if (NetMode == NM_Standalone)
 	{
-		FRecordSaveData Data;
-		if (!FindOrLoadRecordBodyData(FileName, LevelName, Data))
+		const TSharedPtr<const FRecordSaveData> Data = FindOrLoadSharedRecordBodyData(FileName, LevelName);
+		if (!Data.IsValid())
 		{
 			UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] File: Cannot Load File [%s]"), *FileName);
 			return false;
 		}
 
-		return StartReplay_Standalone(Data, PlaybackOptions, OutGuid);
+		return StartReplay_Standalone(Data.ToSharedRef(), PlaybackOptions, OutGuid);
 	}
 
 	if (NetMode == NM_Client)
@@ -385,8 +314,189 @@ bool UBloodStainSubsystem::StartReplayFromFile(APlayerController* RequestingCont
 	return StartReplay_Networked(RequestingController, FileName, LevelName, FileHeader, RecordHeader, CompressedPayload, PlaybackOptions, OutGuid);
 }
 
+FGuid UBloodStainSubsystem::StartReplayFromFileAsync(APlayerController* RequestingController, const FString& FileName, const FString& LevelName,
+	const FOnReplayStarted& OnReplayStarted, FBloodStainPlaybackOptions PlaybackOptions)
+{
+	ENetMode NetMode = NM_Standalone;
+	if (UWorld* World = GetWorld())
+	{
+		NetMode = World->GetNetMode();
+	}
+
+	// The server starts the replay, there is no file to load here
+	if (NetMode == NM_Client)
+	{
+		FGuid Guid;
+		const bool bStarted = StartReplayFromFile(RequestingController, FileName, LevelName, Guid, PlaybackOptions);
+		OnReplayStarted.ExecuteIfBound(bStarted, Guid);
+		return Guid;
+	}
+
+	const FString RelativeFilePath = GetRelativeFilePath(FileName, LevelName);
+	const FGuid PlaybackKey = FGuid::NewGuid();
+
+	if (NetMode == NM_Standalone && !PendingReplayLoads.Contains(RelativeFilePath))
+	{
+		const FDateTime LastModifiedTime = IFileManager::Get().GetTimeStamp(*GetFullFilePath(FileName, LevelName));
+		if (const TSharedPtr<const FRecordSaveData> Cached = CachedRecordings.Find(RelativeFilePath, LastModifiedTime))
+		{
+			FGuid Guid;
+			const bool bStarted = StartReplay_Standalone(Cached.ToSharedRef(), PlaybackOptions, Guid, PlaybackKey);
+			OnReplayStarted.ExecuteIfBound(bStarted, Guid);
+			return Guid;
+		}
+	}
+
+	FPendingReplayRequest Request;
+	Request.RequestingController = RequestingController;
+	Request.PlaybackKey = PlaybackKey;
+	Request.PlaybackOptions = PlaybackOptions;
+	Request.OnReplayStarted = OnReplayStarted;
+	if (!AddPendingReplay(RelativeFilePath, MoveTemp(Request)))
+	{
+		return PlaybackKey;
+	}
+
+	TWeakObjectPtr<UBloodStainSubsystem> WeakThis(this);
+	if (NetMode == NM_Standalone)
+	{
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, FileName, LevelName]()
+		{
+			const FDateTime Timestamp = IFileManager::Get().GetTimeStamp(*BloodStainFileUtils::GetFullFilePath(FileName, LevelName));
+			// The record header is read with the body, the game thread does not touch the disk
+			TSharedPtr<FRecordSaveData> Loaded = MakeShared<FRecordSaveData>();
+			if (!BloodStainFileUtils::LoadFromFile(FileName, LevelName, *Loaded))
+			{
+				Loaded.Reset();
+			}
+
+			FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis, FileName, LevelName, Loaded, Timestamp]()
+			{
+				if (UBloodStainSubsystem* Subsystem = WeakThis.Get())
+				{
+					Subsystem->FinishAsyncBodyLoad(FileName, LevelName, Loaded, Timestamp);
+				}
+			}, TStatId(), nullptr, ENamedThreads::GameThread);
+		});
+	}
+	else
+	{
+		// NM_ListenServer or NM_DedicatedServer : the payload is sent as stored, the ReplayActors decode it
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, FileName, LevelName]()
+		{
+			FBloodStainFileHeader FileHeader;
+			FRecordHeaderData RecordHeader;
+			TArray<uint8> Payload;
+			const bool bLoaded = BloodStainFileUtils::LoadRawPayloadFromFile(FileName, LevelName, FileHeader, RecordHeader, Payload);
+
+			FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis, FileName, LevelName, bLoaded, FileHeader, RecordHeader = MoveTemp(RecordHeader), Payload = MoveTemp(Payload)]() mutable
+			{
+				if (UBloodStainSubsystem* Subsystem = WeakThis.Get())
+				{
+					Subsystem->FinishAsyncPayloadLoad(FileName, LevelName, bLoaded, FileHeader, MoveTemp(RecordHeader), Payload);
+				}
+			}, TStatId(), nullptr, ENamedThreads::GameThread);
+		});
+	}
+
+	return PlaybackKey;
+}
+
+bool UBloodStainSubsystem::IsReplayLoading(const FGuid& InPlaybackKey) const
+{
+	for (const auto& [RelativeFilePath, Requests] : PendingReplayLoads)
+	{
+		if (Requests.ContainsByPredicate([&InPlaybackKey](const FPendingReplayRequest& Request) { return Request.PlaybackKey == InPlaybackKey; }))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool UBloodStainSubsystem::AddPendingReplay(const FString& RelativeFilePath, FPendingReplayRequest&& Request)
+{
+	// A pending file without requests (all cancelled) is still being loaded
+	const bool bNewLoad = !PendingReplayLoads.Contains(RelativeFilePath);
+	PendingReplayLoads.FindOrAdd(RelativeFilePath).Add(MoveTemp(Request));
+	return bNewLoad;
+}
+
+bool UBloodStainSubsystem::CancelPendingReplay(const FGuid& PlaybackKey)
+{
+	for (auto& [RelativeFilePath, Requests] : PendingReplayLoads)
+	{
+		const int32 Index = Requests.IndexOfByPredicate([&PlaybackKey](const FPendingReplayRequest& Request) { return Request.PlaybackKey == PlaybackKey; });
+		if (Index != INDEX_NONE)
+		{
+			const FOnReplayStarted OnReplayStarted = Requests[Index].OnReplayStarted;
+			Requests.RemoveAt(Index);
+			OnReplayStarted.ExecuteIfBound(false, FGuid());
+			return true;
+		}
+	}
+	return false;
+}
+
+void UBloodStainSubsystem::FinishAsyncBodyLoad(const FString& FileName, const FString& LevelName, const TSharedPtr<FRecordSaveData>& Loaded, const FDateTime& Timestamp)
+{
+	const FString RelativeFilePath = GetRelativeFilePath(FileName, LevelName);
+	TArray<FPendingReplayRequest> Requests;
+	PendingReplayLoads.RemoveAndCopyValue(RelativeFilePath, Requests);
+
+	TSharedPtr<const FRecordSaveData> Data;
+	if (Loaded.IsValid())
+	{
+		Loaded->Header.FileName = FName(FileName);
+		CachedHeaders.Add(RelativeFilePath, Loaded->Header);
+		CachedRecordings.Add(RelativeFilePath, Loaded.ToSharedRef(), Timestamp);
+		Data = Loaded;
+	}
+	else
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] File: Cannot Load File [%s]"), *FileName);
+	}
+
+	for (const FPendingReplayRequest& Request : Requests)
+	{
+		FGuid Guid;
+		const bool bStarted = Data.IsValid() && StartReplay_Standalone(Data.ToSharedRef(), Request.PlaybackOptions, Guid, Request.PlaybackKey);
+		Request.OnReplayStarted.ExecuteIfBound(bStarted, Guid);
+	}
+}
+
+void UBloodStainSubsystem::FinishAsyncPayloadLoad(const FString& FileName, const FString& LevelName, bool bLoaded, const FBloodStainFileHeader& FileHeader, FRecordHeaderData&& RecordHeader, const TArray<uint8>& Payload)
+{
+	const FString RelativeFilePath = GetRelativeFilePath(FileName, LevelName);
+	TArray<FPendingReplayRequest> Requests;
+	PendingReplayLoads.RemoveAndCopyValue(RelativeFilePath, Requests);
+
+	RecordHeader.FileName = FName(FileName);
+	if (bLoaded)
+	{
+		CachedHeaders.Add(RelativeFilePath, RecordHeader);
+	}
+	else
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] File: Cannot Load Raw Payload [%s] for Networked"), *FileName);
+	}
+
+	for (const FPendingReplayRequest& Request : Requests)
+	{
+		FGuid Guid;
+		const bool bStarted = bLoaded && StartReplay_Networked(Request.RequestingController.Get(), FileName, LevelName, FileHeader, RecordHeader, Payload,
+			Request.PlaybackOptions, Guid, Request.PlaybackKey);
+		Request.OnReplayStarted.ExecuteIfBound(bStarted, Guid);
+	}
+}
+
 void UBloodStainSubsystem::StopReplay(FGuid PlaybackKey)
 {
+	if (CancelPendingReplay(PlaybackKey))
+	{
+		return;
+	}
+
 	if (!BloodStainPlaybackGroups.Contains(PlaybackKey))
 	{
 		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopReplay failed: Group [%s] is not exist"), *PlaybackKey.ToString());
@@ -403,6 +513,9 @@ void UBloodStainSubsystem::StopReplay(FGuid PlaybackKey)
 	BloodStainPlaybackGroup.ActiveReplayers.Empty();
 
 	BloodStainPlaybackGroups.Remove(PlaybackKey);	
+
+	// The destroyed ghosts no longer pin their replay data
+	CachedRecordings.Trim();
 }
 
 void UBloodStainSubsystem::StopReplayPlayComponent(AReplayActor* GhostActor)
@@ -474,6 +587,7 @@ void UBloodStainSubsystem::NotifyComponentAttached(AActor* TargetActor, USceneCo
 	if (URecordComponent* RecordComponent = TargetActor->GetComponentByClass<URecordComponent>())
 	{
 		RecordComponent->OnComponentAttached(NewComponent);
+		RecordComponent->MarkAttachmentsDirty();
 	}
 }
 
@@ -488,6 +602,21 @@ void UBloodStainSubsystem::NotifyComponentDetached(AActor* TargetActor, USceneCo
 	if (URecordComponent* RecordComponent = TargetActor->GetComponentByClass<URecordComponent>())
 	{
 		RecordComponent->OnComponentDetached(DetachedComponent);
+		RecordComponent->MarkAttachmentsDirty();
+	}
+}
+
+void UBloodStainSubsystem::NotifyAttachmentsChanged(AActor* TargetActor)
+{
+	if (!TargetActor)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] NotifyAttachmentsChanged failed: TargetActor is null."));
+		return;
+	}
+
+	if (URecordComponent* RecordComponent = TargetActor->GetComponentByClass<URecordComponent>())
+	{
+		RecordComponent->MarkAttachmentsDirty();
 	}
 }
 
@@ -522,6 +651,93 @@ void UBloodStainSubsystem::DeleteAllBloodStainActors()
 	BloodStainActors.Empty();
 }
 
+void UBloodStainSubsystem::GetActiveRecorders(TArray<URecordComponent*>& OutRecorders) const
+{
+	for (const auto& [GroupName, RecordGroup] : BloodStainRecordGroups)
+	{
+		for (const auto& [Actor, RecordComponent] : RecordGroup.ActiveRecorders)
+		{
+			if (RecordComponent != nullptr)
+			{
+				OutRecorders.Add(RecordComponent);
+			}
+		}
+	}
+}
+
+void UBloodStainSubsystem::SetRecordActorSignificance(AActor* TargetActor, float Significance)
+{
+	if (!TargetActor)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] SetRecordActorSignificance failed: TargetActor is null."));
+		return;
+	}
+
+	if (URecordComponent* RecordComponent = TargetActor->GetComponentByClass<URecordComponent>())
+	{
+		RecordComponent->SetSignificanceOverride(Significance);
+	}
+}
+
+float UBloodStainSubsystem::EvaluateRecordSignificance(const URecordComponent* Recorder) const
+{
+	if (Recorder->GetSignificanceOverride() >= 0.f)
+	{
+		return FMath::Min(Recorder->GetSignificanceOverride(), 1.f);
+	}
+
+	const AActor* Owner = Recorder->GetOwner();
+	if (!Owner)
+	{
+		return 1.f;
+	}
+
+	const FBloodStainRecordGroup* RecordGroup = BloodStainRecordGroups.Find(Recorder->GetRecordGroupName());
+	if (RecordGroup && RecordGroup->RecordingMainActor.Get() == Owner)
+	{
+		return 1.f;
+	}
+
+	const APawn* Pawn = Cast<APawn>(Owner);
+	if (Pawn && Pawn->IsPlayerControlled())
+	{
+		return 1.f;
+	}
+
+	if (OnEvaluateRecordSignificance.IsBound())
+	{
+		return FMath::Clamp(OnEvaluateRecordSignificance.Execute(Recorder), 0.f, 1.f);
+	}
+
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return 1.f;
+	}
+
+	float NearestDistSquared = UE_MAX_FLT;
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APlayerController* PlayerController = It->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			NearestDistSquared = FMath::Min(NearestDistSquared, FVector::DistSquared(ViewLocation, Owner->GetActorLocation()));
+		}
+	}
+	if (NearestDistSquared == UE_MAX_FLT)
+	{
+		return 1.f;
+	}
+
+	const FBloodStainRecordOptions& Options = Recorder->RecordOptions;
+	const float Significance = 1.f - FMath::SmoothStep(Options.SignificanceNearDistance, FMath::Max(Options.SignificanceFarDistance, Options.SignificanceNearDistance + 1.f), FMath::Sqrt(NearestDistSquared));
+
+	// Off-screen participants matter less
+	return Owner->WasRecentlyRendered() ? Significance : Significance * 0.5f;
+}
+
 bool UBloodStainSubsystem::IsFileHeaderLoaded(const FString& FileName, const FString& LevelName) const
 {
 	const FString RelativeFilePath = GetRelativeFilePath(FileName, LevelName);
@@ -556,34 +772,40 @@ bool UBloodStainSubsystem::FindOrLoadRecordHeader(const FString& FileName, const
 }
 
 bool UBloodStainSubsystem::FindOrLoadRecordBodyData(const FString& FileName, const FString& LevelName, FRecordSaveData& OutData)
+{
+	const TSharedPtr<const FRecordSaveData> Data = FindOrLoadSharedRecordBodyData(FileName, LevelName);
+	if (!Data.IsValid())
+	{
+		return false;
+	}
+
+	OutData = *Data;
+	return true;
+}
+
+TSharedPtr<const FRecordSaveData> UBloodStainSubsystem::FindOrLoadSharedRecordBodyData(const FString& FileName, const FString& LevelName)
 {
 	const FString RelativeFilePath = GetRelativeFilePath(FileName, LevelName);
 	const FString FullFilePath = GetFullFilePath(FileName, LevelName);
 
 	const FDateTime LastModifiedTime = IFileManager::Get().GetTimeStamp(*FullFilePath);
 	
-	if (FCachedRecordData* Cached = CachedRecordings.Find(RelativeFilePath))
+	if (TSharedPtr<const FRecordSaveData> Cached = CachedRecordings.Find(RelativeFilePath, LastModifiedTime))
 	{
-		if (Cached->Timestamp == LastModifiedTime)
-		{
-			OutData = Cached->RecordData;
-			UE_LOG(LogBloodStain, Log, TEXT("Cache hit and valid for %s"), *RelativeFilePath);
-			return true;
-		}
-		UE_LOG(LogBloodStain, Warning, TEXT("Stale cache detected for %s. Removing old entry and reloading."), *RelativeFilePath);
-		CachedRecordings.Remove(RelativeFilePath);
+		UE_LOG(LogBloodStain, Log, TEXT("Cache hit and valid for %s"), *RelativeFilePath);
+		return Cached;
 	}
 
-	FRecordSaveData Loaded;
-	if (!BloodStainFileUtils::LoadFromFile(FileName, LevelName, Loaded))
+	TSharedRef<FRecordSaveData> Loaded = MakeShared<FRecordSaveData>();
+	if (!BloodStainFileUtils::LoadFromFile(FileName, LevelName, *Loaded))
 	{
 		UE_LOG(LogBloodStain, Error, TEXT("[BloodStain] Failed to load file %s"), *FileName);
-		return false;
+		return nullptr;
 	}
 
-	OutData = Loaded;
-	CachedRecordings.Add(RelativeFilePath, FCachedRecordData(MoveTemp(Loaded), LastModifiedTime));
-	return true;
+	// A stale entry removed above stays alive as long as a ghost still plays it
+	CachedRecordings.Add(RelativeFilePath, Loaded, LastModifiedTime);
+	return Loaded;
 }
 
 TArray<FRecordHeaderData> UBloodStainSubsystem::GetCachedHeaders() const
@@ -636,10 +858,7 @@ void UBloodStainSubsystem::LoadAllHeaders()
 void UBloodStainSubsystem::ClearCachedBodyData(const FString& FileName, const FString& LevelName)
 {
 	const FString RelativeFilePath = GetRelativeFilePath(FileName, LevelName);
-	if (CachedRecordings.Contains(RelativeFilePath))
-	{
-		CachedRecordings.Remove(RelativeFilePath);
-	}
+	CachedRecordings.Remove(RelativeFilePath);
 }
 
 void UBloodStainSubsystem::ClearCachedData(const FString& FileName, const FString& LevelName)
@@ -655,7 +874,7 @@ void UBloodStainSubsystem::ClearCachedData(const FString& FileName, const FStrin
 
 void UBloodStainSubsystem::ClearAllCachedBodyData()
 {
-	CachedHeaders.Empty();
+	CachedRecordings.Empty();
 }
 
 void UBloodStainSubsystem::ClearAllCachedData()
@@ -664,6 +883,11 @@ void UBloodStainSubsystem::ClearAllCachedData()
 	CachedRecordings.Empty();
 }
 
+int64 UBloodStainSubsystem::GetCachedBodyDataSize() const
+{
+	return CachedRecordings.GetNumBytes();
+}
+
 bool UBloodStainSubsystem::DeleteFile(const FString& FileName, const FString& LevelName)
 {
 	ClearCachedBodyData(FileName, LevelName);
@@ -752,6 +976,45 @@ void UBloodStainSubsystem::SpawnAllBloodStainInLevel(const FBloodStainPlaybackOp
 	}
 }
 
+bool UBloodStainSubsystem::StartReplayFromSaveData(const TSharedRef<const FRecordSaveData>& RecordSaveData, const FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid, bool bSaveFileInBackground)
+{
+	if (GetWorld() && GetWorld()->GetNetMode() != NM_Standalone)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StartReplayFromSaveData failed: only supported in standalone, save the recording and use StartReplayFromFile"));
+		return false;
+	}
+
+	if (!StartReplay_Standalone(RecordSaveData, PlaybackOptions, OutGuid))
+	{
+		return false;
+	}
+
+	if (bSaveFileInBackground)
+	{
+		// The quantization ranges are computed into a copy, made on the worker
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis = TWeakObjectPtr<UBloodStainSubsystem>(this), RecordSaveData, FileOptions = FileSaveOptions]()
+		{
+			FRecordSaveData LocalCopy = *RecordSaveData;
+			const FString MapName = LocalCopy.Header.LevelName.ToString();
+			const FString FileName = LocalCopy.Header.FileName.ToString();
+			SaveCookedRecording(WeakThis, MoveTemp(LocalCopy), MapName, FileName, FileOptions);
+		});
+	}
+	return true;
+}
+
+bool UBloodStainSubsystem::StartReplayFromSnapshot(FName GroupName, float SnapshotDuration, const TArray<AActor*>& Actors, FGuid& OutGuid,
+	FBloodStainPlaybackOptions PlaybackOptions, bool bSaveFileInBackground)
+{
+	const TSharedRef<FRecordSaveData> Snapshot = MakeShared<FRecordSaveData>();
+	if (!CreateRecordingSnapshot(GroupName, SnapshotDuration, Actors, Snapshot.Get()))
+	{
+		return false;
+	}
+
+	return StartReplayFromSaveData(Snapshot, PlaybackOptions, OutGuid, bSaveFileInBackground);
+}
+
 bool UBloodStainSubsystem::IsPlaying(const FGuid& InPlaybackKey) const
 {
 	return BloodStainPlaybackGroups.Contains(InPlaybackKey);
@@ -773,6 +1036,383 @@ FRecordSaveData UBloodStainSubsystem::ConvertToSaveData(float EndTime, const FNa
 	return RecordSaveData;
 }
 
+FName UBloodStainSubsystem::ResolveRecordFileName(const FName& GroupName, FBloodStainRecordGroup& RecordGroup) const
+{
+	if (RecordGroup.RecordOptions.FileName == NAME_None)
+	{
+		const FString GroupNameString = GroupName == NAME_None ? DefaultGroupName.ToString() : GroupName.ToString();
+		const FString UniqueTimestamp = FDateTime::Now().ToString(TEXT("%Y%m%d-%H%M%S%s"));
+		return FName(FString::Printf(TEXT("%s-%s"), *GroupNameString, *UniqueTimestamp));
+	}
+	
+	return FName(RecordGroup.RecordOptions.FileName.ToString().Replace(TEXT("\\"), TEXT(" ")).Replace(TEXT("/"), TEXT(" ")));
+}
+
+void UBloodStainSubsystem::OnRecordingFileSaved(const FString& FinalFilePath, const FRecordHeaderData& Header)
+{
+	if (GetWorld())
+	{
+		if (AGhostPlayerController* PC = Cast<AGhostPlayerController>(GetWorld()->GetFirstPlayerController()))
+		{
+			if (PC->IsLocalController())
+			{
+				UE_LOG(LogBloodStain, Log, TEXT("Async save completed. Starting upload for: %s"), *FinalFilePath);
+				PC->StartFileUpload(FinalFilePath, Header);
+			}
+		}
+	}
+}
+
+bool UBloodStainSubsystem::SaveQueuedRecording(const FName& GroupName)
+{
+	FBloodStainRecordGroup& RecordGroup = BloodStainRecordGroups[GroupName];
+	RecordGroup.WorldBaseGroupEndTime = GetWorld()->GetTimeSeconds(); 
+	const float FrameBaseEndTime = RecordGroup.WorldBaseGroupEndTime - RecordGroup.WorldBaseGroupStartTime;
+	const float EffectiveStartTime = FrameBaseEndTime - RecordGroup.RecordOptions.MaxRecordTime;
+	const float FrameBaseStartTime = EffectiveStartTime > 0 ? EffectiveStartTime : 0;
+
+	// Only the frame slabs are detached on the game thread, frames are never copied here
+	TArray<FDetachedRecordData> DetachedRecords;
+	ReplayTerminatedActorManager->DetachRecordGroup(GroupName, DetachedRecords);
+	for (const auto& [Actor, RecordComponent] : RecordGroup.ActiveRecorders)
+	{
+		if (!Actor)
+		{
+			UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: Actor is not Valid"));
+			continue;
+		}
+
+		if (!RecordComponent)
+		{
+			UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: RecordComponent is not Valid for Actor: %s"), *Actor->GetName());
+			continue;
+		}
+
+		DetachedRecords.Add(RecordComponent->DetachRecordData());
+	}
+
+	if (DetachedRecords.Num() == 0)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Failed: There is no Valid Recorder Group[%s]"), GetData(GroupName.ToString()));
+		return false;
+	}
+
+	const FString MapName = UGameplayStatics::GetCurrentLevelName(GetWorld());
+	RecordGroup.RecordOptions.FileName = ResolveRecordFileName(GroupName, RecordGroup);
+
+	// The spawn point is taken from the cooked frames of the main actor
+	TArray<FRecordActorSaveData> NoActorData;
+	FRecordHeaderData Header = ConvertToSaveData(FrameBaseEndTime, GroupName, RecordGroup.RecordOptions.FileName, FName(MapName), NoActorData).Header;
+	Header.RecordGroupUserData = GetReplayUserHeaderData(GroupName);
+	const FName MainActorName = RecordGroup.RecordingMainActor.IsValid() ? RecordGroup.RecordingMainActor->GetFName() : NAME_None;
+
+	OnCompleteBuildRecordingHeader.Broadcast(GroupName);
+	ClearReplayUserHeaderData(GroupName);
+
+	CookAndSaveRecording(MoveTemp(DetachedRecords), MoveTemp(Header), MainActorName, RecordGroup.RecordOptions.SamplingInterval, FrameBaseStartTime, MapName, RecordGroup.RecordOptions.FileName.ToString());
+	return true;
+}
+
+void UBloodStainSubsystem::CookAndSaveRecording(TArray<FDetachedRecordData>&& Records, FRecordHeaderData&& Header, const FName& MainActorName, float SamplingInterval, float ClipStartTime, const FString& MapName, const FString& FileName)
+{
+	// One cooking task per actor, the save task runs once they all completed
+	const TSharedRef<TArray<FDetachedRecordData>> SharedRecords = MakeShared<TArray<FDetachedRecordData>>(MoveTemp(Records));
+	TArray<UE::Tasks::FTask> CookTasks;
+	CookTasks.Reserve(SharedRecords->Num());
+	for (int32 Index = 0; Index < SharedRecords->Num(); ++Index)
+	{
+		CookTasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [SharedRecords, Index, SamplingInterval, ClipStartTime]()
+		{
+			BloodStainRecordDataUtils::CookDetachedRecord(SamplingInterval, ClipStartTime, (*SharedRecords)[Index]);
+		}));
+	}
+
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis = TWeakObjectPtr<UBloodStainSubsystem>(this), SharedRecords, Header = MoveTemp(Header), MainActorName, MapName, FileName, FileOptions = FileSaveOptions]() mutable
+	{
+		FRecordSaveData RecordSaveData;
+		RecordSaveData.Header = MoveTemp(Header);
+		if (!AssembleCookedRecords(*SharedRecords, MainActorName, RecordSaveData))
+		{
+			UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Failed: Recording %s has no valid actor"), *FileName);
+			return;
+		}
+
+		SaveCookedRecording(WeakThis, MoveTemp(RecordSaveData), MapName, FileName, FileOptions);
+	}, UE::Tasks::Prerequisites(CookTasks));
+}
+
+bool UBloodStainSubsystem::AssembleCookedRecords(TArray<FDetachedRecordData>& Records, const FName& MainActorName, FRecordSaveData& InOutSaveData)
+{
+	int32 SpawnPointActorIndex = 0;
+	for (FDetachedRecordData& Record : Records)
+	{
+		if (!Record.GhostSaveData.IsValid())
+		{
+			UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Warning: Frame is 0: %s"), *Record.ActorName.ToString());
+			continue;
+		}
+
+		if (Record.ActorName == MainActorName)
+		{
+			SpawnPointActorIndex = InOutSaveData.RecordActorDataArray.Num();
+		}
+		InOutSaveData.Header.RecordActorUserData.Add(MoveTemp(Record.UserData));
+		InOutSaveData.RecordActorDataArray.Add(MoveTemp(Record.GhostSaveData));
+	}
+
+	if (InOutSaveData.RecordActorDataArray.Num() == 0)
+	{
+		return false;
+	}
+
+	const FRecordActorSaveData& SpawnPointSaveData = InOutSaveData.RecordActorDataArray[SpawnPointActorIndex];
+	const int32 PrimaryComponentId = SpawnPointSaveData.PrimaryComponentId;
+	if (SpawnPointSaveData.RecordedFrames[0].HasTrack(PrimaryComponentId))
+	{
+		InOutSaveData.Header.SpawnPointTransform = SpawnPointSaveData.RecordedFrames[0].ComponentTransforms[PrimaryComponentId];
+	}
+	return true;
+}
+
+bool UBloodStainSubsystem::CollectSnapshotRecords(const FName& GroupName, float SnapshotDuration, const TArray<AActor*>& Actors, const FName& FileName,
+	TArray<FDetachedRecordData>& OutRecords, FRecordHeaderData& OutHeader, FName& OutMainActorName, float& OutClipStartTime)
+{
+	FBloodStainRecordGroup* RecordGroup = BloodStainRecordGroups.Find(GroupName);
+	if (RecordGroup == nullptr)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] Snapshot failed: Record Group %s is not recording"), GetData(GroupName.ToString()));
+		return false;
+	}
+
+	// Streamed recorders only keep the block being recorded in memory
+	if (RecordGroup->StreamWriter.IsValid())
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] Snapshot failed: Record Group %s is streamed to disk"), GetData(GroupName.ToString()));
+		return false;
+	}
+
+	const float GroupTime = GetWorld()->GetTimeSeconds() - RecordGroup->WorldBaseGroupStartTime;
+	const float Duration = FMath::Clamp(SnapshotDuration, 0.f, RecordGroup->RecordOptions.MaxRecordTime);
+	OutClipStartTime = FMath::Max(0.f, GroupTime - Duration);
+
+	TSet<FName> ActorNames;
+	for (const AActor* Actor : Actors)
+	{
+		if (Actor)
+		{
+			ActorNames.Add(Actor->GetFName());
+		}
+	}
+
+	for (const auto& [Actor, RecordComponent] : RecordGroup->ActiveRecorders)
+	{
+		if (Actor && RecordComponent && (ActorNames.IsEmpty() || ActorNames.Contains(Actor->GetFName())))
+		{
+			OutRecords.Add(RecordComponent->SnapshotRecordData(OutClipStartTime));
+		}
+	}
+	ReplayTerminatedActorManager->SnapshotRecordGroup(GroupName, OutClipStartTime, ActorNames.IsEmpty() ? nullptr : &ActorNames, OutRecords);
+
+	if (OutRecords.Num() == 0)
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] Snapshot failed: There is no Valid Recorder in Group[%s]"), GetData(GroupName.ToString()));
+		return false;
+	}
+
+	const FString MapName = UGameplayStatics::GetCurrentLevelName(GetWorld());
+	FName SnapshotFileName = FileName;
+	if (SnapshotFileName == NAME_None)
+	{
+		const FString GroupNameString = GroupName == NAME_None ? DefaultGroupName.ToString() : GroupName.ToString();
+		SnapshotFileName = FName(FString::Printf(TEXT("%s-Snapshot-%s"), *GroupNameString, *FDateTime::Now().ToString(TEXT("%Y%m%d-%H%M%S%s"))));
+	}
+
+	TArray<FRecordActorSaveData> NoActorData;
+	OutHeader = ConvertToSaveData(GroupTime, GroupName, SnapshotFileName, FName(MapName), NoActorData).Header;
+	OutHeader.MaxRecordTime = Duration;
+	OutHeader.TotalLength = GroupTime - OutClipStartTime;
+
+	// The group header data is kept for the recording itself
+	OutHeader.RecordGroupUserData = GetReplayUserHeaderData(GroupName);
+	OutMainActorName = RecordGroup->RecordingMainActor.IsValid() ? RecordGroup->RecordingMainActor->GetFName() : NAME_None;
+	return true;
+}
+
+bool UBloodStainSubsystem::CreateRecordingSnapshot(FName GroupName, float SnapshotDuration, const TArray<AActor*>& Actors, FRecordSaveData& OutSnapshot)
+{
+	TArray<FDetachedRecordData> Records;
+	FName MainActorName;
+	float ClipStartTime = 0.f;
+	OutSnapshot = FRecordSaveData();
+	if (!CollectSnapshotRecords(GroupName, SnapshotDuration, Actors, NAME_None, Records, OutSnapshot.Header, MainActorName, ClipStartTime))
+	{
+		return false;
+	}
+
+	const float SamplingInterval = BloodStainRecordGroups[GroupName].RecordOptions.SamplingInterval;
+	for (FDetachedRecordData& Record : Records)
+	{
+		BloodStainRecordDataUtils::CookDetachedRecord(SamplingInterval, ClipStartTime, Record);
+	}
+	return AssembleCookedRecords(Records, MainActorName, OutSnapshot);
+}
+
+bool UBloodStainSubsystem::SaveRecordingSnapshot(FName GroupName, float SnapshotDuration, const TArray<AActor*>& Actors, FName FileName)
+{
+	TArray<FDetachedRecordData> Records;
+	FRecordHeaderData Header;
+	FName MainActorName;
+	float ClipStartTime = 0.f;
+	if (!CollectSnapshotRecords(GroupName, SnapshotDuration, Actors, FileName, Records, Header, MainActorName, ClipStartTime))
+	{
+		return false;
+	}
+
+	const FString MapName = Header.LevelName.ToString();
+	const FString SnapshotFileName = Header.FileName.ToString();
+	CookAndSaveRecording(MoveTemp(Records), MoveTemp(Header), MainActorName, BloodStainRecordGroups[GroupName].RecordOptions.SamplingInterval, ClipStartTime, MapName, SnapshotFileName);
+	return true;
+}
+
+void UBloodStainSubsystem::SaveCookedRecording(const TWeakObjectPtr<UBloodStainSubsystem>& WeakSubsystem, FRecordSaveData&& RecordSaveData, const FString& MapName, const FString& FileName, const FBloodStainFileOptions& FileOptions)
+{
+	const FString FinalFilePath = BloodStainFileUtils::GetFullFilePath(FileName, MapName);
+	FRecordHeaderData SavedHeader = RecordSaveData.Header;
+
+	FSaveRecordingTask SaveTask(MoveTemp(RecordSaveData), MapName, FileName, FileOptions, FSimpleDelegateGraphTask::FDelegate::CreateLambda([WeakSubsystem, FinalFilePath, SavedHeader = MoveTemp(SavedHeader)]()
+	{
+		if (UBloodStainSubsystem* Subsystem = WeakSubsystem.Get())
+		{
+			Subsystem->OnRecordingFileSaved(FinalFilePath, SavedHeader);
+		}
+	}));
+	SaveTask.DoWork();
+}
+
+void UBloodStainSubsystem::FinishStreamedRecorder(FBloodStainRecordGroup& RecordGroup, const AActor* Actor, URecordComponent* RecordComponent)
+{
+	FStreamedRecordActor& StreamedActor = RecordGroup.FinishedStreamActors.AddDefaulted_GetRef();
+	StreamedActor.ActorName = Actor->GetFName();
+	StreamedActor.StreamActorIndex = RecordComponent->GetStreamActorIndex();
+	StreamedActor.ActorData = RecordComponent->FinishStream();
+	StreamedActor.UserData = RecordComponent->GetRecordActorUserData();
+}
+
+void UBloodStainSubsystem::SaveStreamedRecording(const FName& GroupName)
+{
+	FBloodStainRecordGroup& RecordGroup = BloodStainRecordGroups[GroupName];
+	RecordGroup.WorldBaseGroupEndTime = GetWorld()->GetTimeSeconds();
+	const float TotalLength = RecordGroup.WorldBaseGroupEndTime - RecordGroup.WorldBaseGroupStartTime;
+
+	for (const auto& [Actor, RecordComponent] : RecordGroup.ActiveRecorders)
+	{
+		if (Actor && RecordComponent && RecordComponent->IsStreaming())
+		{
+			FinishStreamedRecorder(RecordGroup, Actor, RecordComponent);
+		}
+	}
+
+	if (RecordGroup.FinishedStreamActors.IsEmpty())
+	{
+		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StopRecording Failed: There is no Valid Recorder Group[%s]"), GetData(GroupName.ToString()));
+		RecordGroup.StreamWriter->Discard();
+		return;
+	}
+
+	const FString MapName = UGameplayStatics::GetCurrentLevelName(GetWorld());
+	RecordGroup.RecordOptions.FileName = ResolveRecordFileName(GroupName, RecordGroup);
+
+	TArray<FRecordActorSaveData> NoActorData;
+	FRecordHeaderData Header = ConvertToSaveData(TotalLength, GroupName, RecordGroup.RecordOptions.FileName, FName(MapName), NoActorData).Header;
+	
+	// A streamed recording is not limited by MaxRecordTime
+	Header.MaxRecordTime = TotalLength;
+	Header.TotalLength = TotalLength;
+	Header.RecordGroupUserData = GetReplayUserHeaderData(GroupName);
+
+	int32 MainActorIndex = 0;
+	if (const AActor* MainActor = RecordGroup.RecordingMainActor.Get())
+	{
+		MainActorIndex = FMath::Max(0, RecordGroup.FinishedStreamActors.IndexOfByPredicate([MainActor](const FStreamedRecordActor& StreamedActor)
+		{
+			return StreamedActor.ActorName == MainActor->GetFName();
+		}));
+	}
+
+	OnCompleteBuildRecordingHeader.Broadcast(GroupName);
+	ClearReplayUserHeaderData(GroupName);
+
+	const FString FileName = RecordGroup.RecordOptions.FileName.ToString();
+	TWeakObjectPtr<UBloodStainSubsystem> WeakThis(this);
+
+	RecordGroup.StreamWriter->Finalize([WeakThis, Header = MoveTemp(Header), StreamedActors = MoveTemp(RecordGroup.FinishedStreamActors), MainActorIndex, MapName, FileName]
+		(bool bSuccess, const FBloodStainStreamWriter& Stream) mutable
+	{
+		if (!bSuccess)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BloodStain] Streamed recording %s could not be written to its stream"), *FileName);
+			return;
+		}
+
+		// Actors without enough frames to be played are left out before anything is written
+		FRecordSaveData RecordSaveData;
+		RecordSaveData.Header = MoveTemp(Header);
+		TArray<int32> StreamActorIndices;
+		TArray<FBloodStainActorIndexEntry> IndexEntries;
+		for (int32 Index = 0; Index < StreamedActors.Num(); ++Index)
+		{
+			FStreamedRecordActor& StreamedActor = StreamedActors[Index];
+			FBloodStainStreamWriter::FStreamActorSummary Summary = Stream.GetActorSummary(StreamedActor.StreamActorIndex);
+			if (Summary.IndexEntry.NumFrames < 2)
+			{
+				UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] Streamed recording %s has no frames for %s"), *FileName, *StreamedActor.ActorName.ToString());
+				continue;
+			}
+
+			if (Index == MainActorIndex && Summary.FirstPrimaryTransform.IsSet())
+			{
+				RecordSaveData.Header.SpawnPointTransform = Summary.FirstPrimaryTransform.GetValue();
+			}
+
+			// Static tracks are flagged in each block, the track table of the actor only describes the frame layout
+			FRecordActorSaveData& ActorData = RecordSaveData.RecordActorDataArray.Add_GetRef(MoveTemp(StreamedActor.ActorData));
+			TArray<FComponentActiveInterval> ComponentIntervals = MoveTemp(ActorData.ComponentIntervals);
+			ActorData.ComponentIntervals.Reset();
+			BloodStainRecordDataUtils::BuildInitialComponentStructure(Summary.FirstFrameIndex, Summary.IndexEntry.NumFrames, ActorData, ComponentIntervals);
+
+			StreamActorIndices.Add(StreamedActor.StreamActorIndex);
+			IndexEntries.Add(Summary.IndexEntry);
+			RecordSaveData.Header.RecordActorUserData.Add(MoveTemp(StreamedActor.UserData));
+		}
+
+		if (RecordSaveData.RecordActorDataArray.IsEmpty())
+		{
+			UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] Streamed recording %s has no valid actor"), *FileName);
+			return;
+		}
+
+		// The blocks were encoded with the file options while recording, they are copied as they are
+		const bool bSaved = BloodStainFileUtils::SaveFrameBlocksToFile(RecordSaveData, IndexEntries, [&Stream, &StreamActorIndices](int32 ActorIndex, FArchive& FileWriter)
+		{
+			return Stream.CopyActorBlocks(StreamActorIndices[ActorIndex], FileWriter);
+		}, MapName, FileName, Stream.GetFileOptions());
+
+		if (!bSaved)
+		{
+			UE_LOG(LogBloodStain, Error, TEXT("[BloodStain] Streamed recording %s could not be saved"), *FileName);
+			return;
+		}
+
+		FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis, FinalFilePath = BloodStainFileUtils::GetFullFilePath(FileName, MapName), SavedHeader = MoveTemp(RecordSaveData.Header)]()
+		{
+			if (UBloodStainSubsystem* Subsystem = WeakThis.Get())
+			{
+				Subsystem->OnRecordingFileSaved(FinalFilePath, SavedHeader);
+			}
+		}, TStatId(), nullptr, ENamedThreads::GameThread);
+	});
+}
+
 void UBloodStainSubsystem::SetReplayUserGroupData(const FInstancedStruct& ReplayUserHeaderData, const FName GroupName)
 {
 	ReplayUserHeaderDataMap.Add(GroupName, ReplayUserHeaderData);
@@ -795,20 +1435,21 @@ void UBloodStainSubsystem::ClearReplayUserHeaderData(const FName& GroupName)
 	ReplayUserHeaderDataMap.Remove(GroupName);
 }
 
-bool UBloodStainSubsystem::StartReplay_Standalone(const FRecordSaveData& RecordSaveData, const FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid)
+bool UBloodStainSubsystem::StartReplay_Standalone(const TSharedRef<const FRecordSaveData>& RecordSaveData, const FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid,
+	const FGuid& PlaybackKey)
 {
 	OutGuid = FGuid();
 
-	if (!RecordSaveData.IsValid())
+	if (!RecordSaveData->IsValid())
 	{
 		UE_LOG(LogBloodStain, Warning, TEXT("[BloodStain] StartReplay failed: RecordActor is not valid"));
 		return false;
 	}
 
-	const FRecordHeaderData& Header = RecordSaveData.Header;
-	const TArray<FRecordActorSaveData>& ActorDataArray = RecordSaveData.RecordActorDataArray;
+	const FRecordHeaderData& Header = RecordSaveData->Header;
+	const TArray<FRecordActorSaveData>& ActorDataArray = RecordSaveData->RecordActorDataArray;
 
-	const FGuid UniqueID = FGuid::NewGuid();
+	const FGuid UniqueID = PlaybackKey.IsValid() ? PlaybackKey : FGuid::NewGuid();
 	
 	FBloodStainPlaybackGroup BloodStainPlaybackGroup;
 
@@ -829,7 +1470,8 @@ bool UBloodStainSubsystem::StartReplay_Standalone(const FRecordSaveData& RecordS
 			continue;
 		}		
 		
-		GhostActor->InitializeReplayLocal(UniqueID, Header, ActorData, PlaybackOptions);
+		// Aliasing reference : keeps the whole recording alive while the ghost plays its entry
+		GhostActor->InitializeReplayLocal(UniqueID, Header, TSharedRef<const FRecordActorSaveData>(RecordSaveData, &ActorData), PlaybackOptions);
 		BloodStainPlaybackGroup.ActiveReplayers.Add(GhostActor);
 	}
 
@@ -845,9 +1487,9 @@ bool UBloodStainSubsystem::StartReplay_Standalone(const FRecordSaveData& RecordS
 
 bool UBloodStainSubsystem::StartReplay_Networked(APlayerController* RequestingController, const FString& FileName, const FString& LevelName,
 	const FBloodStainFileHeader& FileHeader, const FRecordHeaderData& RecordHeader,
-	const TArray<uint8>& CompressedPayload, const FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid)
+	const TArray<uint8>& CompressedPayload, const FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid, const FGuid& PlaybackKey)
 {
-	OutGuid = FGuid::NewGuid();
+	OutGuid = PlaybackKey.IsValid() ? PlaybackKey : FGuid::NewGuid();
 	
 	FActorSpawnParameters SpawnParams;
 	SpawnParams.Owner = RequestingController; 
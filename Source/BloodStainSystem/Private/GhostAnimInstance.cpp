@@ -20,7 +20,8 @@ void UGhostAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy)
 	delete InProxy;
 }
 
-void UGhostAnimInstance::SetTargetPose(const TArray<FTransform>& InPose)
+void UGhostAnimInstance::SetTargetPose(const TArray<FTransform>& InPose, const TArray<int32>& InBoneIndices)
 {
 	BonePose = InPose;
+	BoneIndices = InBoneIndices;
 }
\ No newline at end of file
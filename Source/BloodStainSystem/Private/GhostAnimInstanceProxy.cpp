@@ -16,22 +16,19 @@ bool FGhostAnimInstanceProxy::Evaluate(FPoseContext& Output)
 {
 	const FBoneContainer& BoneContainer = Output.AnimInstanceProxy->GetRequiredBones();
 	const TArray<FTransform>& SrcPose = GhostInstance->GetPose();
-	
-	const TArray<FBoneIndexType>& RequiredBoneIndices = BoneContainer.GetBoneIndicesArray();
+	const TArray<int32>& SrcBoneIndices = GhostInstance->GetBoneIndices();
 
-	for (int32 CompactIdx = 0; CompactIdx < RequiredBoneIndices.Num(); ++CompactIdx)
+	// Bones that were not recorded (bone mask / LOD-limited recording) keep the reference pose
+	Output.Pose.ResetToRefPose();
+
+	for (int32 PoseIndex = 0; PoseIndex < SrcPose.Num(); ++PoseIndex)
 	{
-		const int32 SkeletonIndex = RequiredBoneIndices[CompactIdx];
-		const FCompactPoseBoneIndex CompactIndex(CompactIdx);
+		const int32 MeshIndex = SrcBoneIndices.IsEmpty() ? PoseIndex : SrcBoneIndices[PoseIndex];
+		const FCompactPoseBoneIndex CompactIndex = BoneContainer.MakeCompactPoseIndex(FMeshPoseBoneIndex(MeshIndex));
 
-		if (SrcPose.IsValidIndex(SkeletonIndex) && Output.Pose.IsValidIndex(CompactIndex))
-		{
-			Output.Pose[CompactIndex] = SrcPose[SkeletonIndex];
-		}
-		// TODO : Need to Fix
-		else
+		if (CompactIndex.IsValid() && Output.Pose.IsValidIndex(CompactIndex))
 		{
-			Output.Pose[CompactIndex] = FTransform::Identity;
+			Output.Pose[CompactIndex] = SrcPose[PoseIndex];
 		}
 	}
 	return true;
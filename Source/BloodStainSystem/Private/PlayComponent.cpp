@@ -22,6 +22,7 @@
 #include "GroomComponent.h"
 #include "GroomAsset.h"
 #include "GhostAnimInstance.h"
+#include "Algo/BinarySearch.h"
 
 DECLARE_CYCLE_STAT(TEXT("PlayComp TickComponent"), STAT_PlayComponent_TickComponent, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("PlayComp Initialize"), STAT_PlayComponent_Initialize, STATGROUP_BloodStain);
@@ -35,7 +36,7 @@ DECLARE_CYCLE_STAT(TEXT("PlayComp BuildIntervalTree"), STAT_PlayComponent_BuildI
 DECLARE_CYCLE_STAT(TEXT("PlayComp QueryIntervalTree"), STAT_PlayComponent_QueryIntervalTree, STATGROUP_BloodStain);
 
 
-void UPlayComponent::Initialize(FGuid InPlaybackKey, const FRecordHeaderData& InRecordHeaderData, const FRecordActorSaveData& InReplayData, const FBloodStainPlaybackOptions& InPlaybackOptions)
+void UPlayComponent::Initialize(FGuid InPlaybackKey, const FRecordHeaderData& InRecordHeaderData, const TSharedRef<const FRecordActorSaveData>& InReplayData, const FBloodStainPlaybackOptions& InPlaybackOptions)
 {
 	SCOPE_CYCLE_COUNTER(STAT_PlayComponent_Initialize);
 	ReplayActor = GetOwner();
@@ -48,7 +49,7 @@ void UPlayComponent::Initialize(FGuid InPlaybackKey, const FRecordHeaderData& In
     PlaybackStartTime = GetWorld()->GetTimeSeconds();
 
 	TSet<FString> UniqueAssetPaths;
-	for (const FComponentActiveInterval& Interval : ReplayData.ComponentIntervals)
+	for (const FComponentActiveInterval& Interval : ReplayData->ComponentIntervals)
 	{
 		if (!Interval.Meta.AssetPath.IsEmpty())
 		{
@@ -85,14 +86,35 @@ void UPlayComponent::Initialize(FGuid InPlaybackKey, const FRecordHeaderData& In
     
 	UE_LOG(LogBloodStain, Log, TEXT("Pre-loaded %d unique assets."), AssetCache.Num());
 	
-	ReconstructedComponents.Empty();
-	for (const FComponentActiveInterval& Interval : ReplayData.ComponentIntervals)
+	// Component names are only needed to resolve attach parents and leader poses, playback itself is addressed by component ID
+	TMap<FString, int32> ComponentIdsByName;
+	for (const FComponentActiveInterval& Interval : ReplayData->ComponentIntervals)
 	{
-		if (USceneComponent* NewComp = CreateComponentFromRecord(Interval.Meta, AssetCache))
+		ComponentIdsByName.Add(Interval.Meta.ComponentName, Interval.Meta.ComponentId);
+	}
+
+	ReconstructedComponents.Reset();
+	ReconstructedComponents.SetNum(ReplayData->ComponentTracks.Num());
+	for (const FComponentActiveInterval& Interval : ReplayData->ComponentIntervals)
+	{
+		const int32 ComponentId = Interval.Meta.ComponentId;
+		if (!ReconstructedComponents.IsValidIndex(ComponentId))
+		{
+			UE_LOG(LogBloodStain, Warning, TEXT("Initialize: Invalid component id %d for interval: %s"), ComponentId, *Interval.Meta.ComponentName);
+			continue;
+		}
+
+		// A component re-attached during recording has several intervals but only one reconstructed component
+		if (ReconstructedComponents[ComponentId] != nullptr)
+		{
+			continue;
+		}
+		
+		if (USceneComponent* NewComp = CreateComponentFromRecord(Interval.Meta, AssetCache, ComponentIdsByName))
 		{
 			NewComp->SetVisibility(false);
 			NewComp->SetActive(false);
-			ReconstructedComponents.Add(Interval.Meta.ComponentName, NewComp);
+			ReconstructedComponents[ComponentId] = NewComp;
 			UE_LOG(LogBloodStain, Log, TEXT("Initialize: Component Added - %s"), *Interval.Meta.ComponentName);
 		}
 		else
@@ -101,14 +123,15 @@ void UPlayComponent::Initialize(FGuid InPlaybackKey, const FRecordHeaderData& In
 		}
 	}
 
-	for (const FComponentActiveInterval& Interval : ReplayData.ComponentIntervals)
+	for (const FComponentActiveInterval& Interval : ReplayData->ComponentIntervals)
 	{
 		if (!Interval.Meta.LeaderPoseComponentName.IsEmpty())
 		{
-			if (ReconstructedComponents.Contains(Interval.Meta.LeaderPoseComponentName) && ReconstructedComponents.Contains(Interval.Meta.ComponentName))
+			const int32* LeaderPoseComponentId = ComponentIdsByName.Find(Interval.Meta.LeaderPoseComponentName);
+			if (LeaderPoseComponentId != nullptr && ReconstructedComponents.IsValidIndex(*LeaderPoseComponentId) && ReconstructedComponents.IsValidIndex(Interval.Meta.ComponentId))
 			{
-				USceneComponent* LeaderPoseComponent = ReconstructedComponents[Interval.Meta.LeaderPoseComponentName];
-				USceneComponent* MeshComponent = ReconstructedComponents[Interval.Meta.ComponentName];
+				USceneComponent* LeaderPoseComponent = ReconstructedComponents[*LeaderPoseComponentId];
+				USceneComponent* MeshComponent = ReconstructedComponents[Interval.Meta.ComponentId];
 				USkeletalMeshComponent* LeaderPoseSkeletalComponent = Cast<USkeletalMeshComponent>(LeaderPoseComponent);
 				USkeletalMeshComponent* SkeletalMeshComponent = Cast<USkeletalMeshComponent>(MeshComponent);
 				
@@ -121,24 +144,69 @@ void UPlayComponent::Initialize(FGuid InPlaybackKey, const FRecordHeaderData& In
 	}
 	
 	SkelInfos.Reset();
-	for (auto& [ComponentName, Component] : ReconstructedComponents)
+	for (int32 ComponentId = 0; ComponentId < ReplayData->ComponentTracks.Num(); ++ComponentId)
+	{
+		if (USkeletalMeshComponent* Sk = Cast<USkeletalMeshComponent>(ReconstructedComponents[ComponentId]))
+		{
+			if (ReplayData->ComponentTracks[ComponentId].HasBones())
+			{
+				SkelInfos.Emplace(Sk, ComponentId);
+			}
+		}
+	}
+	VisibleComponents.Init(false, ReconstructedComponents.Num());
+
+	// Key timelines per track, a recording with keyframe reduction only holds keys at some frames
+	TrackKeyTimelines.Reset();
+	TrackKeyTimelines.SetNum(ReplayData->ComponentTracks.Num());
+	for (int32 FrameIndex = 0; FrameIndex < ReplayData->RecordedFrames.Num(); ++FrameIndex)
+	{
+		for (TConstSetBitIterator<> It(ReplayData->RecordedFrames[FrameIndex].RecordedTracks); It; ++It)
+		{
+			if (TrackKeyTimelines.IsValidIndex(It.GetIndex()))
+			{
+				TrackKeyTimelines[It.GetIndex()].KeyFrames.Add(FrameIndex);
+			}
+		}
+	}
+	for (FTrackKeyTimeline& Timeline : TrackKeyTimelines)
+	{
+		Timeline.SegmentStarts.Init(false, Timeline.KeyFrames.Num());
+	}
+	for (const FComponentActiveInterval& Interval : ReplayData->ComponentIntervals)
 	{
-		if (USkeletalMeshComponent* Sk = Cast<USkeletalMeshComponent>(Component))
+		if (Interval.StartFrame <= 0 || !TrackKeyTimelines.IsValidIndex(Interval.Meta.ComponentId))
+		{
+			continue;
+		}
+		
+		FTrackKeyTimeline& Timeline = TrackKeyTimelines[Interval.Meta.ComponentId];
+		const int32 KeyIndex = Algo::BinarySearch(Timeline.KeyFrames, Interval.StartFrame);
+		if (KeyIndex != INDEX_NONE)
 		{
-			SkelInfos.Emplace(Sk, *ComponentName);
+			Timeline.SegmentStarts[KeyIndex] = true;
 		}
 	}
 	
 	// Initialize the Interval Tree for querying active components at a specific point(frame) in time.
-	TArray<FComponentActiveInterval*> Ptrs;
-	for (FComponentActiveInterval& I : ReplayData.ComponentIntervals)
+	TArray<const FComponentActiveInterval*> Ptrs;
+	for (const FComponentActiveInterval& I : ReplayData->ComponentIntervals)
 	{
-		// I.EndFrame = FMath::Clamp(I.EndFrame, 0, ReplayData.RecordedFrames.Num() - 1);
+		// I.EndFrame = FMath::Clamp(I.EndFrame, 0, ReplayData->RecordedFrames.Num() - 1);
 		Ptrs.Add(&I);			
 	}
 	IntervalRoot = BuildIntervalTree(Ptrs);
 }
 
+void UPlayComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The interval tree points into the replay data
+	IntervalRoot.Reset();
+	ReplayData.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void UPlayComponent::FinishReplay() const
 {
 	SCOPE_CYCLE_COUNTER(STAT_PlayComponent_FinishReplay);
@@ -200,16 +268,21 @@ bool UPlayComponent::CalculatePlaybackTime(float& OutElapsedTime)
 
 void UPlayComponent::UpdatePlaybackToTime(float ElapsedTime)
 {
-	const TArray<FRecordFrame>& Frames = ReplayData.RecordedFrames;
+	if (!ReplayData.IsValid())
+	{
+		return;
+	}
+
+	const TArray<FRecordFrame>& Frames = ReplayData->RecordedFrames;
 	constexpr int32 MinFramesRequired = 2;
 	if (Frames.Num() < MinFramesRequired)
 	{
 		return;
 	}
 	
-	const bool bIsOutOfBounds = ReplayData.RecordedFrames.IsEmpty() || 
-							 ElapsedTime < ReplayData.RecordedFrames[0].TimeStamp || 
-							 ElapsedTime > ReplayData.RecordedFrames.Last().TimeStamp + RecordHeaderData.SamplingInterval;
+	const bool bIsOutOfBounds = ReplayData->RecordedFrames.IsEmpty() || 
+							 ElapsedTime < ReplayData->RecordedFrames[0].TimeStamp || 
+							 ElapsedTime > ReplayData->RecordedFrames.Last().TimeStamp + RecordHeaderData.SamplingInterval;
 
 	ReplayActor->SetActorHiddenInGame(bIsOutOfBounds);	
 	const int32 PreviousFrame = CurrentFrame;
@@ -227,17 +300,43 @@ void UPlayComponent::UpdatePlaybackToTime(float ElapsedTime)
 		SeekFrame(CurrentFrame);
 	}
 
-	// Interpolate between the current and next frames, then apply the transforms.
-	const FRecordFrame& Prev = Frames[CurrentFrame];
-	const FRecordFrame& Next = Frames[CurrentFrame + 1];
-    
-	const float FrameDuration = Next.TimeStamp - Prev.TimeStamp;
-	const float Alpha = (FrameDuration > KINDA_SMALL_NUMBER)
-		? FMath::Clamp((ElapsedTime - Prev.TimeStamp) / FrameDuration, 0.0f, 1.0f)
-		: 1.0f;
+	// Interpolate between the keys around the current frame, then apply the transforms.
+	ApplyComponentTransforms(ElapsedTime);
+	ApplySkeletalBoneTransforms(ElapsedTime);
+}
+
+bool UPlayComponent::FindTrackKeys(int32 ComponentId, float ElapsedTime, int32& OutPrevFrame, int32& OutNextFrame, float& OutAlpha) const
+{
+	const TArray<int32>& KeyFrames = TrackKeyTimelines[ComponentId].KeyFrames;
+	if (KeyFrames.IsEmpty())
+	{
+		return false;
+	}
+
+	OutAlpha = 0.f;
+	const int32 NextKey = Algo::UpperBound(KeyFrames, CurrentFrame);
+	if (NextKey == 0 || NextKey == KeyFrames.Num())
+	{
+		// Before the first or after the last key, hold it
+		OutPrevFrame = OutNextFrame = KeyFrames[FMath::Min(NextKey, KeyFrames.Num() - 1)];
+		return true;
+	}
 	
-	ApplyComponentTransforms(Prev, Next, Alpha);
-	ApplySkeletalBoneTransforms(Prev, Next, Alpha);
+	OutPrevFrame = KeyFrames[NextKey - 1];
+	OutNextFrame = KeyFrames[NextKey];
+	if (TrackKeyTimelines[ComponentId].SegmentStarts[NextKey])
+	{
+		// The component was detached in between, do not blend into its next attachment
+		OutNextFrame = OutPrevFrame;
+		return true;
+	}
+
+	const float PrevTime = ReplayData->RecordedFrames[OutPrevFrame].TimeStamp;
+	const float KeyDuration = ReplayData->RecordedFrames[OutNextFrame].TimeStamp - PrevTime;
+	OutAlpha = (KeyDuration > KINDA_SMALL_NUMBER)
+		? FMath::Clamp((ElapsedTime - PrevTime) / KeyDuration, 0.0f, 1.0f)
+		: 1.0f;
+	return true;
 }
 
 void UPlayComponent::ApplyMaterial(UMaterialInterface* InMaterial) const
@@ -250,7 +349,7 @@ void UPlayComponent::ApplyMaterial(UMaterialInterface* InMaterial) const
 	}
 
 	TSet<FString> UniqueAssetPaths;
-	for (const FComponentActiveInterval& Interval : ReplayData.ComponentIntervals)
+	for (const FComponentActiveInterval& Interval : ReplayData->ComponentIntervals)
 	{
 		if (!Interval.Meta.AssetPath.IsEmpty())
 		{
@@ -287,11 +386,20 @@ void UPlayComponent::ApplyMaterial(UMaterialInterface* InMaterial) const
     
 	UE_LOG(LogBloodStain, Log, TEXT("Pre-loaded %d unique assets."), AssetCache.Num());
 	
-	for (const FComponentActiveInterval& Interval : ReplayData.ComponentIntervals)
+	for (const FComponentActiveInterval& Interval : ReplayData->ComponentIntervals)
 	{
 		const FComponentRecord& Record = Interval.Meta;
 
-		UMeshComponent* MeshComponent = FindObject<UMeshComponent>(Owner, *Record.ComponentName);
+		if (!ReconstructedComponents.IsValidIndex(Record.ComponentId))
+		{
+			continue;
+		}
+		
+		UMeshComponent* MeshComponent = Cast<UMeshComponent>(ReconstructedComponents[Record.ComponentId]);
+		if (MeshComponent == nullptr)
+		{
+			continue;
+		}
 		
 		// Apply materials in order.
 		for (int32 MatIndex = 0; MatIndex < Record.MaterialPaths.Num(); ++MatIndex)
@@ -354,62 +462,66 @@ FGuid UPlayComponent::GetPlaybackKey() const
 	return PlaybackKey;
 }
 
-void UPlayComponent::ApplyComponentTransforms(const FRecordFrame& Prev, const FRecordFrame& Next, float Alpha) const
+void UPlayComponent::ApplyComponentTransforms(float ElapsedTime) const
 {
 	SCOPE_CYCLE_COUNTER(STAT_PlayComponent_ApplyComponentTransforms);
 
 	// Interpolate transforms for all components in the current frame in local space.
-	for (const auto& Pair : Next.RelativeTransforms)
+	for (int32 ComponentId = 0; ComponentId < ReconstructedComponents.Num(); ++ComponentId)
 	{
-		const FString& ComponentName = Pair.Key;
-		const FTransform& NextT = Pair.Value;
-		
+		USceneComponent* TargetComponent = ReconstructedComponents[ComponentId];
+		int32 PrevFrame, NextFrame;
+		float Alpha;
+		if (!TargetComponent || !FindTrackKeys(ComponentId, ElapsedTime, PrevFrame, NextFrame, Alpha))
+		{
+			continue;
+		}
 		
-		if (USceneComponent* TargetComponent = ReconstructedComponents.FindRef(ComponentName))
+		const FTransform& NextT = ReplayData->RecordedFrames[NextFrame].ComponentTransforms[ComponentId];
+		if (PrevFrame != NextFrame)
 		{
-			if (const FTransform* PrevT = Prev.RelativeTransforms.Find(ComponentName))
-			{
-				FVector Loc = FMath::Lerp(PrevT->GetLocation(), NextT.GetLocation(), Alpha);
-				FQuat Rot = FQuat::Slerp(PrevT->GetRotation(), NextT.GetRotation(), Alpha);
-				FVector Scale = FMath::Lerp(PrevT->GetScale3D(), NextT.GetScale3D(), Alpha);
+			const FTransform& PrevT = ReplayData->RecordedFrames[PrevFrame].ComponentTransforms[ComponentId];
+			FVector Loc = FMath::Lerp(PrevT.GetLocation(), NextT.GetLocation(), Alpha);
+			FQuat Rot = FQuat::Slerp(PrevT.GetRotation(), NextT.GetRotation(), Alpha);
+			FVector Scale = FMath::Lerp(PrevT.GetScale3D(), NextT.GetScale3D(), Alpha);
 
-				FTransform InterpT(Rot, Loc, Scale);
-				TargetComponent->SetRelativeTransform(InterpT);
-			}
-			else
-			{
-				TargetComponent->SetRelativeTransform(NextT);
-			}
+			FTransform InterpT(Rot, Loc, Scale);
+			TargetComponent->SetRelativeTransform(InterpT);
+		}
+		else
+		{
+			TargetComponent->SetRelativeTransform(NextT);
 		}
 	}
 }
 
-void UPlayComponent::ApplySkeletalBoneTransforms(const FRecordFrame& Prev, const FRecordFrame& Next, float Alpha) const
+void UPlayComponent::ApplySkeletalBoneTransforms(float ElapsedTime) const
 {
 	SCOPE_CYCLE_COUNTER(STAT_PlayComponent_ApplySkeletalBoneTransforms);
 
 	for (const FSkelReplayInfo& Info : SkelInfos)
 	{
-		const FBoneComponentSpace* PrevBones = Prev.SkeletalMeshBoneTransforms.Find(Info.ComponentName);
-		const FBoneComponentSpace* NextBones = Next.SkeletalMeshBoneTransforms.Find(Info.ComponentName);
-		if (!PrevBones || !NextBones)
+		int32 PrevFrame, NextFrame;
+		float Alpha;
+		if (!FindTrackKeys(Info.ComponentId, ElapsedTime, PrevFrame, NextFrame, Alpha))
 		{
 			continue;
 		}
 
-		const int32 NumBones = FMath::Min(PrevBones->BoneTransforms.Num(),NextBones->BoneTransforms.Num());
-		if (NumBones == 0)
-		{
-			continue;
-		}
+		const FRecordFrame& Prev = ReplayData->RecordedFrames[PrevFrame];
+		const FRecordFrame& Next = ReplayData->RecordedFrames[NextFrame];
+		const FRecordComponentTrack& Track = ReplayData->ComponentTracks[Info.ComponentId];
+		const int32 NumBones = Track.NumBones;
+		const FTransform* PrevBones = Prev.BoneTransforms.GetData() + Track.BoneOffset;
+		const FTransform* NextBones = Next.BoneTransforms.GetData() + Track.BoneOffset;
 
 		TArray<FTransform> OutPose;
 		OutPose.SetNumUninitialized(NumBones);
 
 		for (int32 i = 0; i < NumBones; ++i)
 		{
-			const FTransform& P = PrevBones->BoneTransforms[i];
-			const FTransform& N = NextBones->BoneTransforms[i];
+			const FTransform& P = PrevBones[i];
+			const FTransform& N = NextBones[i];
 
 			OutPose[i].SetTranslation(FMath::Lerp(P.GetLocation(), N.GetLocation(), Alpha));
 			OutPose[i].SetRotation(FQuat::FastLerp(P.GetRotation(), N.GetRotation(), Alpha).GetNormalized());
@@ -418,7 +530,7 @@ void UPlayComponent::ApplySkeletalBoneTransforms(const FRecordFrame& Prev, const
 
 		if (auto* GhostAnim = Cast<UGhostAnimInstance>(Info.Component->GetAnimInstance()))
 		{
-			GhostAnim->SetTargetPose(OutPose);
+			GhostAnim->SetTargetPose(OutPose, Track.BoneIndices);
 		}
 	}
 }
@@ -427,9 +539,10 @@ void UPlayComponent::ApplySkeletalBoneTransforms(const FRecordFrame& Prev, const
 /**
  * @brief Creates a mesh component based on an FComponentRecord and registers it with the world.
  * @param Record Information about the component to be created.
+ * @param ComponentIdsByName Component IDs of this replay, used to resolve the attach parent.
  * @return The created component on success, nullptr on failure.
  */	
-USceneComponent* UPlayComponent::CreateComponentFromRecord(const FComponentRecord& Record, const TMap<FString, TObjectPtr<UObject>>& AssetCache) const
+USceneComponent* UPlayComponent::CreateComponentFromRecord(const FComponentRecord& Record, const TMap<FString, TObjectPtr<UObject>>& AssetCache, const TMap<FString, int32>& ComponentIdsByName) const
 {
 	SCOPE_CYCLE_COUNTER(STAT_PlayComponent_CreateComponentFromRecord);
 	AActor* Owner = GetOwner();
@@ -473,7 +586,10 @@ USceneComponent* UPlayComponent::CreateComponentFromRecord(const FComponentRecor
 			//GroomComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 		}
 		
-		GroomComp->SetRelativeTransform(ReplayData.RecordedFrames[0].RelativeTransforms[Record.ComponentName]);
+		if (ReplayData->RecordedFrames[0].HasTrack(Record.ComponentId))
+		{
+			GroomComp->SetRelativeTransform(ReplayData->RecordedFrames[0].ComponentTransforms[Record.ComponentId]);
+		}
 		NewComponent = GroomComp;
 	}
 	else
@@ -585,7 +701,9 @@ USceneComponent* UPlayComponent::CreateComponentFromRecord(const FComponentRecor
 	}
 	else
 	{
-		if (USceneComponent* ParentComponent = ReconstructedComponents.FindRef(Record.AttachParentComponentName))
+		const int32 ParentComponentId = ComponentIdsByName.FindRef(Record.AttachParentComponentName, INDEX_NONE);
+		USceneComponent* ParentComponent = ReconstructedComponents.IsValidIndex(ParentComponentId) ? ReconstructedComponents[ParentComponentId].Get() : nullptr;
+		if (ParentComponent != nullptr)
 		{
 			NewComponent->AttachToComponent(ParentComponent, FAttachmentTransformRules::KeepRelativeTransform, FName(Record.AttachSocketName));
 		}
@@ -606,31 +724,33 @@ USceneComponent* UPlayComponent::CreateComponentFromRecord(const FComponentRecor
 void UPlayComponent::SeekFrame(int32 FrameIndex)
 {
 	SCOPE_CYCLE_COUNTER(STAT_PlayComponent_SeekFrame);
-	if (FrameIndex < 0 || FrameIndex >= ReplayData.RecordedFrames.Num())
+	if (FrameIndex < 0 || FrameIndex >= ReplayData->RecordedFrames.Num())
 	{
 		UE_LOG(LogBloodStain, Warning, TEXT("SeekToFrame: TargetFrame %d is out of bounds."), FrameIndex);
 		return;
 	}
 
-	TArray<FComponentActiveInterval*> AliveComps;
+	TArray<const FComponentActiveInterval*> AliveComps;
 	QueryIntervalTree(IntervalRoot.Get(), FrameIndex, AliveComps);
 
-	TMap<FString, bool> AliveComponentMap;
+	VisibleComponents.SetRange(0, VisibleComponents.Num(), false);
 	for (const FComponentActiveInterval* Interval : AliveComps)
 	{
-		AliveComponentMap.Add(Interval->Meta.ComponentName, Interval->Meta.bVisible);
+		if (VisibleComponents.IsValidIndex(Interval->Meta.ComponentId))
+		{
+			VisibleComponents[Interval->Meta.ComponentId] = Interval->Meta.bVisible;
+		}
 	}
 
 	// Iterate through all pre-created components and update their state.
-	for (auto& Pair : ReconstructedComponents)
+	for (int32 ComponentId = 0; ComponentId < ReconstructedComponents.Num(); ++ComponentId)
 	{
-		const FString& ComponentName = Pair.Key;
-		USceneComponent* Component = Pair.Value;
+		USceneComponent* Component = ReconstructedComponents[ComponentId];
 
 		if (!Component) continue;
 		
 		// Check if the component should be active at the current frame.
-		const bool bShouldBeActive = AliveComponentMap.Contains(ComponentName) ? AliveComponentMap[ComponentName] : false;
+		const bool bShouldBeActive = VisibleComponents[ComponentId];
 		const bool bIsCurrentlyActive = Component->IsVisible();
 		
 		// Only call functions if the state needs to change.
@@ -645,7 +765,7 @@ void UPlayComponent::SeekFrame(int32 FrameIndex)
 /**
  * Assumes a balanced binary tree. Classifies intervals into left/right of the center and builds the tree.
  */
-TUniquePtr<FIntervalTreeNode> UPlayComponent::BuildIntervalTree(const TArray<FComponentActiveInterval*>& InComponentIntervals)
+TUniquePtr<FIntervalTreeNode> UPlayComponent::BuildIntervalTree(const TArray<const FComponentActiveInterval*>& InComponentIntervals)
 {
 	SCOPE_CYCLE_COUNTER(STAT_PlayComponent_BuildIntervalTree);
 	if (InComponentIntervals.Num() == 0)
@@ -655,7 +775,7 @@ TUniquePtr<FIntervalTreeNode> UPlayComponent::BuildIntervalTree(const TArray<FCo
 
 	// Determine the center point of the intervals as the median.
 	TArray<int32> Endpoints;
-	for (FComponentActiveInterval* I : InComponentIntervals)
+	for (const FComponentActiveInterval* I : InComponentIntervals)
 	{
 		Endpoints.Add(I->StartFrame);
 		Endpoints.Add(I->EndFrame);
@@ -663,10 +783,10 @@ TUniquePtr<FIntervalTreeNode> UPlayComponent::BuildIntervalTree(const TArray<FCo
 	Endpoints.Sort();
 	int32 Mid = Endpoints[Endpoints.Num()/2];
 
-	TArray<FComponentActiveInterval*> LeftList, RightList;
+	TArray<const FComponentActiveInterval*> LeftList, RightList;
 	TUniquePtr<FIntervalTreeNode> Node = MakeUnique<FIntervalTreeNode>();
 	Node->Center = Mid;
-	for (FComponentActiveInterval* I : InComponentIntervals)
+	for (const FComponentActiveInterval* I : InComponentIntervals)
 	{
 		// Only add intervals that overlap the Mid to this node; classify non-overlapping ones for left/right children.
 		if (I->EndFrame < Mid)
@@ -688,7 +808,7 @@ TUniquePtr<FIntervalTreeNode> UPlayComponent::BuildIntervalTree(const TArray<FCo
 	return Node;
 }
 
-void UPlayComponent::QueryIntervalTree(FIntervalTreeNode* Node, int32 FrameIndex, TArray<FComponentActiveInterval*>& OutComponentIntervals)
+void UPlayComponent::QueryIntervalTree(FIntervalTreeNode* Node, int32 FrameIndex, TArray<const FComponentActiveInterval*>& OutComponentIntervals)
 {
 	SCOPE_CYCLE_COUNTER(STAT_PlayComponent_QueryIntervalTree);
 	if (!Node)
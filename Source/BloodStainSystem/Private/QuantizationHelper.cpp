@@ -4,94 +4,96 @@
 
 #include "QuantizationHelper.h"
 #include "BloodStainFileUtils.h"
+#include "BloodStainRecordDataUtils.h"
+#include "BloodStainSystem.h"
 #include "BloodStainFileOptions.h"
 #include "QuantizationTypes.h"
+#include "Algo/Count.h"
 
 namespace BloodStainFileUtils_Internal
 {
 
+namespace
+{
+    /** Grows the location/scale range to include the transform, initializing it on first use */
+    void ExpandRange(FLocRange& LocRange, FScaleRange& ScaleRange, const FTransform& Transform, bool& bIsInitialized)
+    {
+        const FVector Loc = Transform.GetLocation();
+        const FVector Scale = Transform.GetScale3D();
+
+        if (!bIsInitialized)
+        {
+            LocRange.PosMin = LocRange.PosMax = Loc;
+            ScaleRange.ScaleMin = ScaleRange.ScaleMax = Scale;
+            bIsInitialized = true;
+            return;
+        }
+
+        LocRange.PosMin = LocRange.PosMin.ComponentMin(Loc);
+        LocRange.PosMax = LocRange.PosMax.ComponentMax(Loc);
+        ScaleRange.ScaleMin = ScaleRange.ScaleMin.ComponentMin(Scale);
+        ScaleRange.ScaleMax = ScaleRange.ScaleMax.ComponentMax(Scale);
+    }
+}
+
 void ComputeRanges(FRecordSaveData& SaveData)
 {
     for (FRecordActorSaveData& ActorData : SaveData.RecordActorDataArray)
     {
-        ActorData.BoneRanges.Empty();
-        ActorData.BoneScaleRanges.Empty();
-        ActorData.ComponentRanges = FLocRange();
-        bool bIsComponentRangeInitialized  = false;
-        bool bIsComponentScaleRangeInitialized = false; 
-        for (const FRecordFrame& Frame : ActorData.RecordedFrames)
-        {
-            for (const auto& Pair : Frame.SkeletalMeshBoneTransforms)
-            {
-                const FString& BoneKey = Pair.Key;
-                const FBoneComponentSpace& Space = Pair.Value;
-                FLocRange& R = ActorData.BoneRanges.FindOrAdd(BoneKey);
-                FScaleRange& ScaleRange = ActorData.BoneScaleRanges.FindOrAdd(BoneKey);
-
-                bool bIsFirst = (R.PosMin.IsNearlyZero() && R.PosMax.IsNearlyZero());
-                if (bIsFirst && Space.BoneTransforms.Num() > 0)
-                {
-                    R.PosMin = R.PosMax = Space.BoneTransforms[0].GetLocation();
-                }
+        ComputeActorRanges(ActorData);
+    }
+}
 
-                for (const FTransform& BoneT : Space.BoneTransforms)
-                {
-                    const FVector Loc = BoneT.GetLocation();
-                    R.PosMin = R.PosMin.ComponentMin(Loc);
-                    R.PosMax = R.PosMax.ComponentMax(Loc);
-                }
-                
-                bool bIsFirstScale = (ScaleRange.ScaleMin.IsNearlyZero() && ScaleRange.ScaleMax.IsNearlyZero());
+void ComputeActorRanges(FRecordActorSaveData& ActorData)
+{
+    const int32 NumTracks = ActorData.ComponentTracks.Num();
 
-                if (bIsFirstScale && Space.BoneTransforms.Num() > 0)
-                {
-                    ScaleRange.ScaleMin = ScaleRange.ScaleMax = Space.BoneTransforms[0].GetScale3D();
-                }
+    ActorData.ComponentRanges = FLocRange();
+    ActorData.ComponentScaleRanges = FScaleRange();
+    ActorData.BoneRanges.Init(FLocRange(), NumTracks);
+    ActorData.BoneScaleRanges.Init(FScaleRange(), NumTracks);
 
-                for (const FTransform& BoneT : Space.BoneTransforms)
-                {
-                    const FVector Scale = BoneT.GetScale3D();
-                    ScaleRange.ScaleMin = ScaleRange.ScaleMin.ComponentMin(Scale);
-                    ScaleRange.ScaleMax = ScaleRange.ScaleMax.ComponentMax(Scale);
-                }
-            }
-            
-            for (const auto& Pair : Frame.RelativeTransforms)
+    bool bIsComponentRangeInitialized = false;
+    TBitArray<> BoneRangeInitialized(false, NumTracks);
+
+    for (const FRecordFrame& Frame : ActorData.RecordedFrames)
+    {
+        for (int32 TrackIndex = 0; TrackIndex < NumTracks; ++TrackIndex)
+        {
+            if (!Frame.HasTrack(TrackIndex))
             {
-                const FTransform& ComponentT = Pair.Value;
-                const FVector Loc = ComponentT.GetLocation();
-                const FVector Scale = ComponentT.GetScale3D();
+                continue;
+            }
 
-                if (!bIsComponentRangeInitialized)
-                {
-                    ActorData.ComponentRanges.PosMin = ActorData.ComponentRanges.PosMax = Loc;
-                    bIsComponentRangeInitialized = true;
-                }
-                else
-                {
-                    ActorData.ComponentRanges.PosMin = ActorData.ComponentRanges.PosMin.ComponentMin(Loc);
-                    ActorData.ComponentRanges.PosMax = ActorData.ComponentRanges.PosMax.ComponentMax(Loc);
-                }
+            ExpandRange(ActorData.ComponentRanges, ActorData.ComponentScaleRanges, Frame.ComponentTransforms[TrackIndex], bIsComponentRangeInitialized);
 
-                if (!bIsComponentScaleRangeInitialized)
-                {
-                    ActorData.ComponentScaleRanges.ScaleMin = ActorData.ComponentScaleRanges.ScaleMax = Scale;
-                    bIsComponentScaleRangeInitialized = true;
-                }
-                else
-                {
-                    ActorData.ComponentScaleRanges.ScaleMin = ActorData.ComponentScaleRanges.ScaleMin.ComponentMin(Scale);
-                    ActorData.ComponentScaleRanges.ScaleMax = ActorData.ComponentScaleRanges.ScaleMax.ComponentMax(Scale);
-                }
+            const FRecordComponentTrack& Track = ActorData.ComponentTracks[TrackIndex];
+            if (!Track.HasBones())
+            {
+                continue;
+            }
+
+            bool bIsBoneRangeInitialized = BoneRangeInitialized[TrackIndex];
+            for (int32 BoneIndex = 0; BoneIndex < Track.NumBones; ++BoneIndex)
+            {
+                ExpandRange(ActorData.BoneRanges[TrackIndex], ActorData.BoneScaleRanges[TrackIndex], Frame.BoneTransforms[Track.BoneOffset + BoneIndex], bIsBoneRangeInitialized);
             }
+            BoneRangeInitialized[TrackIndex] = bIsBoneRangeInitialized;
         }
     }
-    
 }
-void SerializeQuantizedTransform(FArchive& Ar, const FTransform& Transform, const ETransformQuantizationMethod& QuantOpts, const FLocRange* LocRange, const FScaleRange* ScaleRange)
+
+void SerializeQuantizedTransform(FArchive& Ar, const FTransform& Transform, const ETransformQuantizationMethod& QuantOpts, const FLocRange* LocRange, const FScaleRange* ScaleRange, int32 RotationBits)
 {
     switch (QuantOpts)
     {
+    case ETransformQuantizationMethod::SmallestThree:
+        {
+            const int32 ComponentBits = FQuatSmallestThree::GetComponentBits(RotationBits);
+            FQuantizedTransform_SmallestThree Q(Transform, ComponentBits);
+            Q.Serialize(Ar, ComponentBits);
+        }
+        break;
     case ETransformQuantizationMethod::Standard_High:
         {
             FQuantizedTransform_High Q(Transform);
@@ -121,10 +123,17 @@ void SerializeQuantizedTransform(FArchive& Ar, const FTransform& Transform, cons
     }
 }
 
-FTransform DeserializeQuantizedTransform(FArchive& Ar, const ETransformQuantizationMethod& Opts, const FLocRange* LocRange, const FScaleRange* ScaleRange)
+FTransform DeserializeQuantizedTransform(FArchive& Ar, const ETransformQuantizationMethod& Opts, const FLocRange* LocRange, const FScaleRange* ScaleRange, int32 RotationBits)
 {
     switch (Opts)
     {
+    case ETransformQuantizationMethod::SmallestThree:
+        {
+            const int32 ComponentBits = FQuatSmallestThree::GetComponentBits(RotationBits);
+            FQuantizedTransform_SmallestThree Q;
+            Q.Serialize(Ar, ComponentBits);
+            return Q.ToTransform(ComponentBits);
+        }
     case ETransformQuantizationMethod::Standard_High:
         {
             FQuantizedTransform_High Q;
@@ -152,140 +161,841 @@ FTransform DeserializeQuantizedTransform(FArchive& Ar, const ETransformQuantizat
     }
 }
 
-void SerializeSaveData(FArchive& RawAr, FRecordSaveData& SaveData, ETransformQuantizationMethod& QuantOpts)
+int32 FBloodStainStringTable::Add(const FString& String)
+{
+    if (const int32* Index = Indices.Find(String))
+    {
+        return *Index;
+    }
+    return Indices.Add(String, Strings.Add(String));
+}
+
+void FBloodStainStringTable::Serialize(FArchive& Ar, FString& String)
+{
+    int32 Index = Ar.IsSaving() ? Add(String) : INDEX_NONE;
+    Ar << Index;
+    if (Ar.IsLoading())
+    {
+        if (Strings.IsValidIndex(Index))
+        {
+            String = Strings[Index];
+        }
+        else
+        {
+            Ar.SetError();
+        }
+    }
+}
+
+namespace
+{
+    void SerializeComponentIntervals(FArchive& Ar, TArray<FComponentActiveInterval>& Intervals, FBloodStainStringTable& StringTable)
+    {
+        int32 NumIntervals = Intervals.Num();
+        Ar << NumIntervals;
+        if (Ar.IsLoading())
+        {
+            if (NumIntervals < 0 || NumIntervals > Ar.TotalSize())
+            {
+                Ar.SetError();
+                return;
+            }
+            Intervals.SetNum(NumIntervals);
+        }
+
+        for (FComponentActiveInterval& Interval : Intervals)
+        {
+            FComponentRecord& Meta = Interval.Meta;
+            Ar << Meta.ComponentId;
+            StringTable.Serialize(Ar, Meta.ComponentName);
+            StringTable.Serialize(Ar, Meta.AttachParentComponentName);
+            StringTable.Serialize(Ar, Meta.AttachSocketName);
+            StringTable.Serialize(Ar, Meta.ComponentClassPath);
+            StringTable.Serialize(Ar, Meta.AssetPath);
+
+            int32 NumMaterials = Meta.MaterialPaths.Num();
+            Ar << NumMaterials;
+            if (Ar.IsLoading())
+            {
+                if (NumMaterials < 0 || NumMaterials > Ar.TotalSize())
+                {
+                    Ar.SetError();
+                    return;
+                }
+                Meta.MaterialPaths.SetNum(NumMaterials);
+            }
+            for (FString& MaterialPath : Meta.MaterialPaths)
+            {
+                StringTable.Serialize(Ar, MaterialPath);
+            }
+
+            Ar << Meta.MaterialParameters;
+            StringTable.Serialize(Ar, Meta.LeaderPoseComponentName);
+            Ar << Meta.bVisible;
+            Ar << Interval.StartFrame;
+            Ar << Interval.EndFrame;
+        }
+    }
+}
+
+void SerializeActorMetadata(FArchive& Ar, FRecordActorSaveData& ActorData, FBloodStainStringTable* StringTable)
+{
+    Ar << ActorData.PrimaryComponentId;
+    if (StringTable != nullptr)
+    {
+        SerializeComponentIntervals(Ar, ActorData.ComponentIntervals, *StringTable);
+    }
+    else
+    {
+        Ar << ActorData.ComponentIntervals;
+    }
+    Ar << ActorData.ComponentTracks;
+    Ar << ActorData.ComponentRanges;
+    Ar << ActorData.ComponentScaleRanges;
+    Ar << ActorData.BoneRanges;
+    Ar << ActorData.BoneScaleRanges;
+}
+
+namespace
+{
+    void WriteVarInt(FArchive& Ar, int64 Value)
+    {
+        // Zig-zag mapping, small negative values become small unsigned values
+        uint64 Bits = (static_cast<uint64>(Value) << 1) ^ static_cast<uint64>(Value >> 63);
+        do
+        {
+            uint8 Byte = Bits & 0x7f;
+            Bits >>= 7;
+            if (Bits != 0)
+            {
+                Byte |= 0x80;
+            }
+            Ar << Byte;
+        }
+        while (Bits != 0);
+    }
+
+    int64 ReadVarInt(FArchive& Ar)
+    {
+        uint64 Bits = 0;
+        for (int32 Shift = 0; Shift < 64 && !Ar.IsError(); Shift += 7)
+        {
+            uint8 Byte = 0;
+            Ar << Byte;
+            Bits |= static_cast<uint64>(Byte & 0x7f) << Shift;
+            if ((Byte & 0x80) == 0)
+            {
+                return static_cast<int64>(Bits >> 1) ^ -static_cast<int64>(Bits & 1);
+            }
+        }
+        Ar.SetError();
+        return 0;
+    }
+
+    /**
+     * Codec of the samples of one transform block (a track or one of its bones).
+     * Without a delta encoding, samples are quantized one by one (SerializeQuantizedTransform).
+     * With one, samples are quantized to integers with the steps of the quantized transform of the method and stored as
+     * zig-zag varint residuals from a prediction (previous sample, or linear extrapolation of the two previous ones).
+     * Every KeyframeInterval samples, a keyframe stores the full sample so decoding errors do not accumulate.
+     */
+    class FTransformBlockCodec
+    {
+    public:
+        FTransformBlockCodec(const FBloodStainFileOptions& Options, const FLocRange* InLocRange, const FScaleRange* InScaleRange)
+            : QuantOpts(Options.QuantizationOption)
+            , Encoding(Options.QuantizationOption == ETransformQuantizationMethod::None ? ETransformEncodingMethod::None : Options.EncodingOption)
+            , KeyframeInterval(FMath::Max(Options.KeyframeInterval, 1))
+            , RotationBits(Options.RotationBits)
+            , LocRange(InLocRange)
+            , ScaleRange(InScaleRange)
+        {
+            // Location and scale steps of FVector_NetQuantize100 / FVector_NetQuantize10
+            LocStep = FVector(0.01);
+            ScaleStep = FVector(0.1);
+
+            switch (QuantOpts)
+            {
+            case ETransformQuantizationMethod::Standard_Medium:
+                // FQuatFixed32NoW : 11 / 11 / 10 bits
+                SetRotationScale(Quant11BitFactor, Quant11BitFactor, Quant10BitFactor);
+                break;
+            case ETransformQuantizationMethod::Standard_Low:
+                {
+                    // FVectorIntervalFixed32NoW over the ranges of the block, Range / Factor per step (10 / 11 / 11 bits)
+                    const FVector Factors(Quant10BitFactor, Quant11BitFactor, Quant11BitFactor);
+                    LocOrigin = LocRange->PosMin;
+                    LocStep = (LocRange->PosMax - LocRange->PosMin).ComponentMax(FVector(KINDA_SMALL_NUMBER)) / Factors;
+                    ScaleOrigin = ScaleRange->ScaleMin;
+                    ScaleStep = (ScaleRange->ScaleMax - ScaleRange->ScaleMin).ComponentMax(FVector(KINDA_SMALL_NUMBER)) / Factors;
+                    SetRotationScale(Quant11BitFactor, Quant11BitFactor, Quant10BitFactor);
+                }
+                break;
+            case ETransformQuantizationMethod::SmallestThree:
+                // The rotation channels hold the packed fields of FQuatSmallestThree, see Quantize
+                ComponentBits = FQuatSmallestThree::GetComponentBits(RotationBits);
+                break;
+            case ETransformQuantizationMethod::Standard_High:
+            default:
+                // FQuatFixed48NoW : 16 bits per component
+                SetRotationScale(Quant16BitFactor, Quant16BitFactor, Quant16BitFactor);
+                break;
+            }
+        }
+
+        void Write(FArchive& Ar, const FTransform& Transform)
+        {
+            if (Encoding == ETransformEncodingMethod::None)
+            {
+                SerializeQuantizedTransform(Ar, Transform, QuantOpts, LocRange, ScaleRange, RotationBits);
+                return;
+            }
+
+            FChannels Values;
+            Quantize(Transform, Values);
+
+            // The first rotation channel is stored first, the decoder needs it to know if the sample is a keyframe
+            FChannels Prediction;
+            Predict(Prediction);
+            WriteVarInt(Ar, Values[RotationChannel] - Prediction[RotationChannel]);
+            if (StartsKeyframe(Values[RotationChannel]))
+            {
+                SamplesSinceKeyframe = 0;
+                Predict(Prediction);
+            }
+
+            for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+            {
+                if (Channel != RotationChannel)
+                {
+                    WriteVarInt(Ar, Values[Channel] - Prediction[Channel]);
+                }
+            }
+            Advance(Values);
+        }
+
+        FTransform Read(FArchive& Ar)
+        {
+            if (Encoding == ETransformEncodingMethod::None)
+            {
+                return DeserializeQuantizedTransform(Ar, QuantOpts, LocRange, ScaleRange, RotationBits);
+            }
+
+            FChannels Values;
+            Predict(Values);
+            const int64 FirstRotationValue = Values[RotationChannel] + ReadVarInt(Ar);
+            if (StartsKeyframe(FirstRotationValue))
+            {
+                SamplesSinceKeyframe = 0;
+                Predict(Values);
+            }
+            Values[RotationChannel] = FirstRotationValue;
+
+            for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+            {
+                if (Channel != RotationChannel)
+                {
+                    Values[Channel] += ReadVarInt(Ar);
+                }
+            }
+            Advance(Values);
+            return Dequantize(Values);
+        }
+
+        /** Writes all samples of the block, without delta encoding SmallestThree rotations are bit-packed together */
+        void WriteBlock(FArchive& Ar, TConstArrayView<FTransform> Samples)
+        {
+            if (!IsBatchedSmallestThree())
+            {
+                for (const FTransform& Sample : Samples)
+                {
+                    Write(Ar, Sample);
+                }
+                return;
+            }
+
+            // Location and scale of each sample, then the rotations of the whole block
+            TArray<FQuat4f> Rotations;
+            Rotations.Reserve(Samples.Num());
+            for (const FTransform& Sample : Samples)
+            {
+                FVector_NetQuantize100 Location(Sample.GetLocation());
+                FVector_NetQuantize10 Scale(Sample.GetScale3D());
+                Ar << Location;
+                Ar << Scale;
+                Rotations.Add(FQuat4f(Sample.GetRotation()));
+            }
+
+            TArray<uint8> RotationBytes;
+            FQuatSmallestThree::EncodeBatch(Rotations, ComponentBits, RotationBytes);
+            Ar.Serialize(RotationBytes.GetData(), RotationBytes.Num());
+        }
+
+        /** Reads back OutSamples.Num() samples written by WriteBlock */
+        void ReadBlock(FArchive& Ar, TArrayView<FTransform> OutSamples)
+        {
+            if (!IsBatchedSmallestThree())
+            {
+                for (FTransform& Sample : OutSamples)
+                {
+                    Sample = Read(Ar);
+                }
+                return;
+            }
+
+            for (FTransform& Sample : OutSamples)
+            {
+                FVector_NetQuantize100 Location;
+                FVector_NetQuantize10 Scale;
+                Ar << Location;
+                Ar << Scale;
+                Sample.SetLocation(Location);
+                Sample.SetScale3D(Scale);
+            }
+
+            const int32 NumBytes = FQuatSmallestThree::GetBatchNumBytes(OutSamples.Num(), ComponentBits);
+            if (Ar.IsError() || NumBytes > Ar.TotalSize() - Ar.Tell())
+            {
+                Ar.SetError();
+                return;
+            }
+
+            TArray<uint8> RotationBytes;
+            RotationBytes.SetNumUninitialized(NumBytes);
+            Ar.Serialize(RotationBytes.GetData(), NumBytes);
+
+            TArray<FQuat4f> Rotations;
+            Rotations.SetNumUninitialized(OutSamples.Num());
+            FQuatSmallestThree::DecodeBatch(RotationBytes, ComponentBits, Rotations);
+            for (int32 Index = 0; Index < OutSamples.Num(); ++Index)
+            {
+                OutSamples[Index].SetRotation(FQuat(Rotations[Index]));
+            }
+        }
+
+    private:
+        /**
+         * Location XYZ, rotation, scale XYZ.
+         * The rotation is XYZW, or with SmallestThree the dropped component index and the three others as packed by FQuatSmallestThree.
+         */
+        static constexpr int32 NumChannels = 10;
+        static constexpr int32 RotationChannel = 3;
+        static constexpr int32 ScaleChannel = 7;
+        using FChannels = int64[NumChannels];
+
+        /** W is stored with the precision of X so the rotation keeps its sign between samples */
+        void SetRotationScale(double X, double Y, double Z)
+        {
+            RotScale[0] = X;
+            RotScale[1] = Y;
+            RotScale[2] = Z;
+            RotScale[3] = X;
+        }
+
+        bool IsSmallestThree() const
+        {
+            return QuantOpts == ETransformQuantizationMethod::SmallestThree;
+        }
+
+        bool IsBatchedSmallestThree() const
+        {
+            return IsSmallestThree() && Encoding == ETransformEncodingMethod::None;
+        }
+
+        /** With SmallestThree, a change of the dropped component makes the three others discontinuous, the sample becomes a keyframe */
+        bool StartsKeyframe(int64 FirstRotationValue) const
+        {
+            return IsSmallestThree() && SamplesSinceKeyframe != 0 && FirstRotationValue != Previous[RotationChannel];
+        }
+
+        void Quantize(const FTransform& Transform, FChannels& OutValues) const
+        {
+            const FVector Location = Transform.GetLocation();
+            const FQuat Rotation = Transform.GetRotation().GetNormalized();
+            const FVector Scale = Transform.GetScale3D();
+
+            for (int32 Axis = 0; Axis < 3; ++Axis)
+            {
+                OutValues[Axis] = FMath::RoundToInt64((Location[Axis] - LocOrigin[Axis]) / LocStep[Axis]);
+                OutValues[ScaleChannel + Axis] = FMath::RoundToInt64((Scale[Axis] - ScaleOrigin[Axis]) / ScaleStep[Axis]);
+            }
+
+            if (IsSmallestThree())
+            {
+                // The dropped component is made positive, so the three others are continuous as long as it does not change
+                const FQuatSmallestThree Packed(FQuat4f(Rotation), ComponentBits);
+                const uint64 Mask = (1ull << ComponentBits) - 1;
+                OutValues[RotationChannel] = static_cast<int64>(Packed.Packed & 3);
+                for (int32 Index = 0; Index < 3; ++Index)
+                {
+                    OutValues[RotationChannel + 1 + Index] = static_cast<int64>((Packed.Packed >> (2 + Index * ComponentBits)) & Mask);
+                }
+                return;
+            }
+
+            // Q and -Q are the same rotation : keyframes keep W positive, the other samples keep the hemisphere of the
+            // previous one so the prediction does not see a sign flip when W crosses 0
+            const double Components[4] = { Rotation.X, Rotation.Y, Rotation.Z, Rotation.W };
+            double Dot = 0.0;
+            for (int32 Index = 0; Index < 4; ++Index)
+            {
+                Dot += Components[Index] * Previous[RotationChannel + Index] / RotScale[Index];
+            }
+            const bool bFlip = SamplesSinceKeyframe == 0 ? Rotation.W < 0.0 : Dot < 0.0;
+            for (int32 Index = 0; Index < 4; ++Index)
+            {
+                OutValues[RotationChannel + Index] = FMath::RoundToInt64((bFlip ? -Components[Index] : Components[Index]) * RotScale[Index]);
+            }
+        }
+
+        FTransform Dequantize(const FChannels& Values) const
+        {
+            FVector Location;
+            FVector Scale;
+            for (int32 Axis = 0; Axis < 3; ++Axis)
+            {
+                Location[Axis] = LocOrigin[Axis] + Values[Axis] * LocStep[Axis];
+                Scale[Axis] = ScaleOrigin[Axis] + Values[ScaleChannel + Axis] * ScaleStep[Axis];
+            }
+
+            if (IsSmallestThree())
+            {
+                // Masked so corrupted residuals cannot overflow into the neighbouring fields
+                const uint64 Mask = (1ull << ComponentBits) - 1;
+                FQuatSmallestThree Packed;
+                Packed.Packed = static_cast<uint64>(Values[RotationChannel]) & 3;
+                for (int32 Index = 0; Index < 3; ++Index)
+                {
+                    Packed.Packed |= (static_cast<uint64>(Values[RotationChannel + 1 + Index]) & Mask) << (2 + Index * ComponentBits);
+                }
+                return FTransform(FQuat(Packed.ToQuat(ComponentBits)), Location, Scale);
+            }
+
+            const FQuat Rotation(
+                Values[RotationChannel] / RotScale[0],
+                Values[RotationChannel + 1] / RotScale[1],
+                Values[RotationChannel + 2] / RotScale[2],
+                Values[RotationChannel + 3] / RotScale[3]);
+
+            return FTransform(Rotation.GetNormalized(), Location, Scale);
+        }
+
+        void Predict(FChannels& OutPrediction) const
+        {
+            for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+            {
+                if (SamplesSinceKeyframe == 0)
+                {
+                    OutPrediction[Channel] = 0;
+                }
+                else if (Encoding == ETransformEncodingMethod::LinearPrediction && SamplesSinceKeyframe >= 2)
+                {
+                    OutPrediction[Channel] = 2 * Previous[Channel] - BeforePrevious[Channel];
+                }
+                else
+                {
+                    OutPrediction[Channel] = Previous[Channel];
+                }
+            }
+        }
+
+        void Advance(const FChannels& Values)
+        {
+            FMemory::Memcpy(BeforePrevious, Previous, sizeof(FChannels));
+            FMemory::Memcpy(Previous, Values, sizeof(FChannels));
+            SamplesSinceKeyframe = (SamplesSinceKeyframe + 1) % KeyframeInterval;
+        }
+
+        ETransformQuantizationMethod QuantOpts;
+        ETransformEncodingMethod Encoding;
+        int32 KeyframeInterval;
+        int32 RotationBits;
+        const FLocRange* LocRange;
+        const FScaleRange* ScaleRange;
+
+        FVector LocOrigin = FVector::ZeroVector;
+        FVector LocStep;
+        double RotScale[4] = {};
+        int32 ComponentBits = 0;
+        FVector ScaleOrigin = FVector::ZeroVector;
+        FVector ScaleStep;
+
+        FChannels Previous = {};
+        FChannels BeforePrevious = {};
+        int32 SamplesSinceKeyframe = 0;
+    };
+}
+
+void SerializeActorFrames(FArchive& RawAr, FRecordActorSaveData& ActorData, const FBloodStainFileOptions& Options)
+{
+    int32 NumFrames = ActorData.RecordedFrames.Num();
+    RawAr << NumFrames;
+
+    for (FRecordFrame& Frame : ActorData.RecordedFrames)
+    {
+        RawAr << Frame.TimeStamp;
+        RawAr << Frame.FrameIndex;
+        RawAr << Frame.RecordedTracks;
+    }
+
+    // Track-major transform blocks : all samples of a track (and of each of its bones) are stored contiguously
+    // Static tracks and bones only store the sample of their first key
+    TArray<FTransform> BlockSamples;
+    for (int32 TrackIndex = 0; TrackIndex < ActorData.ComponentTracks.Num(); ++TrackIndex)
+    {
+        const FRecordComponentTrack& Track = ActorData.ComponentTracks[TrackIndex];
+        const int32 FirstKeyFrame = ActorData.RecordedFrames.IndexOfByPredicate([TrackIndex](const FRecordFrame& Frame) { return Frame.HasTrack(TrackIndex); });
+        if (FirstKeyFrame == INDEX_NONE)
+        {
+            continue;
+        }
+
+        FTransformBlockCodec ComponentCodec(Options, &ActorData.ComponentRanges, &ActorData.ComponentScaleRanges);
+        if (Track.bStaticTransform)
+        {
+            ComponentCodec.Write(RawAr, ActorData.RecordedFrames[FirstKeyFrame].ComponentTransforms[TrackIndex]);
+        }
+        else
+        {
+            BlockSamples.Reset();
+            for (const FRecordFrame& Frame : ActorData.RecordedFrames)
+            {
+                if (Frame.HasTrack(TrackIndex))
+                {
+                    BlockSamples.Add(Frame.ComponentTransforms[TrackIndex]);
+                }
+            }
+            ComponentCodec.WriteBlock(RawAr, BlockSamples);
+        }
+
+        for (int32 BoneIndex = 0; BoneIndex < Track.NumBones; ++BoneIndex)
+        {
+            FTransformBlockCodec BoneCodec(Options, &ActorData.BoneRanges[TrackIndex], &ActorData.BoneScaleRanges[TrackIndex]);
+            if (Track.IsStaticBone(BoneIndex))
+            {
+                BoneCodec.Write(RawAr, ActorData.RecordedFrames[FirstKeyFrame].BoneTransforms[Track.BoneOffset + BoneIndex]);
+                continue;
+            }
+
+            BlockSamples.Reset();
+            for (const FRecordFrame& Frame : ActorData.RecordedFrames)
+            {
+                if (Frame.HasTrack(TrackIndex))
+                {
+                    BlockSamples.Add(Frame.BoneTransforms[Track.BoneOffset + BoneIndex]);
+                }
+            }
+            BoneCodec.WriteBlock(RawAr, BlockSamples);
+        }
+    }
+}
+
+void SerializeSaveData(FArchive& RawAr, FRecordSaveData& SaveData, const FBloodStainFileOptions& Options)
 {
     ComputeRanges(SaveData);
 
+    // Single-blob payloads are never delta encoded
+    FBloodStainFileOptions BlobOptions = Options;
+    BlobOptions.EncodingOption = ETransformEncodingMethod::None;
+
     int32 NumActors = SaveData.RecordActorDataArray.Num();
     RawAr << NumActors;
 
     for (FRecordActorSaveData& ActorData : SaveData.RecordActorDataArray)
     {
-        RawAr << ActorData.PrimaryComponentName;
-        RawAr << ActorData.ComponentIntervals;
-        RawAr << ActorData.ComponentRanges;
-        RawAr << ActorData.ComponentScaleRanges;
-        RawAr << ActorData.BoneRanges;
-        RawAr << ActorData.BoneScaleRanges;        
+        SerializeActorMetadata(RawAr, ActorData);
+        SerializeActorFrames(RawAr, ActorData, BlobOptions);
+    }
+}
 
-        int32 NumFrames = ActorData.RecordedFrames.Num();
-        RawAr << NumFrames;
+void SerializeFrameBlock(FArchive& RawAr, FRecordActorSaveData& Block, const FBloodStainFileOptions& Options)
+{
+    ComputeActorRanges(Block);
+    SerializeActorMetadata(RawAr, Block);
+    SerializeActorFrames(RawAr, Block, Options);
+}
 
-        for (FRecordFrame& Frame : ActorData.RecordedFrames)
+bool DeserializeFrameBlock(FArchive& DataAr, FRecordActorSaveData& OutBlock, const FBloodStainFileOptions& Options)
+{
+    SerializeActorMetadata(DataAr, OutBlock);
+    return !DataAr.IsError() && DeserializeActorFrames(DataAr, OutBlock, Options);
+}
+
+namespace
+{
+    /** Reads the EBloodStainFileVersion::Initial payload (per-frame maps keyed by component name) into the component ID layout */
+    bool DeserializeSaveData_Initial(FArchive& DataAr, FRecordSaveData& OutData, const ETransformQuantizationMethod& QuantOpts)
+    {
+        int32 NumActors = 0;
+        DataAr << NumActors;
+        OutData.RecordActorDataArray.Empty(NumActors);
+
+        for (int32 i = 0; i < NumActors; ++i)
         {
-            RawAr << Frame.TimeStamp;
-            RawAr << Frame.FrameIndex;
+            FRecordActorSaveData& ActorData = OutData.RecordActorDataArray.AddDefaulted_GetRef();
+            TMap<FString, FLocRange> BoneRangeMap;
+            TMap<FString, FScaleRange> BoneScaleRangeMap;
 
-            // Component's Local Transforms
-            int32 NumComps = Frame.RelativeTransforms.Num();
-            RawAr << NumComps;
-            for (auto& Pair : Frame.RelativeTransforms)
+            FName PrimaryComponentName;
+            DataAr << PrimaryComponentName;
+
+            // Initial intervals carry no component ID, only the name-keyed metadata
+            int32 NumIntervals = 0;
+            DataAr << NumIntervals;
+            if (NumIntervals < 0 || DataAr.IsError())
             {
-                RawAr << Pair.Key;
+                return false;
+            }
+            ActorData.ComponentIntervals.SetNum(NumIntervals);
+            for (FComponentActiveInterval& Interval : ActorData.ComponentIntervals)
+            {
+                FComponentRecord::SerializeMetadata(DataAr, Interval.Meta);
+                DataAr << Interval.StartFrame;
+                DataAr << Interval.EndFrame;
+            }
+
+            DataAr << ActorData.ComponentRanges;
+            DataAr << ActorData.ComponentScaleRanges;
+            DataAr << BoneRangeMap;
+            DataAr << BoneScaleRangeMap;
 
-                const FLocRange* Range = &ActorData.ComponentRanges;
-                const FScaleRange* ScaleRange = &ActorData.ComponentScaleRanges;
-                if (ensure(Range && ScaleRange))
+            // Names are interned into component IDs in order of first appearance
+            TMap<FString, int32> ComponentIdMap;
+            int32 NumTrackBones = 0;
+            auto FindOrAddTrack = [&ActorData, &ComponentIdMap](const FString& Key)
+            {
+                if (const int32* ComponentId = ComponentIdMap.Find(Key))
                 {
-                    SerializeQuantizedTransform(RawAr, Pair.Value, QuantOpts, Range, ScaleRange);
+                    return *ComponentId;
                 }
+                return ComponentIdMap.Add(Key, ActorData.ComponentTracks.AddDefaulted());
+            };
+
+            for (FComponentActiveInterval& Interval : ActorData.ComponentIntervals)
+            {
+                Interval.Meta.ComponentId = FindOrAddTrack(Interval.Meta.ComponentName);
+            }
+            if (!PrimaryComponentName.IsNone())
+            {
+                ActorData.PrimaryComponentId = FindOrAddTrack(PrimaryComponentName.ToString());
             }
 
-            // Skeletal Mesh Component's BoneTransforms
-            int32 NumBoneMaps = Frame.SkeletalMeshBoneTransforms.Num();
-            RawAr << NumBoneMaps;
-            for (auto& BonePair : Frame.SkeletalMeshBoneTransforms)
+            int32 NumFrames = 0;
+            DataAr << NumFrames;
+            if (NumFrames < 0 || DataAr.IsError())
             {
-                RawAr << BonePair.Key;
+                return false;
+            }
+            ActorData.RecordedFrames.SetNum(NumFrames);
 
-                const FBoneComponentSpace& Space = BonePair.Value;
-                int32 BoneCount = Space.BoneTransforms.Num();
-                RawAr << BoneCount;
+            for (FRecordFrame& Frame : ActorData.RecordedFrames)
+            {
+                DataAr << Frame.TimeStamp;
+                DataAr << Frame.FrameIndex;
 
-                const FLocRange* Range = ActorData.BoneRanges.Find(BonePair.Key);
-                const FScaleRange* ScaleRange = ActorData.BoneScaleRanges.Find(BonePair.Key);
-                if (ensure(Range && ScaleRange))
+                // Component's Local Transforms
+                int32 NumComps = 0;
+                DataAr << NumComps;
+                for (int32 c = 0; c < NumComps && !DataAr.IsError(); ++c)
                 {
-                    for (const FTransform& BoneT : Space.BoneTransforms)
+                    FString Key;
+                    DataAr << Key;
+                    const int32 TrackIndex = FindOrAddTrack(Key);
+                    if (Frame.ComponentTransforms.Num() <= TrackIndex)
                     {
-                        SerializeQuantizedTransform(RawAr, BoneT, QuantOpts, Range, ScaleRange);
+                        Frame.ComponentTransforms.SetNum(TrackIndex + 1);
+                        Frame.RecordedTracks.SetNum(TrackIndex + 1, false);
                     }
+                    Frame.ComponentTransforms[TrackIndex] = DeserializeQuantizedTransform(DataAr, QuantOpts, &ActorData.ComponentRanges, &ActorData.ComponentScaleRanges);
+                    Frame.RecordedTracks[TrackIndex] = true;
+                }
+
+                // Skeletal Mesh Component's Bone Transforms
+                int32 NumBoneMaps = 0;
+                DataAr << NumBoneMaps;
+                for (int32 bm = 0; bm < NumBoneMaps && !DataAr.IsError(); ++bm)
+                {
+                    FString Key;
+                    int32 BoneCount = 0;
+                    DataAr << Key;
+                    DataAr << BoneCount;
+
+                    const FLocRange* Range = BoneRangeMap.Find(Key);
+                    const FScaleRange* ScaleRange = BoneScaleRangeMap.Find(Key);
+                    if (QuantOpts == ETransformQuantizationMethod::Standard_Low && (!Range || !ScaleRange))
+                    {
+                        UE_LOG(LogBloodStain, Error, TEXT("[BS] Missing bone range for %s"), *Key);
+                        return false;
+                    }
+
+                    const int32 TrackIndex = FindOrAddTrack(Key);
+                    FRecordComponentTrack& Track = ActorData.ComponentTracks[TrackIndex];
+                    if (!Track.HasBones())
+                    {
+                        Track.BoneOffset = NumTrackBones;
+                        Track.NumBones = BoneCount;
+                        NumTrackBones += BoneCount;
+                    }
+                    if (Frame.BoneTransforms.Num() < NumTrackBones)
+                    {
+                        Frame.BoneTransforms.SetNum(NumTrackBones);
+                    }
+
+                    for (int32 b = 0; b < BoneCount; ++b)
+                    {
+                        const FTransform BoneT = DeserializeQuantizedTransform(DataAr, QuantOpts, Range, ScaleRange);
+                        if (b < Track.NumBones)
+                        {
+                            Frame.BoneTransforms[Track.BoneOffset + b] = BoneT;
+                        }
+                    }
+                }
+
+                if (DataAr.IsError())
+                {
+                    return false;
+                }
+            }
+
+            ActorData.BoneRanges.SetNum(ActorData.ComponentTracks.Num());
+            ActorData.BoneScaleRanges.SetNum(ActorData.ComponentTracks.Num());
+            for (const auto& [Key, TrackIndex] : ComponentIdMap)
+            {
+                if (const FLocRange* Range = BoneRangeMap.Find(Key))
+                {
+                    ActorData.BoneRanges[TrackIndex] = *Range;
+                }
+                if (const FScaleRange* ScaleRange = BoneScaleRangeMap.Find(Key))
+                {
+                    ActorData.BoneScaleRanges[TrackIndex] = *ScaleRange;
                 }
             }
+
+            BloodStainRecordDataUtils::NormalizeFrameLayout(ActorData);
         }
+
+        return !DataAr.IsError();
     }
-    
 }
 
-void DeserializeSaveData(FArchive& DataAr, FRecordSaveData& OutData, const ETransformQuantizationMethod& QuantOpts)
+bool DeserializeActorFrames(FArchive& DataAr, FRecordActorSaveData& ActorData, const FBloodStainFileOptions& Options)
 {
+    const int32 NumTracks = ActorData.ComponentTracks.Num();
+    const int32 NumTrackBones = ActorData.GetNumTrackBones();
+
+    int32 NumFrames = 0;
+    DataAr << NumFrames;
+    if (NumFrames < 0 || ActorData.BoneRanges.Num() != NumTracks || ActorData.BoneScaleRanges.Num() != NumTracks || DataAr.IsError())
+    {
+        return false;
+    }
+    ActorData.RecordedFrames.SetNum(NumFrames);
+
+    for (FRecordFrame& Frame : ActorData.RecordedFrames)
+    {
+        DataAr << Frame.TimeStamp;
+        DataAr << Frame.FrameIndex;
+        DataAr << Frame.RecordedTracks;
+
+        Frame.RecordedTracks.SetNum(NumTracks, false);
+        Frame.ComponentTransforms.SetNum(NumTracks);
+        Frame.BoneTransforms.SetNum(NumTrackBones);
+    }
+
+    // Static tracks and bones are expanded into every keyed frame here, so playback does not need to know about them
+    TArray<FTransform> BlockSamples;
+    for (int32 TrackIndex = 0; TrackIndex < NumTracks && !DataAr.IsError(); ++TrackIndex)
+    {
+        const FRecordComponentTrack& Track = ActorData.ComponentTracks[TrackIndex];
+        const int32 NumKeys = static_cast<int32>(Algo::CountIf(ActorData.RecordedFrames, [TrackIndex](const FRecordFrame& Frame) { return Frame.HasTrack(TrackIndex); }));
+        if (NumKeys == 0)
+        {
+            continue;
+        }
+
+        FTransformBlockCodec ComponentCodec(Options, &ActorData.ComponentRanges, &ActorData.ComponentScaleRanges);
+        if (Track.bStaticTransform)
+        {
+            BlockSamples.Init(ComponentCodec.Read(DataAr), NumKeys);
+        }
+        else
+        {
+            BlockSamples.SetNum(NumKeys);
+            ComponentCodec.ReadBlock(DataAr, BlockSamples);
+        }
+
+        int32 KeyIndex = 0;
+        for (FRecordFrame& Frame : ActorData.RecordedFrames)
+        {
+            if (Frame.HasTrack(TrackIndex))
+            {
+                Frame.ComponentTransforms[TrackIndex] = BlockSamples[KeyIndex++];
+            }
+        }
+
+        for (int32 BoneIndex = 0; BoneIndex < Track.NumBones; ++BoneIndex)
+        {
+            FTransformBlockCodec BoneCodec(Options, &ActorData.BoneRanges[TrackIndex], &ActorData.BoneScaleRanges[TrackIndex]);
+            if (Track.IsStaticBone(BoneIndex))
+            {
+                BlockSamples.Init(BoneCodec.Read(DataAr), NumKeys);
+            }
+            else
+            {
+                BlockSamples.SetNum(NumKeys);
+                BoneCodec.ReadBlock(DataAr, BlockSamples);
+            }
+
+            KeyIndex = 0;
+            for (FRecordFrame& Frame : ActorData.RecordedFrames)
+            {
+                if (Frame.HasTrack(TrackIndex))
+                {
+                    Frame.BoneTransforms[Track.BoneOffset + BoneIndex] = BlockSamples[KeyIndex++];
+                }
+            }
+        }
+    }
+
+    return !DataAr.IsError();
+}
+
+bool DeserializeSaveData(FArchive& DataAr, FRecordSaveData& OutData, const FBloodStainFileHeader& FileHeader)
+{
+    const ETransformQuantizationMethod QuantOpts = FileHeader.Options.QuantizationOption;
+
+    if (FileHeader.Version == EBloodStainFileVersion::Initial)
+    {
+        return DeserializeSaveData_Initial(DataAr, OutData, QuantOpts);
+    }
+
+    // Section table containers store their actor data with the BoneMasks layout, section by section (see BloodStainFileUtils::DecodePayload)
+    if (!FBloodStainFileHeader::IsSupportedVersion(FileHeader.Version))
+    {
+        UE_LOG(LogBloodStain, Error, TEXT("[BS] Not a BloodStain file or unsupported version %u"), FileHeader.Version);
+        return false;
+    }
+
+    FBloodStainFileOptions BlobOptions = FileHeader.Options;
+    BlobOptions.EncodingOption = ETransformEncodingMethod::None;
+
     int32 NumActors = 0;
     DataAr << NumActors;
     OutData.RecordActorDataArray.Empty(NumActors);
 
     for (int32 i = 0; i < NumActors; ++i)
     {
-        FRecordActorSaveData ActorData;
-        DataAr << ActorData.PrimaryComponentName;
-        DataAr << ActorData.ComponentIntervals;
-        DataAr << ActorData.ComponentRanges;
-        DataAr << ActorData.ComponentScaleRanges;
-        DataAr << ActorData.BoneRanges;
-        DataAr << ActorData.BoneScaleRanges;
-
-        int32 NumFrames = 0;
-        DataAr << NumFrames;
-        ActorData.RecordedFrames.Empty(NumFrames);
-
-        for (int32 f = 0; f < NumFrames; ++f)
-        {
-            FRecordFrame Frame;
-            DataAr << Frame.TimeStamp;
-            DataAr << Frame.FrameIndex; 
-
-            // Component's Local Transforms
-            int32 NumComps = 0;
-            DataAr << NumComps;
-            for (int32 c = 0; c < NumComps; ++c)
-            {
-                FString Key;
-                DataAr << Key;
-                const FLocRange* Range = &ActorData.ComponentRanges;
-                const FScaleRange* ScaleRange = &ActorData.ComponentScaleRanges;
-                FTransform T = DeserializeQuantizedTransform(DataAr, QuantOpts, Range, ScaleRange);
-                Frame.RelativeTransforms.Add(Key, T);
-            }
-
-            // Skeletal Mesh Component's Bone Transforms
-            int32 NumBoneMaps = 0;
-            DataAr << NumBoneMaps;
-            for (int32 bm = 0; bm < NumBoneMaps; ++bm)
-            {
-                FString Key;
-                int32 BoneCount = 0;
-                
-                DataAr << Key;                
-                DataAr << BoneCount;
-                
-                FBoneComponentSpace Space;
-                Space.BoneTransforms.Empty(BoneCount);
-                
-                const FLocRange* Range = ActorData.BoneRanges.Find(Key);
-                const FScaleRange* ScaleRange = ActorData.BoneScaleRanges.Find(Key);
-                
-                for (int32 b = 0; b < BoneCount; ++b)
-                {
-                    FTransform BoneT = DeserializeQuantizedTransform(DataAr, QuantOpts, Range, ScaleRange);
-                    Space.BoneTransforms.Add(BoneT);
-                }
-                Frame.SkeletalMeshBoneTransforms.Add(Key, Space);
-            }
+        FRecordActorSaveData& ActorData = OutData.RecordActorDataArray.AddDefaulted_GetRef();
+        SerializeActorMetadata(DataAr, ActorData);
 
-            ActorData.RecordedFrames.Add(Frame);
+        if (!DeserializeActorFrames(DataAr, ActorData, BlobOptions))
+        {
+            UE_LOG(LogBloodStain, Error, TEXT("[BS] Corrupted actor data (actor %d)"), i);
+            return false;
         }
-
-        OutData.RecordActorDataArray.Add(ActorData);
     }
+
+    return !DataAr.IsError();
 }
 
 } // namespace BloodStainFileUtils_Internal
@@ -81,4 +81,114 @@ FTransform FQuantizedTransform_Lowest::ToTransform(const FLocRange& Range, const
 	Out.SetScale3D(FVector(S3f));
 
 	return Out;
+}
+
+FQuatSmallestThree::FQuatSmallestThree(const FQuat4f& Quat, int32 ComponentBits)
+{
+	const FQuat4f Q = Quat.GetNormalized();
+	const float Components[4] = { Q.X, Q.Y, Q.Z, Q.W };
+
+	int32 LargestIndex = 0;
+	for (int32 Index = 1; Index < 4; ++Index)
+	{
+		if (FMath::Abs(Components[Index]) > FMath::Abs(Components[LargestIndex]))
+		{
+			LargestIndex = Index;
+		}
+	}
+
+	// Q and -Q are the same rotation, the dropped component is made positive
+	const float Sign = Components[LargestIndex] < 0.f ? -1.f : 1.f;
+	const float MaxValue = static_cast<float>((1 << ComponentBits) - 1);
+
+	Packed = static_cast<uint64>(LargestIndex);
+	int32 Shift = 2;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		if (Index == LargestIndex)
+		{
+			continue;
+		}
+
+		const float Normalized = FMath::Clamp((Components[Index] * Sign * UE_SQRT_2 + 1.f) * 0.5f, 0.f, 1.f);
+		Packed |= static_cast<uint64>(FMath::RoundToInt(Normalized * MaxValue)) << Shift;
+		Shift += ComponentBits;
+	}
+}
+
+FQuat4f FQuatSmallestThree::ToQuat(int32 ComponentBits) const
+{
+	const uint64 Mask = (1ull << ComponentBits) - 1;
+	const float MaxValue = static_cast<float>(Mask);
+	const int32 LargestIndex = static_cast<int32>(Packed & 3);
+
+	float Components[4];
+	float SumSquares = 0.f;
+	int32 Shift = 2;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		if (Index == LargestIndex)
+		{
+			continue;
+		}
+
+		const float Normalized = static_cast<float>((Packed >> Shift) & Mask) / MaxValue;
+		Components[Index] = (Normalized * 2.f - 1.f) * UE_INV_SQRT_2;
+		SumSquares += Components[Index] * Components[Index];
+		Shift += ComponentBits;
+	}
+	Components[LargestIndex] = FMath::Sqrt(FMath::Max(1.f - SumSquares, 0.f));
+
+	return FQuat4f(Components[0], Components[1], Components[2], Components[3]).GetNormalized();
+}
+
+void FQuatSmallestThree::EncodeBatch(TConstArrayView<FQuat4f> Quats, int32 ComponentBits, TArray<uint8>& OutBytes)
+{
+	const int32 QuatBits = 2 + 3 * ComponentBits;
+	const int32 StartIndex = OutBytes.Num();
+	OutBytes.AddZeroed(GetBatchNumBytes(Quats.Num(), ComponentBits));
+	uint8* Data = OutBytes.GetData() + StartIndex;
+
+	int64 BitOffset = 0;
+	for (const FQuat4f& Quat : Quats)
+	{
+		const uint64 Packed = FQuatSmallestThree(Quat, ComponentBits).Packed;
+		for (int32 Written = 0; Written < QuatBits;)
+		{
+			const int64 Bit = BitOffset + Written;
+			const int32 BitInByte = static_cast<int32>(Bit & 7);
+			const int32 Count = FMath::Min(8 - BitInByte, QuatBits - Written);
+			Data[Bit >> 3] |= static_cast<uint8>(((Packed >> Written) & ((1u << Count) - 1)) << BitInByte);
+			Written += Count;
+		}
+		BitOffset += QuatBits;
+	}
+}
+
+bool FQuatSmallestThree::DecodeBatch(TConstArrayView<uint8> Bytes, int32 ComponentBits, TArrayView<FQuat4f> OutQuats)
+{
+	if (Bytes.Num() < GetBatchNumBytes(OutQuats.Num(), ComponentBits))
+	{
+		return false;
+	}
+
+	const int32 QuatBits = 2 + 3 * ComponentBits;
+	const uint8* Data = Bytes.GetData();
+
+	int64 BitOffset = 0;
+	for (FQuat4f& Quat : OutQuats)
+	{
+		FQuatSmallestThree Packed;
+		for (int32 Read = 0; Read < QuatBits;)
+		{
+			const int64 Bit = BitOffset + Read;
+			const int32 BitInByte = static_cast<int32>(Bit & 7);
+			const int32 Count = FMath::Min(8 - BitInByte, QuatBits - Read);
+			Packed.Packed |= static_cast<uint64>((Data[Bit >> 3] >> BitInByte) & ((1u << Count) - 1)) << Read;
+			Read += Count;
+		}
+		Quat = Packed.ToQuat(ComponentBits);
+		BitOffset += QuatBits;
+	}
+	return true;
 }
\ No newline at end of file
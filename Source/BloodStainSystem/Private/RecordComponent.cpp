@@ -10,6 +10,7 @@
 #include "GhostData.h"
 #include "Engine/StaticMesh.h"
 #include "Engine/SkeletalMesh.h"
+#include "Rendering/SkeletalMeshRenderData.h"
 #include "Engine/GameInstance.h"
 #include "Engine/World.h"
 #include "Components/StaticMeshComponent.h"
@@ -20,10 +21,14 @@
 #include "GroomComponent.h"
 #include "GroomAsset.h"
 
-DECLARE_CYCLE_STAT(TEXT("RecordComp TickComponent"), STAT_RecordComponent_TickComponent, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("RecordComp BeginSample"), STAT_RecordComponent_BeginSample, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("RecordComp CaptureSample"), STAT_RecordComponent_CaptureSample, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("RecordComp CaptureRagdollBones"), STAT_RecordComponent_CaptureRagdollBones, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp Initialize"), STAT_RecordComponent_Initialize, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp CollectSceneComponents"), STAT_RecordComponent_CollectSceneComponents, STATGROUP_BloodStain);
-DECLARE_CYCLE_STAT(TEXT("RecordComp SaveQueuedFrames"), STAT_RecordComponent_CookQueuedFrames, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("RecordComp DetachRecordData"), STAT_RecordComponent_DetachRecordData, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("RecordComp SnapshotRecordData"), STAT_RecordComponent_SnapshotRecordData, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("RecordComp FlushStreamBlock"), STAT_RecordComponent_FlushStreamBlock, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp OnComponentAttached"), STAT_RecordComponent_OnComponentAttached, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp OnComponentDetached"), STAT_RecordComponent_OnComponentDetached, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp FillMaterialData"), STAT_RecordComponent_FillMaterialData, STATGROUP_BloodStain);
@@ -31,87 +36,140 @@ DECLARE_CYCLE_STAT(TEXT("RecordComp CreateRecordFromMesh"), STAT_RecordComponent
 DECLARE_CYCLE_STAT(TEXT("RecordComp HandleAttachedChanges"), STAT_RecordComponent_HandleAttachedChanges, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp HandleAttachedChangesByBit"), STAT_RecordComponent_HandleAttachedChangesByBit, STATGROUP_BloodStain);
 DECLARE_CYCLE_STAT(TEXT("RecordComp HandleSceneComponentChangesByBit"), STAT_RecordComponent_HandleSceneComponentChangesByBit, STATGROUP_BloodStain);
+DECLARE_CYCLE_STAT(TEXT("RecordComp HasScannedHierarchyChanged"), STAT_RecordComponent_HasScannedHierarchyChanged, STATGROUP_BloodStain);
+
+namespace
+{
+	/**
+	 * Reference pose of a mesh bone, identity if the current mesh does not have it.
+	 * Written for the bones of a track the mesh no longer provides (mesh swap, LOD change), as a reused slab slot still holds an older frame.
+	 */
+	FTransform GetReferenceBoneTransform(const USkeletalMeshComponent* SkeletalComp, int32 MeshBoneIndex)
+	{
+		const USkeletalMesh* SkeletalMesh = SkeletalComp->GetSkeletalMeshAsset();
+		if (SkeletalMesh == nullptr)
+		{
+			return FTransform::Identity;
+		}
+
+		const TArray<FTransform>& RefBonePose = SkeletalMesh->GetRefSkeleton().GetRefBonePose();
+		return RefBonePose.IsValidIndex(MeshBoneIndex) ? RefBonePose[MeshBoneIndex] : FTransform::Identity;
+	}
+}
 
 URecordComponent::URecordComponent()
 	: StartTime(0), MaxRecordFrames(0), CurrentFrameIndex(0), TimeSinceLastRecord(0)
 {
-	PrimaryComponentTick.bCanEverTick = true;
+	// Sampling is driven by UBloodStainRecordSampler, which records every active recorder in one batch
+	PrimaryComponentTick.bCanEverTick = false;
 }
 
-void URecordComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+bool URecordComponent::AdvanceSampleClock(float DeltaTime)
 {
-	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_TickComponent);
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	
+	PendingSampleSlot = INDEX_NONE;
 	TimeSinceLastRecord += DeltaTime;
-	if (TimeSinceLastRecord >= RecordOptions.SamplingInterval)
+	return TimeSinceLastRecord >= CurrentSamplingInterval;
+}
+
+void URecordComponent::SetSamplePhase(float PhaseFraction)
+{
+	TimeSinceLastRecord = FMath::Frac(PhaseFraction) * RecordOptions.SamplingInterval;
+}
+
+void URecordComponent::SetSignificance(float Significance)
+{
+	const float MaxSamplingInterval = FMath::Max(RecordOptions.MaxSamplingInterval, RecordOptions.SamplingInterval);
+	CurrentSamplingInterval = FMath::Lerp(MaxSamplingInterval, RecordOptions.SamplingInterval, FMath::Clamp(Significance, 0.f, 1.f));
+}
+
+void URecordComponent::BeginSample()
+{
+	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_BeginSample);
+
+	if (RecordOptions.bTrackAttachmentChanges)
 	{
-		if (RecordOptions.bTrackAttachmentChanges)
+		if (!RecordOptions.bEventDrivenAttachmentTracking || bAttachmentsDirty || HasScannedHierarchyChanged())
 		{
 			HandleSceneComponentChangesByBit();
+			bAttachmentsDirty = false;
 		}
-		
-		TimeSinceLastRecord -= RecordOptions.SamplingInterval;
+	}
+	
+	TimeSinceLastRecord -= CurrentSamplingInterval;
+	if (TimeSinceLastRecord >= CurrentSamplingInterval)
+	{
+		// A sample deferred by the frame budget keeps its phase but does not cause a burst of catch-up samples
+		TimeSinceLastRecord = FMath::Fmod(TimeSinceLastRecord, CurrentSamplingInterval);
+	}
 
-		FRecordFrame NewFrame;
-		NewFrame.FrameIndex = CurrentFrameIndex++;
-		NewFrame.TimeStamp = GetWorld()->GetTimeSeconds() - StartTime;
+	if (StreamWriter.IsValid() && FrameSlabPtr->Num() >= MaxRecordFrames)
+	{
+		FlushStreamBlock();
+	}
 
-		// Record All Owned Component Transform (support for StaticMeshComponent, SkeletalMeshComponent)
-		for (TObjectPtr<USceneComponent>& SceneComp : OwnedComponentsForRecord)
-		{
-			FString ComponentName = CreateUniqueComponentName(SceneComp);
+	/* If there is no space left, the oldest frame is overwritten. The timestamp is the actual sample time */
+	PendingSampleSlot = FrameSlabPtr->AddFrame(GetWorld()->GetTimeSeconds() - StartTime, CurrentFrameIndex++);
+}
 
-			if (USkeletalMeshComponent* SkeletalComp = Cast<USkeletalMeshComponent>(SceneComp))
-			{
-				if (SkeletalComp->IsSimulatingPhysics())
-				{
-					const USkeletalMesh* SkeletalMesh = SkeletalComp->GetSkeletalMeshAsset();
-					const FReferenceSkeleton& RefSkeleton = SkeletalMesh->GetRefSkeleton();
-					const int32 NumBones = SkeletalComp->GetNumBones();
+void URecordComponent::CaptureSample()
+{
+	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_CaptureSample);
+	
+	if (PendingSampleSlot == INDEX_NONE)
+	{
+		return;
+	}
+	
+	const int32 Slot = PendingSampleSlot;
+	PendingSampleSlot = INDEX_NONE;
+	FTransform* ComponentTransforms = FrameSlabPtr->GetComponentTransforms(Slot);
+	FTransform* BoneTransforms = FrameSlabPtr->GetBoneTransforms(Slot);
 
-					TArray<FTransform> BoneWorldTransforms;
-					BoneWorldTransforms.SetNum(NumBones);
-					for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
-					{
-						BoneWorldTransforms[BoneIndex] = SkeletalComp->GetBoneTransform(BoneIndex); // World space
-					}
-					TArray<FTransform> BoneLocalTransforms;
-					BoneLocalTransforms.SetNum(NumBones);
-					const FTransform WorldToComponent = SkeletalComp->GetComponentTransform().Inverse();
+	// Record All Owned Component Transform (support for StaticMeshComponent, SkeletalMeshComponent)
+	for (int32 OwnedIndex = 0; OwnedIndex < OwnedComponentsForRecord.Num(); ++OwnedIndex)
+	{
+		USceneComponent* SceneComp = OwnedComponentsForRecord[OwnedIndex];
+		const int32 ComponentId = OwnedComponentIds[OwnedIndex];
+		const FRecordComponentTrack& Track = ComponentTracks[ComponentId];
 
-					for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
-					{
-						int32 ParentIndex = RefSkeleton.GetParentIndex(BoneIndex);
-						if (ParentIndex != INDEX_NONE)
-						{
-							BoneLocalTransforms[BoneIndex] = BoneWorldTransforms[BoneIndex].GetRelativeTransform(BoneWorldTransforms[ParentIndex]);
-						}
-						else
-						{
-							// Root bone: relative to component
-							BoneLocalTransforms[BoneIndex] = BoneWorldTransforms[BoneIndex] * WorldToComponent;
-						}
-					}
-					FBoneComponentSpace LocalBoneData(BoneLocalTransforms);
-					NewFrame.SkeletalMeshBoneTransforms.Add(ComponentName, LocalBoneData);
+		USkeletalMeshComponent* SkeletalComp = Cast<USkeletalMeshComponent>(SceneComp);
+		if (SkeletalComp && Track.HasBones())
+		{
+			FTransform* TrackBones = BoneTransforms + Track.BoneOffset;
+			
+			if (SkeletalComp->IsSimulatingPhysics())
+			{
+				CaptureRagdollBones(SkeletalComp, Track, TrackBones);
+			}
+			else if (Track.BoneIndices.IsEmpty())
+			{
+				const TArray<FTransform>& BoneSpaceTransforms = SkeletalComp->GetBoneSpaceTransforms();
+				const int32 NumCopiedBones = FMath::Min(Track.NumBones, BoneSpaceTransforms.Num());
+				FMemory::Memcpy(TrackBones, BoneSpaceTransforms.GetData(), NumCopiedBones * sizeof(FTransform));
+				for (int32 BoneIndex = NumCopiedBones; BoneIndex < Track.NumBones; ++BoneIndex)
+				{
+					TrackBones[BoneIndex] = GetReferenceBoneTransform(SkeletalComp, BoneIndex);
 				}
-				else
+			}
+			else
+			{
+				const TArray<FTransform>& BoneSpaceTransforms = SkeletalComp->GetBoneSpaceTransforms();
+				for (int32 BoneIndex = 0; BoneIndex < Track.NumBones; ++BoneIndex)
 				{
-				FBoneComponentSpace LocalBaseTransforms(SkeletalComp->GetBoneSpaceTransforms());
-				NewFrame.SkeletalMeshBoneTransforms.Add(ComponentName, LocalBaseTransforms);
+					const int32 MeshBoneIndex = Track.BoneIndices[BoneIndex];
+					TrackBones[BoneIndex] = BoneSpaceTransforms.IsValidIndex(MeshBoneIndex)
+						? BoneSpaceTransforms[MeshBoneIndex]
+						: GetReferenceBoneTransform(SkeletalComp, MeshBoneIndex);
 				}
 			}
-			NewFrame.RelativeTransforms.Add(ComponentName, SceneComp->GetRelativeTransform());
 		}
+		ComponentTransforms[ComponentId] = SceneComp->GetRelativeTransform();
+		FrameSlabPtr->MarkRecorded(Slot, ComponentId);
 
-		/* If there is no space left, discard the oldest frame */
-		if (FrameQueuePtr->IsFull())
+		if (RecordOptions.bUseKeyframeReduction)
 		{
-			FRecordFrame Discard;
-			FrameQueuePtr->Dequeue(Discard);
+			ReduceTrackKeys(ComponentId, CurrentFrameIndex - 1);
 		}
-		FrameQueuePtr->Enqueue(NewFrame);
 	}
 }
 
@@ -141,23 +199,94 @@ void URecordComponent::Initialize(const FBloodStainRecordOptions& InOptions, con
 	
 	RecordOptions = InOptions;
 	
-	MaxRecordFrames = FMath::CeilToInt(RecordOptions.MaxRecordTime / RecordOptions.SamplingInterval);
-	uint32 CapacityPlusOne = FMath::Max<uint32>(MaxRecordFrames + 1, 2);
-	FrameQueuePtr = MakeUnique<TCircularQueue<FRecordFrame>>(CapacityPlusOne);
+	// A streamed recording only keeps one block of frames, the sealed blocks are written to disk
+	const float BufferedTime = RecordOptions.bStreamToDisk ? RecordOptions.StreamBlockTime : RecordOptions.MaxRecordTime;
+	MaxRecordFrames = FMath::CeilToInt(BufferedTime / RecordOptions.SamplingInterval);
 
 	StartTime = InGroupStartTime;
+	CurrentSamplingInterval = RecordOptions.SamplingInterval;
 	
 	CollectOwnedSceneComponents();
+
+	// The first sample establishes the attachment baseline
+	bAttachmentsDirty = true;
+
+	// Sized after the initial components are interned, so only components attached later grow the slab
+	FrameSlabPtr = MakeShared<FRecordFrameSlab>();
+	FrameSlabPtr->Initialize(MaxRecordFrames + 1, ComponentTracks.Num(), NumTrackBones);
+}
+
+FDetachedRecordData URecordComponent::DetachRecordData()
+{
+	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_DetachRecordData);
+
+	FDetachedRecordData Result;
+	Result.ActorName = GetOwner()->GetFName();
+	Result.FrameSlabPtr = MoveTemp(FrameSlabPtr);
+	Result.GhostSaveData.PrimaryComponentId = PrimaryComponentId;
+	Result.GhostSaveData.ComponentTracks = MoveTemp(ComponentTracks);
+	Result.ComponentIntervals = MoveTemp(ComponentActiveIntervals);
+	Result.UserData = GetRecordActorUserData();
+
+	return Result;
 }
 
-FRecordActorSaveData URecordComponent::CookQueuedFrames(const float& BaseTime)
+FDetachedRecordData URecordComponent::SnapshotRecordData(float ClipStartTime) const
 {
-	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_CookQueuedFrames);
+	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_SnapshotRecordData);
+
+	FDetachedRecordData Result;
+	Result.ActorName = GetOwner()->GetFName();
+	Result.GhostSaveData.PrimaryComponentId = PrimaryComponentId;
+	Result.GhostSaveData.ComponentTracks = ComponentTracks;
+	Result.ComponentIntervals = ComponentActiveIntervals;
+	Result.UserData = InstancedStruct;
+	BloodStainRecordDataUtils::CopyQueuedFrames(*FrameSlabPtr, ClipStartTime, Result.GhostSaveData.RecordedFrames);
+
+	return Result;
+}
+
+void URecordComponent::SetStreamWriter(const TSharedPtr<FBloodStainStreamWriter>& InStreamWriter, int32 InStreamActorIndex)
+{
+	StreamWriter = InStreamWriter;
+	StreamActorIndex = InStreamActorIndex;
+}
+
+void URecordComponent::FlushStreamBlock()
+{
+	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_FlushStreamBlock);
+
+	if (FrameSlabPtr->IsEmpty())
+	{
+		return;
+	}
+
+	// The filled slab is handed over as is, the encoder unpacks it off the game thread
+	TSharedPtr<FRecordFrameSlab> NextFrameSlab = StreamWriter->AcquireFrameSlab();
+	if (!NextFrameSlab.IsValid() || NextFrameSlab->GetCapacity() < MaxRecordFrames + 1)
+	{
+		NextFrameSlab = MakeShared<FRecordFrameSlab>();
+		NextFrameSlab->Initialize(MaxRecordFrames + 1, ComponentTracks.Num(), NumTrackBones);
+	}
+	else
+	{
+		NextFrameSlab->Reserve(ComponentTracks.Num(), NumTrackBones);
+	}
 
-	FRecordActorSaveData Result = FRecordActorSaveData();
-	Result.PrimaryComponentName = PrimaryComponentName;
-	BloodStainRecordDataUtils::CookQueuedFrames(RecordOptions.SamplingInterval, BaseTime, FrameQueuePtr.Get(), Result, ComponentActiveIntervals);
+	StreamWriter->AppendBlock(StreamActorIndex, PrimaryComponentId, ComponentTracks, MoveTemp(FrameSlabPtr));
+	FrameSlabPtr = MoveTemp(NextFrameSlab);
+}
 
+FRecordActorSaveData URecordComponent::FinishStream()
+{
+	FlushStreamBlock();
+	StreamWriter.Reset();
+
+	// Intervals are rebased once the frame count of the stream is known
+	FRecordActorSaveData Result;
+	Result.PrimaryComponentId = PrimaryComponentId;
+	Result.ComponentTracks = ComponentTracks;
+	Result.ComponentIntervals = ComponentActiveIntervals;
 	return Result;
 }
 
@@ -176,15 +305,16 @@ void URecordComponent::OnComponentAttached(USceneComponent* NewComponent)
 		return;
 	}
 	
-	const FString ComponentName = CreateUniqueComponentName(NewComponent);
-	if (IntervalIndexMap.Contains(ComponentName))
+	const int32 ComponentId = InternComponentId(NewComponent);
+	if (IntervalIndexMap.Contains(ComponentId))
 	{
 		// If it's already registered, do nothing
-		UE_LOG(LogBloodStain, Warning, TEXT("[OnComponentAttached] Component %s is already registered"), *ComponentName);
+		UE_LOG(LogBloodStain, Warning, TEXT("[OnComponentAttached] Component %s is already registered"), *NewComponent->GetName());
 		return;
 	}
 	
 	OwnedComponentsForRecord.Add(NewComponent);
+	OwnedComponentIds.Add(ComponentId);
 
 	FComponentRecord Record;
 
@@ -192,10 +322,10 @@ void URecordComponent::OnComponentAttached(USceneComponent* NewComponent)
 	{
 		FComponentActiveInterval I = FComponentActiveInterval(Record, CurrentFrameIndex, INT32_MAX);
 		int32 NewIdx = ComponentActiveIntervals.Add(I);
-		IntervalIndexMap.Add(I.Meta.ComponentName, NewIdx);
+		IntervalIndexMap.Add(ComponentId, NewIdx);
 	}
 	
-	UE_LOG(LogBloodStain, Warning, TEXT("[OnComponentAttached] Component %s Attached"), *ComponentName);
+	UE_LOG(LogBloodStain, Warning, TEXT("[OnComponentAttached] Component %s Attached"), *NewComponent->GetName());
 }
 
 void URecordComponent::OnComponentDetached(USceneComponent* DetachedComponent)
@@ -206,23 +336,24 @@ void URecordComponent::OnComponentDetached(USceneComponent* DetachedComponent)
 		return;
 	}
 
-	const FString ComponentName = CreateUniqueComponentName(DetachedComponent);
-	
-	if (!OwnedComponentsForRecord.Contains(DetachedComponent))
+	const int32 OwnedIndex = OwnedComponentsForRecord.Find(DetachedComponent);
+	if (OwnedIndex == INDEX_NONE)
 	{
-		UE_LOG(LogBloodStain, Warning, TEXT("[OnComponentDetached] Component is not Attached %s"), *ComponentName);
+		UE_LOG(LogBloodStain, Warning, TEXT("[OnComponentDetached] Component is not Attached %s"), *DetachedComponent->GetName());
 		return;
 	}
 
-	OwnedComponentsForRecord.Remove(DetachedComponent);
+	const int32 ComponentId = OwnedComponentIds[OwnedIndex];
+	OwnedComponentsForRecord.RemoveAt(OwnedIndex);
+	OwnedComponentIds.RemoveAt(OwnedIndex);
 	
-	if (const int32* Idx = IntervalIndexMap.Find(ComponentName))
+	if (const int32* Idx = IntervalIndexMap.Find(ComponentId))
 	{
 		ComponentActiveIntervals[*Idx].EndFrame = CurrentFrameIndex - 1;
-		IntervalIndexMap.Remove(ComponentName);
+		IntervalIndexMap.Remove(ComponentId);
 	}
 
-	UE_LOG(LogBloodStain, Warning, TEXT("[OnComponentDetached] Component %s Detached"), *ComponentName);
+	UE_LOG(LogBloodStain, Warning, TEXT("[OnComponentDetached] Component %s Detached"), *DetachedComponent->GetName());
 }
 
 void URecordComponent::FillMaterialData(const UMeshComponent* InMeshComponent, FComponentRecord& OutRecord)
@@ -305,6 +436,7 @@ void URecordComponent::CollectOwnedSceneComponents()
 	
     ComponentActiveIntervals.Empty();
     OwnedComponentsForRecord.Empty();
+    OwnedComponentIds.Empty();
     IntervalIndexMap.Empty();
 
 	TArray<AActor*> ActorsToProcess;
@@ -333,13 +465,9 @@ void URecordComponent::CollectOwnedSceneComponents()
 		}
 	}
 	
-	if (!OwnedComponentsForRecord.IsEmpty())
+	if (!OwnedComponentIds.IsEmpty())
 	{
-		const USceneComponent* PrimaryComp = OwnedComponentsForRecord[0].Get();
-		if (PrimaryComp != nullptr)
-		{
-			PrimaryComponentName = FName(CreateUniqueComponentName(PrimaryComp));
-		}
+		PrimaryComponentId = OwnedComponentIds[0];
 	}
 	
  	UE_LOG(LogBloodStain, Log, TEXT("Collected %d mesh components for %s and its attachments."), OwnedComponentsForRecord.Num(), *Owner->GetName());
@@ -380,7 +508,8 @@ bool URecordComponent::CreateRecordFromSceneComponent(USceneComponent* InSceneCo
 		}
 	}
 	
-	if (TSharedPtr<FComponentRecord> CachedRecord = MetaDataCache.FindRef(CreateUniqueComponentName(InSceneComponent)))
+	const int32 ComponentId = InternComponentId(InSceneComponent);
+	if (TSharedPtr<FComponentRecord> CachedRecord = MetaDataCache.FindRef(ComponentId))
 	{
 		OutRecord = *CachedRecord;
 	}
@@ -388,6 +517,7 @@ bool URecordComponent::CreateRecordFromSceneComponent(USceneComponent* InSceneCo
 	{
 		TSharedPtr<FComponentRecord> NewRecord = MakeShared<FComponentRecord>();
 		NewRecord->ComponentName = CreateUniqueComponentName(InSceneComponent);
+		NewRecord->ComponentId = ComponentId;
 		if (USceneComponent* ParentComp = InSceneComponent->GetAttachParent())
 		{
 			NewRecord->AttachParentComponentName = CreateUniqueComponentName(ParentComp);
@@ -409,7 +539,7 @@ bool URecordComponent::CreateRecordFromSceneComponent(USceneComponent* InSceneCo
 			}
 		}
 		NewRecord->bVisible = InSceneComponent->IsVisible();
-		MetaDataCache.Add(OutRecord.ComponentName, NewRecord);
+		MetaDataCache.Add(ComponentId, NewRecord);
 		OutRecord = *NewRecord;
 	}
 	return true;
@@ -476,11 +606,29 @@ void URecordComponent::HandleAttachedActorChangesByBit()
 	PrevAttachedBits = CurAttachedBits;
 }
 
+bool URecordComponent::HasScannedHierarchyChanged() const
+{
+	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_HasScannedHierarchyChanged);
+
+	// Any attach or detach below the recorded hierarchy changes the child count of a scanned parent
+	for (int32 Index = 0; Index < ScannedComponents.Num(); ++Index)
+	{
+		const USceneComponent* SceneComp = ScannedComponents[Index].Get();
+		if (!SceneComp || !SceneComp->IsRegistered() || SceneComp->GetAttachChildren().Num() != ScannedChildCounts[Index])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 void URecordComponent::HandleSceneComponentChangesByBit()
 {
 	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_HandleAttachedChangesByBit);
 
 	TArray<USceneComponent*> CurSceneComponents;
+	ScannedComponents.Reset();
+	ScannedChildCounts.Reset();
     if (AActor* Owner = GetOwner())
     {
         TArray<AActor*> ActorsToProcess;
@@ -502,6 +650,8 @@ void URecordComponent::HandleSceneComponentChangesByBit()
         	
         	for (USceneComponent* SceneComp : OrderedComponents)
             {
+            	ScannedComponents.Add(SceneComp);
+            	ScannedChildCounts.Add(SceneComp->GetAttachChildren().Num());
                 if (IsComponentSupported(SceneComp))
                 {
                     CurSceneComponents.Add(SceneComp);
@@ -579,8 +729,9 @@ bool URecordComponent::AddComponentToRecordList(USceneComponent* SceneComp)
 	{
 		FComponentActiveInterval Interval = FComponentActiveInterval(Record, 0, INT32_MAX);
 		const int32 NewIdx = ComponentActiveIntervals.Add(Interval);
-		IntervalIndexMap.Add(Record.ComponentName, NewIdx);
+		IntervalIndexMap.Add(Record.ComponentId, NewIdx);
 		OwnedComponentsForRecord.Add(SceneComp);
+		OwnedComponentIds.Add(Record.ComponentId);
 		return true;
 	}
 	return false;
@@ -599,6 +750,203 @@ bool URecordComponent::IsComponentSupported(const USceneComponent* SceneComp) co
 	return true;
 }
 
+int32 URecordComponent::InternComponentId(USceneComponent* SceneComp)
+{
+	if (const int32* ComponentId = ComponentIdMap.Find(SceneComp))
+	{
+		return *ComponentId;
+	}
+
+	FRecordComponentTrack NewTrack;
+	if (const USkeletalMeshComponent* SkeletalComp = Cast<USkeletalMeshComponent>(SceneComp))
+	{
+		BuildRecordedBoneIndices(SkeletalComp, NewTrack.BoneIndices);
+		NewTrack.NumBones = NewTrack.BoneIndices.IsEmpty() ? SkeletalComp->GetNumBones() : NewTrack.BoneIndices.Num();
+		NewTrack.BoneOffset = NumTrackBones;
+		NumTrackBones += NewTrack.NumBones;
+	}
+
+	const int32 NewComponentId = ComponentTracks.Add(NewTrack);
+	ComponentIdMap.Add(SceneComp, NewComponentId);
+	TrackReductionStates.AddDefaulted();
+
+	if (FrameSlabPtr.IsValid())
+	{
+		FrameSlabPtr->Reserve(ComponentTracks.Num(), NumTrackBones);
+	}
+	return NewComponentId;
+}
+
+void URecordComponent::BuildRecordedBoneIndices(const USkeletalMeshComponent* SkeletalComp, TArray<int32>& OutBoneIndices) const
+{
+	OutBoneIndices.Reset();
+
+	const USkeletalMesh* SkeletalMesh = SkeletalComp->GetSkeletalMeshAsset();
+	if (!SkeletalMesh || (RecordOptions.BoneLODLevel < 0 && RecordOptions.RecordedBoneNames.IsEmpty()))
+	{
+		return;
+	}
+
+	const int32 NumBones = SkeletalComp->GetNumBones();
+	TBitArray<> BoneMask(true, NumBones);
+
+	if (RecordOptions.BoneLODLevel >= 0)
+	{
+		const FSkeletalMeshRenderData* RenderData = SkeletalMesh->GetResourceForRendering();
+		if (RenderData && !RenderData->LODRenderData.IsEmpty())
+		{
+			const int32 LODIndex = FMath::Min(RecordOptions.BoneLODLevel, RenderData->LODRenderData.Num() - 1);
+			BoneMask.Init(false, NumBones);
+			for (const FBoneIndexType RequiredBone : RenderData->LODRenderData[LODIndex].RequiredBones)
+			{
+				if (RequiredBone < NumBones)
+				{
+					BoneMask[RequiredBone] = true;
+				}
+			}
+		}
+		else
+		{
+			UE_LOG(LogBloodStain, Verbose, TEXT("[BuildRecordedBoneIndices] No render data for %s, BoneLODLevel is ignored"), *SkeletalMesh->GetName());
+		}
+	}
+
+	if (!RecordOptions.RecordedBoneNames.IsEmpty())
+	{
+		TBitArray<> NamedBones(false, NumBones);
+		const FReferenceSkeleton& RefSkeleton = SkeletalMesh->GetRefSkeleton();
+		for (const FName& BoneName : RecordOptions.RecordedBoneNames)
+		{
+			const int32 BoneIndex = RefSkeleton.FindBoneIndex(BoneName);
+			if (BoneIndex != INDEX_NONE && BoneIndex < NumBones)
+			{
+				NamedBones[BoneIndex] = true;
+			}
+		}
+		BoneMask.CombineWithBitwiseAND(NamedBones, EBitwiseOperatorFlags::MinSize);
+	}
+
+	for (TConstSetBitIterator<> It(BoneMask); It; ++It)
+	{
+		OutBoneIndices.Add(It.GetIndex());
+	}
+
+	// Every bone recorded : keep the unmasked layout
+	if (OutBoneIndices.Num() == NumBones)
+	{
+		OutBoneIndices.Reset();
+	}
+}
+
+void URecordComponent::ReduceTrackKeys(int32 ComponentId, int32 FrameIndex)
+{
+	FTrackReductionState& State = TrackReductionStates[ComponentId];
+
+	// A gap in the samples means the component was detached, the samples around it are always kept
+	const bool bContinuous = State.CandidateFrame != INDEX_NONE && State.CandidateFrame == FrameIndex - 1;
+	const int32 KeyIndex = State.KeyFrame != INDEX_NONE ? FrameSlabPtr->FindIndex(State.KeyFrame) : INDEX_NONE;
+	const int32 NewIndex = FrameSlabPtr->FindIndex(FrameIndex);
+
+	if (bContinuous && KeyIndex != INDEX_NONE && NewIndex != INDEX_NONE
+		&& FrameIndex - State.KeyFrame <= MaxKeyframeGap
+		&& CanDropSamples(ComponentId, KeyIndex, NewIndex))
+	{
+		const int32 CandidateIndex = NewIndex - 1;
+		FrameSlabPtr->ClearRecorded(FrameSlabPtr->ToSlot(CandidateIndex), ComponentId);
+	}
+	else
+	{
+		State.KeyFrame = bContinuous ? State.CandidateFrame : INDEX_NONE;
+	}
+	State.CandidateFrame = FrameIndex;
+}
+
+bool URecordComponent::CanDropSamples(int32 ComponentId, int32 KeyIndex, int32 NewIndex) const
+{
+	const FRecordComponentTrack& Track = ComponentTracks[ComponentId];
+	const int32 KeySlot = FrameSlabPtr->ToSlot(KeyIndex);
+	const int32 NewSlot = FrameSlabPtr->ToSlot(NewIndex);
+	const float KeyTime = FrameSlabPtr->GetTimeStamp(KeyIndex);
+	const float Duration = FrameSlabPtr->GetTimeStamp(NewIndex) - KeyTime;
+	if (Duration <= KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	const float ComponentRotationTolerance = FMath::DegreesToRadians(RecordOptions.ComponentRotationTolerance);
+	const float BoneRotationTolerance = FMath::DegreesToRadians(RecordOptions.BoneRotationTolerance);
+	
+	auto IsReconstructible = [](const FTransform& Key, const FTransform& Next, const FTransform& Sample, float Alpha, float LocationTolerance, float RotationTolerance)
+	{
+		const FVector Location = FMath::Lerp(Key.GetLocation(), Next.GetLocation(), Alpha);
+		const FQuat Rotation = FQuat::Slerp(Key.GetRotation(), Next.GetRotation(), Alpha);
+		const FVector Scale = FMath::Lerp(Key.GetScale3D(), Next.GetScale3D(), Alpha);
+		
+		return FVector::DistSquared(Location, Sample.GetLocation()) <= FMath::Square(LocationTolerance)
+			&& Rotation.AngularDistance(Sample.GetRotation()) <= RotationTolerance
+			&& Scale.Equals(Sample.GetScale3D(), UE_KINDA_SMALL_NUMBER);
+	};
+
+	for (int32 Index = KeyIndex + 1; Index < NewIndex; ++Index)
+	{
+		const int32 Slot = FrameSlabPtr->ToSlot(Index);
+		const float Alpha = (FrameSlabPtr->GetTimeStamp(Index) - KeyTime) / Duration;
+		
+		if (!IsReconstructible(FrameSlabPtr->GetComponentTransforms(KeySlot)[ComponentId], FrameSlabPtr->GetComponentTransforms(NewSlot)[ComponentId],
+			FrameSlabPtr->GetComponentTransforms(Slot)[ComponentId], Alpha, RecordOptions.ComponentLocationTolerance, ComponentRotationTolerance))
+		{
+			return false;
+		}
+
+		const FTransform* KeyBones = FrameSlabPtr->GetBoneTransforms(KeySlot) + Track.BoneOffset;
+		const FTransform* NewBones = FrameSlabPtr->GetBoneTransforms(NewSlot) + Track.BoneOffset;
+		const FTransform* SampleBones = FrameSlabPtr->GetBoneTransforms(Slot) + Track.BoneOffset;
+		for (int32 BoneIndex = 0; BoneIndex < Track.NumBones; ++BoneIndex)
+		{
+			if (!IsReconstructible(KeyBones[BoneIndex], NewBones[BoneIndex], SampleBones[BoneIndex], Alpha, RecordOptions.BoneLocationTolerance, BoneRotationTolerance))
+			{
+				return false;
+			}
+		}
+	}
+	
+	return true;
+}
+
+void URecordComponent::CaptureRagdollBones(const USkeletalMeshComponent* SkeletalComp, const FRecordComponentTrack& Track, FTransform* OutBoneTransforms)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RecordComponent_CaptureRagdollBones);
+	
+	// Component space pose already contains the blended physics bodies, so no per-bone world space query is needed
+	const TArray<FTransform>& ComponentSpaceTransforms = SkeletalComp->GetComponentSpaceTransforms();
+	const FReferenceSkeleton& RefSkeleton = SkeletalComp->GetSkeletalMeshAsset()->GetRefSkeleton();
+	const TArray<FMeshBoneInfo>& BoneInfos = RefSkeleton.GetRefBoneInfo();
+	const int32 NumValidBones = FMath::Min(ComponentSpaceTransforms.Num(), BoneInfos.Num());
+	const FTransform* ComponentSpace = ComponentSpaceTransforms.GetData();
+
+	// Each bone only depends on its own and its parent's component space transform, so masked bones can be skipped
+	for (int32 BoneIndex = 0; BoneIndex < Track.NumBones; ++BoneIndex)
+	{
+		const int32 MeshBoneIndex = Track.GetMeshBoneIndex(BoneIndex);
+		if (MeshBoneIndex >= NumValidBones)
+		{
+			OutBoneTransforms[BoneIndex] = GetReferenceBoneTransform(SkeletalComp, MeshBoneIndex);
+			continue;
+		}
+		
+		const int32 ParentIndex = BoneInfos[MeshBoneIndex].ParentIndex;
+		if (ParentIndex != INDEX_NONE)
+		{
+			OutBoneTransforms[BoneIndex] = ComponentSpace[MeshBoneIndex].GetRelativeTransform(ComponentSpace[ParentIndex]);
+		}
+		else
+		{
+			// Root bone: relative to component
+			OutBoneTransforms[BoneIndex] = ComponentSpace[MeshBoneIndex];
+		}
+	}
+}
+
 FString URecordComponent::CreateUniqueComponentName(const UActorComponent* Component)
 {
 	FString ComponentName = FString::Printf(TEXT("%s_%u"), *Component->GetName(), Component->GetUniqueID());
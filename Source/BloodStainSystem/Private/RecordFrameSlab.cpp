@@ -0,0 +1,131 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#include "RecordFrameSlab.h"
+#include "BloodStainSystem.h"
+#include "GhostData.h"
+
+DECLARE_CYCLE_STAT(TEXT("RecordFrameSlab Reserve"), STAT_RecordFrameSlab_Reserve, STATGROUP_BloodStain);
+
+void FRecordFrameSlab::Initialize(int32 InCapacity, int32 NumTracks, int32 NumTrackBones)
+{
+	Capacity = FMath::Max(InCapacity, 1);
+	TrackStride = NumTracks;
+	BoneStride = NumTrackBones;
+	Head = 0;
+	NumFrames = 0;
+
+	ComponentPool.SetNum(Capacity * TrackStride);
+	BonePool.SetNum(Capacity * BoneStride);
+	RecordedBits.Init(false, Capacity * TrackStride);
+	TimeStamps.SetNumZeroed(Capacity);
+	FrameIndices.SetNumZeroed(Capacity);
+}
+
+void FRecordFrameSlab::Reserve(int32 NumTracks, int32 NumTrackBones)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RecordFrameSlab_Reserve);
+
+	const int32 NewTrackStride = FMath::Max(TrackStride, NumTracks);
+	const int32 NewBoneStride = FMath::Max(BoneStride, NumTrackBones);
+	if (NewTrackStride == TrackStride && NewBoneStride == BoneStride)
+	{
+		return;
+	}
+
+	// Slots keep their position in the ring, only the stride changes
+	TArray<FTransform> NewComponentPool;
+	TArray<FTransform> NewBonePool;
+	TBitArray<> NewRecordedBits(false, Capacity * NewTrackStride);
+	NewComponentPool.SetNum(Capacity * NewTrackStride);
+	NewBonePool.SetNum(Capacity * NewBoneStride);
+
+	for (int32 Index = 0; Index < NumFrames; ++Index)
+	{
+		const int32 Slot = ToSlot(Index);
+		for (int32 TrackIndex = 0; TrackIndex < TrackStride; ++TrackIndex)
+		{
+			NewComponentPool[Slot * NewTrackStride + TrackIndex] = ComponentPool[Slot * TrackStride + TrackIndex];
+			NewRecordedBits[Slot * NewTrackStride + TrackIndex] = RecordedBits[Slot * TrackStride + TrackIndex];
+		}
+		for (int32 BoneIndex = 0; BoneIndex < BoneStride; ++BoneIndex)
+		{
+			NewBonePool[Slot * NewBoneStride + BoneIndex] = BonePool[Slot * BoneStride + BoneIndex];
+		}
+	}
+
+	ComponentPool = MoveTemp(NewComponentPool);
+	BonePool = MoveTemp(NewBonePool);
+	RecordedBits = MoveTemp(NewRecordedBits);
+	TrackStride = NewTrackStride;
+	BoneStride = NewBoneStride;
+
+	UE_LOG(LogBloodStain, Verbose, TEXT("[FRecordFrameSlab::Reserve] Stride grown to %d tracks, %d bones"), TrackStride, BoneStride);
+}
+
+int32 FRecordFrameSlab::AddFrame(float TimeStamp, int32 FrameIndex)
+{
+	if (NumFrames == Capacity)
+	{
+		PopOldest();
+	}
+
+	const int32 Slot = ToSlot(NumFrames);
+	++NumFrames;
+
+	TimeStamps[Slot] = TimeStamp;
+	FrameIndices[Slot] = FrameIndex;
+	if (TrackStride > 0)
+	{
+		RecordedBits.SetRange(Slot * TrackStride, TrackStride, false);
+	}
+	return Slot;
+}
+
+void FRecordFrameSlab::PopOldest()
+{
+	if (NumFrames == 0)
+	{
+		return;
+	}
+
+	Head = (Head + 1) % Capacity;
+	--NumFrames;
+}
+
+int32 FRecordFrameSlab::FindIndex(int32 FrameIndex) const
+{
+	if (NumFrames == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	// Frame indices are consecutive within the ring
+	const int32 Index = FrameIndex - FrameIndices[Head];
+	return (Index >= 0 && Index < NumFrames) ? Index : INDEX_NONE;
+}
+
+void FRecordFrameSlab::Reset()
+{
+	Head = 0;
+	NumFrames = 0;
+}
+
+void FRecordFrameSlab::CopyFrame(int32 Index, FRecordFrame& OutFrame) const
+{
+	const int32 Slot = ToSlot(Index);
+
+	OutFrame.TimeStamp = TimeStamps[Slot];
+	OutFrame.FrameIndex = FrameIndices[Slot];
+	OutFrame.ComponentTransforms.Reset(TrackStride);
+	OutFrame.ComponentTransforms.Append(ComponentPool.GetData() + Slot * TrackStride, TrackStride);
+	OutFrame.BoneTransforms.Reset(BoneStride);
+	OutFrame.BoneTransforms.Append(BonePool.GetData() + Slot * BoneStride, BoneStride);
+	OutFrame.RecordedTracks.Init(false, TrackStride);
+	for (int32 TrackIndex = 0; TrackIndex < TrackStride; ++TrackIndex)
+	{
+		OutFrame.RecordedTracks[TrackIndex] = RecordedBits[Slot * TrackStride + TrackIndex];
+	}
+}
@@ -5,16 +5,13 @@
 
 #include "ReplayActor.h"
 #include "PlayComponent.h"
-#include "BloodStainCompressionUtils.h"
 #include "BloodStainFileUtils.h"
-#include "QuantizationHelper.h"
+#include "BloodStainSubsystem.h"
 #include "Net/UnrealNetwork.h"
 #include "Engine/World.h"
 #include "Engine/NetDriver.h"
 #include "Engine/NetConnection.h"
 #include "Engine/ActorChannel.h"
-#include "Serialization/MemoryReader.h"
-#include "Serialization/MemoryWriter.h"
 #include "BloodStainSystem.h"
 #include "GhostPlayerController.h"
 
@@ -107,7 +104,7 @@ UPlayComponent* AReplayActor::GetPlayComponent() const
 }
 
 void AReplayActor::InitializeReplayLocal(const FGuid& InPlaybackKey, const FRecordHeaderData& InHeader,
-	const FRecordActorSaveData& InActorData, const FBloodStainPlaybackOptions& InOptions)
+	const TSharedRef<const FRecordActorSaveData>& InActorData, const FBloodStainPlaybackOptions& InOptions)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_STR("AReplayActor::InitializeReplayLocal");
 	PlayComponent->Initialize(InPlaybackKey, InHeader, InActorData, InOptions);
@@ -297,30 +294,19 @@ void AReplayActor::Client_AssembleAndFinalize()
 
 void AReplayActor::Client_FinalizeAndSpawnVisuals()
 {
-	TArray<uint8> RawBytes;
-	if (!BloodStainCompressionUtils::DecompressBuffer(Client_FileHeader.UncompressedSize, Client_ReceivedPayloadBuffer,RawBytes, Client_FileHeader.Options.CompressionOption))
+	TSharedRef<FRecordSaveData> AllReplayData = MakeShared<FRecordSaveData>();
+	if (!BloodStainFileUtils::DecodePayload(Client_ReceivedPayloadBuffer, Client_FileHeader, *AllReplayData))
 	{
-		UE_LOG(LogBloodStain, Error, TEXT("[BS] Client failed to decompress payload."));
+		UE_LOG(LogBloodStain, Error, TEXT("[BS] Client failed to decode payload."));
 		Destroy();
 		return;
 	}
-
-	FRecordSaveData AllReplayData;
-	FMemoryReader MemoryReader(RawBytes, true);
-	BloodStainFileUtils_Internal::DeserializeSaveData(MemoryReader, AllReplayData, Client_FileHeader.Options.QuantizationOption);
-	AllReplayData.Header = Client_RecordHeader;
+	AllReplayData->Header = Client_RecordHeader;
 
 	// Save the replay data locally if it doesn't already exist
 	if (!bHasLocalFile)
 	{
-		SaveReplayLocallyIfNotExists(AllReplayData, Client_RecordHeader, Client_FileHeader.Options);
-	}
-
-	if (MemoryReader.IsError())
-	{
-		UE_LOG(LogBloodStain, Error, TEXT("[BS] Client failed to deserialize raw bytes."));
-		Destroy();
-		return;
+		SaveReplayLocallyIfNotExists(*AllReplayData, Client_RecordHeader, Client_FileHeader.Options);
 	}
 
 	if (IsNetMode(NM_DedicatedServer))
@@ -331,29 +317,20 @@ void AReplayActor::Client_FinalizeAndSpawnVisuals()
 		return;
 	}
 	
-	for (const FRecordActorSaveData& Data : AllReplayData.RecordActorDataArray)
-	{
-		AReplayActor* VisualActor = GetWorld()->SpawnActor<AReplayActor>(AReplayActor::StaticClass(), GetActorTransform());
-		if (VisualActor)
-		{
-			VisualActor->SetReplicates(false); 
-			VisualActor->InitializeReplayLocal(Client_PlaybackKey, AllReplayData.Header, Data, Client_PlaybackOptions);
-			VisualActor->SetActorHiddenInGame(true);
-			Client_SpawnedVisualActors.Add(VisualActor);
-		}
-	}
+	Client_FinalizeAndSpawnVisuals(AllReplayData);
 }
 
 // Called when the client already has the full payload data
-void AReplayActor::Client_FinalizeAndSpawnVisuals(const FRecordSaveData& AllReplayData)
+void AReplayActor::Client_FinalizeAndSpawnVisuals(const TSharedRef<const FRecordSaveData>& AllReplayData)
 {
-	for (const FRecordActorSaveData& Data : AllReplayData.RecordActorDataArray)
+	for (const FRecordActorSaveData& Data : AllReplayData->RecordActorDataArray)
 	{
 		AReplayActor* VisualActor = GetWorld()->SpawnActor<AReplayActor>(AReplayActor::StaticClass(), GetActorTransform());
 		if (VisualActor)
 		{
 			VisualActor->SetReplicates(false); 
-			VisualActor->InitializeReplayLocal(Client_PlaybackKey, AllReplayData.Header, Data, Client_PlaybackOptions);
+			// Every visual actor references its entry of the same shared data
+			VisualActor->InitializeReplayLocal(Client_PlaybackKey, AllReplayData->Header, TSharedRef<const FRecordActorSaveData>(AllReplayData, &Data), Client_PlaybackOptions);
 			VisualActor->SetActorHiddenInGame(true);
 			Client_SpawnedVisualActors.Add(VisualActor);
 		}
@@ -400,21 +377,23 @@ void AReplayActor::Multicast_InitializeForPayload_Implementation(const FGuid& In
 	Client_PendingChunks.Empty();
 	Client_ReceivedPayloadBuffer.Empty();
 
-	FRecordSaveData TempData;
-	bHasLocalFile = BloodStainFileUtils::LoadFromFile(InRecordHeader.FileName.ToString(), InRecordHeader.LevelName.ToString(), TempData);
+	// Goes through the subsystem cache so the visual actors share the data with it
+	TSharedPtr<const FRecordSaveData> LocalData;
+	if (const UGameInstance* GameInstance = GetWorld()->GetGameInstance())
+	{
+		if (UBloodStainSubsystem* BloodStainSubsystem = GameInstance->GetSubsystem<UBloodStainSubsystem>())
+		{
+			LocalData = BloodStainSubsystem->FindOrLoadSharedRecordBodyData(InRecordHeader.FileName.ToString(), InRecordHeader.LevelName.ToString());
+		}
+	}
+	bHasLocalFile = LocalData.IsValid();
 	// bHasLocalFile = false; // only if you want to test if the file is not present locally, uncomment this line
 	UE_LOG(LogBloodStain, Log, TEXT("Client checking for file %s. Found: %d"), *InRecordHeader.FileName.ToString(), bHasLocalFile);
 	
 	if (bHasLocalFile)
 	{
 		UE_LOG(LogBloodStain, Log, TEXT("Client has local file: %s. No transfer needed."), *Client_RecordHeader.FileName.ToString());
-	
-		TArray<uint8> SerializedData;
-		FMemoryWriter MemoryWriter(SerializedData, true);
-		BloodStainFileUtils_Internal::SerializeSaveData(MemoryWriter, TempData, Client_FileHeader.Options.QuantizationOption);
-	
-		Client_ReceivedPayloadBuffer = SerializedData;
-		Client_FinalizeAndSpawnVisuals(TempData);
+		Client_FinalizeAndSpawnVisuals(LocalData.ToSharedRef());
 	}
 	
 	if (APlayerController* PC = GetWorld()->GetFirstPlayerController())
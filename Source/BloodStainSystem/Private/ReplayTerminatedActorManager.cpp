@@ -11,7 +11,7 @@
 
 void UReplayTerminatedActorManager::Tick(float DeltaTime)
 {
-	CollectRecordGroups(DeltaTime);
+	CollectRecordGroups();
 }
 
 TStatId UReplayTerminatedActorManager::GetStatId() const
@@ -21,24 +21,25 @@ TStatId UReplayTerminatedActorManager::GetStatId() const
 
 void UReplayTerminatedActorManager::AddToRecordGroup(const FName& GroupName, URecordComponent* RecordComponent)
 {
+	FRecordComponentData RecordComponentData = FRecordComponentData();
+	RecordComponentData.StartTime = RecordComponent->StartTime;
+	RecordComponentData.Record = RecordComponent->DetachRecordData();
+	if (!RecordComponentData.Record.FrameSlabPtr.IsValid() || RecordComponentData.Record.FrameSlabPtr->IsEmpty())
+	{
+		return;
+	}
+	
 	if (!RecordGroups.Contains(GroupName))
 	{
 		RecordGroups.Add(GroupName, FRecordGroupData());
 	}
-	
-	FRecordComponentData RecordComponentData = FRecordComponentData();
-	RecordComponentData.StartTime = RecordComponent->StartTime;
-	RecordComponentData.ActorName = RecordComponent->GetOwner()->GetFName();
-	RecordComponentData.TimeSinceLastRecord = RecordComponent->TimeSinceLastRecord;
-	RecordComponentData.FrameQueuePtr = TSharedPtr<TCircularQueue<FRecordFrame>>(RecordComponent->FrameQueuePtr.Release());
-	RecordComponentData.GhostSaveData.PrimaryComponentName = MoveTemp(RecordComponent->PrimaryComponentName);
-
-	RecordComponentData.ComponentIntervals = MoveTemp(RecordComponent->ComponentActiveIntervals);
-	RecordComponentData.InstancedStruct = RecordComponent->GetRecordActorUserData();	
 
 	FRecordGroupData& RecordGroup = RecordGroups[GroupName];
 	RecordGroup.RecordOptions = RecordComponent->RecordOptions;
-	RecordGroup.RecordComponentData.Add(RecordComponentData);
+
+	const int32 RecordId = NextRecordId++;
+	const FRecordComponentData& AddedData = RecordGroup.RecordComponentData.Add(RecordId, MoveTemp(RecordComponentData));
+	ScheduleExpiry(GroupName, RecordId, AddedData.StartTime, *AddedData.Record.FrameSlabPtr, RecordGroup.RecordOptions.MaxRecordTime);
 }
 
 void UReplayTerminatedActorManager::ClearRecordGroup(const FName& GroupName)
@@ -51,88 +52,104 @@ bool UReplayTerminatedActorManager::ContainsGroup(const FName& GroupName) const
 	return RecordGroups.Contains(GroupName);
 }
 
-void UReplayTerminatedActorManager::CollectRecordGroups(float DeltaTime)
+void UReplayTerminatedActorManager::ScheduleExpiry(const FName& GroupName, int32 RecordId, float StartTime, const FRecordFrameSlab& FrameSlab, float MaxRecordTime)
 {
-	TArray<FName> ToRemoveGroupNames;
-	for (auto& [GroupName, RecordGroupData] : RecordGroups)
+	if (FrameSlab.IsEmpty())
 	{
-		for (int32 i = RecordGroupData.RecordComponentData.Num() - 1; i >= 0; --i)
+		return;
+	}
+
+	FExpiryEntry Entry;
+	Entry.ExpiryTime = StartTime + FrameSlab.GetTimeStamp(0) + MaxRecordTime;
+	Entry.GroupName = GroupName;
+	Entry.RecordId = RecordId;
+	ExpiryHeap.HeapPush(Entry);
+}
+
+void UReplayTerminatedActorManager::CollectRecordGroups()
+{
+	const UWorld* World = GetWorld();
+	if (World == nullptr)
+	{
+		return;
+	}
+	
+	const float WorldTime = World->GetTimeSeconds();
+	while (!ExpiryHeap.IsEmpty() && ExpiryHeap.HeapTop().ExpiryTime < WorldTime)
+	{
+		FExpiryEntry Entry;
+		ExpiryHeap.HeapPop(Entry, EAllowShrinking::No);
+
+		FRecordGroupData* RecordGroupData = RecordGroups.Find(Entry.GroupName);
+		FRecordComponentData* RecordComponentData = RecordGroupData ? RecordGroupData->RecordComponentData.Find(Entry.RecordId) : nullptr;
+		if (RecordComponentData == nullptr || !RecordComponentData->Record.FrameSlabPtr.IsValid())
 		{
-			FRecordComponentData& RecordComponentData = RecordGroupData.RecordComponentData[i];
-			RecordComponentData.TimeSinceLastRecord += DeltaTime;
-			
-			if (RecordComponentData.TimeSinceLastRecord >= RecordGroupData.RecordOptions.SamplingInterval)
-			{
-				FRecordFrame FirstFrame;
-				while (RecordComponentData.FrameQueuePtr->Peek(FirstFrame))
-				{
-					float CurrentTimeStamp = GetWorld()->GetTimeSeconds() - RecordComponentData.StartTime;
-
-					// Time Buffer Out
-					if (FirstFrame.TimeStamp + RecordGroupData.RecordOptions.MaxRecordTime < CurrentTimeStamp)
-					{
-						RecordComponentData.FrameQueuePtr->Dequeue();
-					}
-					else
-					{
-						break;
-					}
-				}
-
-				if (RecordComponentData.FrameQueuePtr->IsEmpty())
-				{
-					RecordGroupData.RecordComponentData.RemoveAt(i);
-					continue;
-				}
-				
-				RecordComponentData.TimeSinceLastRecord = 0.0f;
-			}
+			// Saved or cleared since the entry was pushed
+			continue;
 		}
 
-		if (RecordGroupData.RecordComponentData.Num() == 0)
+		// Time Buffer Out
+		FRecordFrameSlab& FrameSlab = *RecordComponentData->Record.FrameSlabPtr;
+		const float CurrentTimeStamp = WorldTime - RecordComponentData->StartTime;
+		const float MaxRecordTime = RecordGroupData->RecordOptions.MaxRecordTime;
+		while (!FrameSlab.IsEmpty() && FrameSlab.GetTimeStamp(0) + MaxRecordTime < CurrentTimeStamp)
 		{
-			ToRemoveGroupNames.Add(GroupName);
+			FrameSlab.PopOldest();
 		}
-	}
 
-	for (const FName& ToRemoveGroupName : ToRemoveGroupNames)
-	{
-		RecordGroups.Remove(ToRemoveGroupName);
-		OnRecordGroupRemoveByCollecting.ExecuteIfBound();
+		if (!FrameSlab.IsEmpty())
+		{
+			ScheduleExpiry(Entry.GroupName, Entry.RecordId, RecordComponentData->StartTime, FrameSlab, MaxRecordTime);
+			continue;
+		}
+
+		RecordGroupData->RecordComponentData.Remove(Entry.RecordId);
+		if (RecordGroupData->RecordComponentData.Num() == 0)
+		{
+			RecordGroups.Remove(Entry.GroupName);
+			OnRecordGroupRemoveByCollecting.ExecuteIfBound();
+		}
 	}
 }
 
-TArray<FRecordActorSaveData> UReplayTerminatedActorManager::CookQueuedFrames(const FName& GroupName, const float& BaseTime, TArray<FName>& OutActorNameArray, TArray<FInstancedStruct>& OutInstancedStructArray)
+void UReplayTerminatedActorManager::DetachRecordGroup(const FName& GroupName, TArray<FDetachedRecordData>& OutRecords)
 {
-	TArray<FRecordActorSaveData> Result = TArray<FRecordActorSaveData>();
-	OutActorNameArray.Empty();
-	
-	if (!RecordGroups.Contains(GroupName))
+	FRecordGroupData* RecordGroupData = RecordGroups.Find(GroupName);
+	if (RecordGroupData == nullptr)
 	{
-		UE_LOG(LogBloodStain, Warning, TEXT("There is No Group for %s"), *GroupName.ToString());
-		return Result;
+		return;
 	}
 
-	FRecordGroupData& RecordGroupData = RecordGroups[GroupName];
+	for (auto& [RecordId, RecordComponentData] : RecordGroupData->RecordComponentData)
+	{
+		OutRecords.Add(MoveTemp(RecordComponentData.Record));
+	}
 
-	if (RecordGroupData.RecordComponentData.Num() == 0)
+	RecordGroups.Remove(GroupName);
+}
+
+void UReplayTerminatedActorManager::SnapshotRecordGroup(const FName& GroupName, float ClipStartTime, const TSet<FName>* ActorNames, TArray<FDetachedRecordData>& OutRecords) const
+{
+	const FRecordGroupData* RecordGroupData = RecordGroups.Find(GroupName);
+	if (RecordGroupData == nullptr)
 	{
-		UE_LOG(LogBloodStain, Warning, TEXT("There is no Record Data in Group for %s"), *GroupName.ToString());
-		RecordGroups.Remove(GroupName);
-		return Result;
+		return;
 	}
-	
-	for (FRecordComponentData& RecordComponentData : RecordGroupData.RecordComponentData)
+
+	for (const auto& [RecordId, RecordComponentData] : RecordGroupData->RecordComponentData)
 	{
-		if (BloodStainRecordDataUtils::CookQueuedFrames(RecordGroupData.RecordOptions.SamplingInterval, BaseTime, RecordComponentData.FrameQueuePtr.Get(), RecordComponentData.GhostSaveData, RecordComponentData.ComponentIntervals))
+		const FDetachedRecordData& Record = RecordComponentData.Record;
+		if (!Record.FrameSlabPtr.IsValid() || (ActorNames && !ActorNames->Contains(Record.ActorName)))
 		{
-			OutActorNameArray.Add(RecordComponentData.ActorName);
-			Result.Add(RecordComponentData.GhostSaveData);
-			OutInstancedStructArray.Add(RecordComponentData.InstancedStruct);
+			continue;
 		}
-	}
 
-	RecordGroups.Remove(GroupName);
-	
-	return Result;
-}
\ No newline at end of file
+		FDetachedRecordData& Snapshot = OutRecords.AddDefaulted_GetRef();
+		Snapshot.ActorName = Record.ActorName;
+		Snapshot.GhostSaveData.PrimaryComponentId = Record.GhostSaveData.PrimaryComponentId;
+		Snapshot.GhostSaveData.ComponentTracks = Record.GhostSaveData.ComponentTracks;
+		Snapshot.ComponentIntervals = Record.ComponentIntervals;
+		Snapshot.UserData = Record.UserData;
+		BloodStainRecordDataUtils::CopyQueuedFrames(*Record.FrameSlabPtr, ClipStartTime, Snapshot.GhostSaveData.RecordedFrames);
+	}
+}
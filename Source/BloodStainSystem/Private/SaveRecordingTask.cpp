@@ -9,7 +9,7 @@
 
 void FSaveRecordingTask::DoWork()
 {
-	const bool bSuccess = BloodStainFileUtils::SaveToFile(SavedData, LevelName, FileName, FileOptions);
+	const bool bSuccess = BloodStainFileUtils::SaveToFile(MoveTemp(SavedData), LevelName, FileName, FileOptions);
 	FGraphEventRef Task = FFunctionGraphTask::CreateAndDispatchWhenReady([=, LocalOnTaskCompleted = this->OnTaskCompleted]()
 	{
 		if (bSuccess)
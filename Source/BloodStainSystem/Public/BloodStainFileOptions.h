@@ -27,6 +27,7 @@ enum class ECompressionMethod : uint8
  * - Standard_High: High‑precision quantization (uses FQuantizedTransform_High).
  * - Standard_Medium: Medium quantization (uses FQuantizedTransform_Medium).
  * - Standard_Low: Lowest‑bit quantization (uses FQuantizedTransform_Lowest).
+ * - SmallestThree: Medium location/scale quantization with a smallest-three rotation of RotationBits bits (uses FQuantizedTransform_SmallestThree).
  */
 UENUM(BlueprintType)
 enum class ETransformQuantizationMethod : uint8
@@ -34,7 +35,25 @@ enum class ETransformQuantizationMethod : uint8
 	None,            
 	Standard_High,   
 	Standard_Medium,
-	Standard_Low     
+	Standard_Low,
+	SmallestThree
+};
+
+/**
+ * @brief Supported transform sample encodings, applied on top of the quantization.
+ *
+ * - None: Every sample is quantized on its own.
+ * - Delta: Samples are stored as integer differences from the previous sample of the same track or bone.
+ * - LinearPrediction: Samples are stored as integer differences from the linear extrapolation of the two previous samples.
+ *
+ * Both delta modes store a full keyframe every KeyframeInterval samples, and are ignored without quantization.
+ */
+UENUM(BlueprintType)
+enum class ETransformEncodingMethod : uint8
+{
+	None,
+	Delta,
+	LinearPrediction
 };
 
 /**
@@ -52,7 +71,26 @@ struct FBloodStainFileOptions
 	/** Quantization settings for bone transforms */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Quantization")
 	ETransformQuantizationMethod QuantizationOption = ETransformQuantizationMethod::Standard_Medium;
-	
+
+	static constexpr int32 MinRotationBits = 29;
+	static constexpr int32 MaxRotationBits = 62;
+
+	/**
+	 * Bits per rotation with SmallestThree quantization : 2 bits of index and 3 components of (RotationBits - 2) / 3 bits.
+	 * Only 29, 38 and 47 (or any 2 + 3 * N) are used in full, e.g. 48 is stored on 47 bits.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Quantization", meta=(ClampMin="29", ClampMax="62", EditCondition="QuantizationOption == ETransformQuantizationMethod::SmallestThree"))
+	int32 RotationBits = 38;
+
+	/** Delta encoding of the quantized transforms, the small residuals compress several times better */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Quantization")
+	ETransformEncodingMethod EncodingOption = ETransformEncodingMethod::None;
+
+	/** Number of samples between two keyframes of a delta encoded track */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="File|Quantization", meta=(ClampMin="1", EditCondition="EncodingOption != ETransformEncodingMethod::None"))
+	int32 KeyframeInterval = 30;
+
+	/** Options added after the first file version are serialized by FBloodStainFileHeader, depending on its version */
 	friend FArchive& operator<<(FArchive& Ar, FBloodStainFileOptions& Options)
 	{
 		Ar << Options.CompressionOption;
@@ -61,6 +99,49 @@ struct FBloodStainFileOptions
 	}
 };
 
+/**
+ * @brief Payload layout versions, stored in FBloodStainFileHeader::Version
+ */
+namespace EBloodStainFileVersion
+{
+	enum Type : uint32
+	{
+		/** Per-frame component/bone maps keyed by component name */
+		Initial = 1,
+
+		/** Per-actor track table, frames stored as track-major transform blocks (never shipped, rejected on load) */
+		TrackTable,
+
+		/** Components and tracks addressed by interned component IDs instead of names (never shipped, rejected on load) */
+		ComponentIds,
+
+		/** Tracks and bones that never change store a single transform (never shipped, rejected on load) */
+		StaticTracks,
+
+		/** Skeletal mesh tracks may only record a subset of the mesh bones */
+		BoneMasks,
+
+		/** Payload split into independently compressed sections addressed by a section table (see FBloodStainFileSection) */
+		SectionTable,
+
+		/** Component metadata strings stored once in a per-file string table and referenced by index */
+		StringTable,
+
+		/** Transform encoding options (delta, linear prediction) stored in the file header */
+		DeltaEncoding,
+
+		/** SmallestThree quantization, its rotation bit depth stored in the file header */
+		SmallestThree,
+
+		/** Frames of streamed recordings stored as blocks encoded while recording (see EBloodStainFileSection::ActorFrameBlocks) */
+		FrameBlocks,
+
+		// -----<new versions can be added above this line>-----
+		VersionPlusOne,
+		Latest = VersionPlusOne - 1
+	};
+}
+
 /**
  * @brief Header prepended to all BloodStain data files
  */
@@ -69,24 +150,134 @@ struct FBloodStainFileHeader
 {
     GENERATED_BODY()
 
-	/** [Unused] Magic identifier ('RStn') and version */
-    uint32 Magic = 0x5253746E;
-    uint32 Version = 1;
+	static constexpr uint32 ExpectedMagic = 0x5253746E;
+
+	/** Magic identifier ('RStn') */
+    uint32 Magic = ExpectedMagic;
+
+	/** Payload layout version, see EBloodStainFileVersion (replicated with the header so clients decode the payload correctly) */
+	UPROPERTY()
+    uint32 Version = EBloodStainFileVersion::Latest;
 
 	/** File I/O options */
     UPROPERTY()
     FBloodStainFileOptions Options;
 
-	/** Size of the uncompressed payload in bytes */
+	/** Size of the uncompressed payload in bytes (sum of the uncompressed sections from SectionTable on) */
 	UPROPERTY()
 	int64 UncompressedSize = 0;
 
+	/**
+	 * true if the payload layout of InVersion can be decoded. TrackTable, ComponentIds and StaticTracks were development
+	 * layouts never shipped by the plugin, they are kept in EBloodStainFileVersion only so the stored numbers do not change.
+	 */
+	static bool IsSupportedVersion(uint32 InVersion)
+	{
+		return InVersion == EBloodStainFileVersion::Initial || (InVersion >= EBloodStainFileVersion::BoneMasks && InVersion <= EBloodStainFileVersion::Latest);
+	}
+
+	/** false if the data is not a BloodStain file, was written by a newer version of the plugin or uses an unsupported layout */
+	bool IsValid() const
+	{
+		return Magic == ExpectedMagic && IsSupportedVersion(Version);
+	}
+
     friend FArchive& operator<<(FArchive& Ar, FBloodStainFileHeader& Header)
 	{
 		Ar << Header.Magic;
 		Ar << Header.Version;
 		Ar << Header.Options;
+		if (Header.Version >= EBloodStainFileVersion::DeltaEncoding)
+		{
+			Ar << Header.Options.EncodingOption;
+			Ar << Header.Options.KeyframeInterval;
+		}
+		if (Header.Version >= EBloodStainFileVersion::SmallestThree)
+		{
+			Ar << Header.Options.RotationBits;
+			if (Ar.IsLoading())
+			{
+				// Same bit depth FQuatSmallestThree::GetComponentBits used when saving, whatever value was stored
+				Header.Options.RotationBits = FMath::Clamp(Header.Options.RotationBits, FBloodStainFileOptions::MinRotationBits, FBloodStainFileOptions::MaxRotationBits);
+			}
+		}
 		Ar << Header.UncompressedSize;
 		return Ar;
 	}
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Kind of data stored in a section of an EBloodStainFileVersion::SectionTable payload
+ */
+namespace EBloodStainFileSection
+{
+	enum Type : uint8
+	{
+		/** Track tables, quantization ranges and component intervals of every actor */
+		Metadata,
+
+		/** Frames and transform blocks of a single actor */
+		ActorFrames,
+
+		/** Frame count and time span of every actor, stored uncompressed so it can be read without decoding anything */
+		Index,
+
+		/**
+		 * Frames of a single streamed actor, as the blocks encoded by FBloodStainStreamWriter while recording. Stored uncompressed,
+		 * layout : [int32 NumBlocks] then per block [int64 UncompressedSize][int64 Size][Size bytes compressed with the file's
+		 * CompressionOption], a block being the frames of its own track table and ranges (see SerializeFrameBlock).
+		 */
+		ActorFrameBlocks
+	};
+}
+
+/**
+ * @brief Entry of the section table at the start of an EBloodStainFileVersion::SectionTable payload.
+ *
+ * Payload layout : [int32 NumSections][FBloodStainFileSection x NumSections][section data...]
+ * Offsets are relative to the start of the payload, so the same payload can be read from a file or received over the network.
+ * Each section is compressed on its own, a section that does not shrink is stored uncompressed.
+ */
+struct FBloodStainFileSection
+{
+	/** EBloodStainFileSection::Type */
+	uint8 Type = EBloodStainFileSection::Metadata;
+
+	ECompressionMethod Compression = ECompressionMethod::None;
+
+	/** Actor the section belongs to, INDEX_NONE for sections covering every actor */
+	int32 ActorIndex = INDEX_NONE;
+
+	int64 Offset = 0;
+	int64 Size = 0;
+	int64 UncompressedSize = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FBloodStainFileSection& Section)
+	{
+		Ar << Section.Type;
+		Ar << Section.Compression;
+		Ar << Section.ActorIndex;
+		Ar << Section.Offset;
+		Ar << Section.Size;
+		Ar << Section.UncompressedSize;
+		return Ar;
+	}
+};
+
+/**
+ * @brief Entry of the EBloodStainFileSection::Index section, one per recorded actor
+ */
+struct FBloodStainActorIndexEntry
+{
+	int32 NumFrames = 0;
+	float StartTime = 0.f;
+	float EndTime = 0.f;
+
+	friend FArchive& operator<<(FArchive& Ar, FBloodStainActorIndexEntry& Entry)
+	{
+		Ar << Entry.NumFrames;
+		Ar << Entry.StartTime;
+		Ar << Entry.EndTime;
+		return Ar;
+	}
+};
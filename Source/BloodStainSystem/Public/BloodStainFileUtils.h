@@ -10,6 +10,7 @@
 #include "HAL/PlatformFilemanager.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
+#include "Templates/Function.h"
 #include "Serialization/MemoryReader.h"
 #include "GhostData.h"
 
@@ -26,16 +27,56 @@ namespace BloodStainFileUtils
 	 * @return Success or failure
 	 */
 	bool SaveToFile(const FRecordSaveData& SaveData, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options = FBloodStainFileOptions());
+
+	/** Same as above, but quantizes and serializes SaveData in place instead of copying it */
+	BLOODSTAINSYSTEM_API bool SaveToFile(FRecordSaveData&& SaveData, const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options = FBloodStainFileOptions());
+
+	/**
+	 * Saves a streamed recording whose frames are already encoded in blocks (see FBloodStainStreamWriter) : the blocks of
+	 * each actor are copied by WriteActorBlocks into its EBloodStainFileSection::ActorFrameBlocks section without being decoded.
+	 * @param SaveData Header and metadata (track table, primary component, intervals) of every actor, without frames
+	 * @param IndexEntries Frame count and time span of every actor
+	 * @param WriteActorBlocks Writes [int32 NumBlocks][blocks...] of an actor to the file, the file is not saved if it returns false
+	 * @param Options Options the blocks were encoded with
+	 * @return Success or failure
+	 */
+	BLOODSTAINSYSTEM_API bool SaveFrameBlocksToFile(FRecordSaveData& SaveData, TArray<FBloodStainActorIndexEntry>& IndexEntries,
+		const TFunctionRef<bool(int32 ActorIndex, FArchive& FileWriter)>& WriteActorBlocks,
+		const FString& LevelName, const FString& FileName, const FBloodStainFileOptions& Options = FBloodStainFileOptions());
+
 	/**
 	 * Project/Saved/BloodStain/<FileName>.bin 에서 이진 로드하여 OutData에 채움
 	 * @param OutData   읽어들인 데이터를 담을 구조체 (empty여도 덮어쓰기)
 	 * @param FileName  확장자 없이 쓸 파일 이름
 	 * @return Success or failure
 	 */
-	bool LoadFromFile(const FString& FileName, const FString& LevelName, FRecordSaveData& OutData);
+	BLOODSTAINSYSTEM_API bool LoadFromFile(const FString& FileName, const FString& LevelName, FRecordSaveData& OutData);
 
 	bool LoadFromFile(const FString& RelativeFilePath, FRecordSaveData& OutData);
 
+	/**
+	 * @brief Loads the recorded actors (RecordActorDataArray) of a file, skipping its record header.
+	 * Only reads, decompresses and dequantizes : the record header may reference a user data struct, load it on
+	 * the game thread with LoadHeaderFromFile. Can be called from any thread.
+	 * @return Success or failure
+	 */
+	bool LoadBodyFromFile(const FString& FileName, const FString& LevelName, FRecordSaveData& OutData);
+
+	/**
+	 * @brief Loads the file header and the payload, as stored (compressed and quantized), skipping the record header.
+	 * Can be called from any thread.
+	 * @return Success or failure
+	 */
+	bool LoadPayloadFromFile(const FString& FileName, const FString& LevelName, FBloodStainFileHeader& OutFileHeader, TArray<uint8>& OutPayload);
+
+	/**
+	 * @brief Decompresses and dequantizes a stored payload into OutData.RecordActorDataArray.
+	 * Reads the section table payloads as well as the single-blob payloads of older versions. Can be called from any thread.
+	 * @param FileHeader The file header stored or replicated with the payload
+	 * @return false if the payload version is unsupported or the data is corrupted
+	 */
+	bool DecodePayload(const TArray<uint8>& Payload, const FBloodStainFileHeader& FileHeader, FRecordSaveData& OutData);
+
 	/**
 	 * @brief Directly loads the header and compressed original data payload from the file.
 	 * @param FileName Name of the file
@@ -68,7 +109,7 @@ namespace BloodStainFileUtils
 
 	int32 LoadAllFiles(TMap<FString, FRecordSaveData>& OutLoadedDataMap);
 	
-	bool DeleteFile(const FString& FileName, const FString& LevelName);
+	BLOODSTAINSYSTEM_API bool DeleteFile(const FString& FileName, const FString& LevelName);
 
 	bool FileExists(const FString& FileName, const FString& LevelName);
 
@@ -82,5 +123,8 @@ namespace BloodStainFileUtils
 
 	FString GetRelativeFilePath(const FString& FileName, const FString& LevelName);
 
+	/** Project/Saved/<PluginSavedDir>Streams/<StreamName>.stream, kept apart from the level folders so it is never listed as a recording */
+	FString GetStreamFilePath(const FString& StreamName);
+
 	const FString& GetPluginSavedDir();
 };
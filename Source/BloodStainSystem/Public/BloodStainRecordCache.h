@@ -0,0 +1,88 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FRecordSaveData;
+
+/** Called with the cache key ("LevelName/FileName") and the accounted size of an evicted entry */
+DECLARE_DELEGATE_TwoParams(FOnRecordCacheEvicted, const FString&, int64);
+
+/** One cached replay body */
+struct FCachedRecordData
+{
+	/** Immutable once cached, shared with every playback session and ghost playing it */
+	TSharedPtr<const FRecordSaveData> RecordData;
+
+	/** File time stamp the data was loaded from, a different time stamp on disk makes the entry stale */
+	FDateTime Timestamp;
+
+	/** Accounted size of RecordData in bytes */
+	int64 NumBytes = 0;
+
+	/** Value of the cache access counter on the last hit, the smallest one is the least recently used */
+	uint64 LastAccess = 0;
+
+	/** An entry referenced outside the cache is in active playback and is never evicted */
+	bool IsPinned() const { return RecordData.IsValid() && !RecordData.IsUnique(); }
+};
+
+/**
+ * Byte-accounted LRU cache of loaded replay bodies, keyed by "LevelName/FileName".
+ *
+ * The budget is BloodStain.Cache.BodyBudgetMB (can be set from the [ConsoleVariables] section of an ini file).
+ * When over budget, the least recently used entries are evicted, skipping the pinned ones :
+ * a replay played by a ghost stays cached as long as the ghost holds it, so the budget is a soft limit.
+ * Hits, misses, evictions and the cached size are reported in stat BloodStain.
+ */
+class BLOODSTAINSYSTEM_API FBloodStainRecordCache
+{
+public:
+	~FBloodStainRecordCache();
+
+	/**
+	 * Looks up an entry and marks it as most recently used.
+	 * A stale entry (loaded from another version of the file) is removed.
+	 * @return nullptr on a miss
+	 */
+	TSharedPtr<const FRecordSaveData> Find(const FString& Key, const FDateTime& Timestamp);
+
+	/** Caches the data loaded from a file, replacing any previous entry, then trims the cache to its budget */
+	void Add(const FString& Key, const TSharedRef<const FRecordSaveData>& Data, const FDateTime& Timestamp);
+
+	bool Contains(const FString& Key) const { return Entries.Contains(Key); }
+
+	void Remove(const FString& Key);
+
+	void Empty();
+
+	/** Evicts the least recently used unpinned entries until the cache fits in its budget */
+	void Trim();
+
+	/** Estimated memory held by a replay body */
+	static int64 GetAllocatedSize(const FRecordSaveData& Data);
+
+	int64 GetNumBytes() const { return NumBytes; }
+	int32 GetNumHits() const { return NumHits; }
+	int32 GetNumMisses() const { return NumMisses; }
+	int32 GetNumEvictions() const { return NumEvictions; }
+
+	/** Called after an entry is evicted by Trim, not when it is removed explicitly */
+	FOnRecordCacheEvicted OnEvicted;
+
+private:
+	void RemoveEntry(const FString& Key, int64 EntryBytes);
+
+	TMap<FString, FCachedRecordData> Entries;
+
+	int64 NumBytes = 0;
+	uint64 AccessCounter = 0;
+
+	int32 NumHits = 0;
+	int32 NumMisses = 0;
+	int32 NumEvictions = 0;
+};
@@ -5,19 +5,73 @@
 
 #pragma once
 
-#include "Containers/CircularQueue.h"
+#include "CoreMinimal.h"
+#include "GhostData.h"
 
-struct FRecordFrame;
-struct FComponentActiveInterval;
-struct FRecordActorSaveData;
+class FRecordFrameSlab;
+
+/**
+ * Frame slab and track data of a stopped recorder, detached from it in O(1) so it can be cooked off the game thread.
+ * Nothing else references the slab once it is detached.
+ * A snapshot of a live recorder has no slab, its raw frames are copied into GhostSaveData.RecordedFrames instead.
+ */
+struct FDetachedRecordData
+{
+	FName ActorName = NAME_None;
+	TSharedPtr<FRecordFrameSlab> FrameSlabPtr = nullptr;
+
+	/** Holds the primary component and track table, filled with the cooked frames by CookDetachedRecord */
+	FRecordActorSaveData GhostSaveData = FRecordActorSaveData();
+	TArray<FComponentActiveInterval> ComponentIntervals;
+	FInstancedStruct UserData = FInstancedStruct();
+};
 
 namespace BloodStainRecordDataUtils
 {
 	/**
-	 * Cook QueuedFrameData to SaveData
+	 * Cook QueuedFrameData to SaveData, emptying the slab
+	 */
+	bool CookQueuedFrames(float SamplingInterval, const float& ClipStartTime, FRecordFrameSlab* FrameSlabPtr, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals);
+
+	/** Copies the frames of the slab recorded from ClipStartTime, with timestamps relative to ClipStartTime. The slab is left untouched */
+	void CopyQueuedFrames(const FRecordFrameSlab& FrameSlab, float ClipStartTime, TArray<FRecordFrame>& OutFrames);
+
+	/**
+	 * Cooks the frames of a detached recorder from ClipStartTime into its GhostSaveData, safe to call from any thread.
+	 * Without a slab (snapshot), the frames already copied into GhostSaveData.RecordedFrames are cooked.
+	 */
+	BLOODSTAINSYSTEM_API bool CookDetachedRecord(float SamplingInterval, float ClipStartTime, FDetachedRecordData& InOutRecord);
+
+	/**
+	 * Cook frames already copied out of the slab to SaveData.
+	 * OutGhostSaveData must already hold the actor's track table.
+	 */
+	BLOODSTAINSYSTEM_API bool CookFrames(TArray<FRecordFrame>&& RawFrames, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals);
+
+	/**
+	 * Rebases the component intervals recorded from FirstFrameIndex onto the NumSavedFrames saved frames, into OutGhostSaveData.
+	 * Does not need the frames, so a streamed recording can be described without decoding its blocks.
+	 */
+	void BuildInitialComponentStructure(int32 FirstFrameIndex, int32 NumSavedFrames, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals);
+
+	/**
+	 * Pads every frame's transform blocks to the size of the track table,
+	 * so frames recorded before a component was attached can be indexed by any track.
+	 */
+	void NormalizeFrameLayout(FRecordActorSaveData& InOutSaveData);
+
+	/**
+	 * Flags the component tracks and bones whose recorded transforms never change,
+	 * so the file stores a single transform for them. Must run after RestoreIntervalBoundaryKeys.
+	 */
+	void DetectStaticTracks(FRecordActorSaveData& InOutSaveData);
+
+	/**
+	 * Marks the first and last frame of every component interval as a key.
+	 * With keyframe reduction, the key preceding a clip window may have been cut off; the transforms of
+	 * dropped samples are still in the frames, so the boundary samples are restored as keys.
 	 */
-	bool CookQueuedFrames(float SamplingInterval, const float& ClipStartTime, TCircularQueue<FRecordFrame>* FrameQueuePtr, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals);
-	void BuildInitialComponentStructure(int32 FirstFrameIndex, FRecordActorSaveData& OutGhostSaveData, TArray<FComponentActiveInterval>& OutComponentIntervals);
+	void RestoreIntervalBoundaryKeys(FRecordActorSaveData& InOutSaveData);
 
 
 
@@ -0,0 +1,56 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Tickable.h"
+#include "BloodStainRecordSampler.generated.h"
+
+class URecordComponent;
+
+/**
+ * Records every active URecordComponent of the owning UBloodStainSubsystem in one batch.
+ * Ticks as a tickable object, i.e. after all world tick groups (and animation evaluation) have completed.
+ * Bound to the game instance's world : ticked with its dilated DeltaTime, not while it is paused, and only while a group is recording.
+ * Sampling clocks and attachment changes are handled on the game thread, transforms are captured with ParallelFor.
+ *
+ * Recorders are given staggered sampling phases, and samples that would exceed BloodStain.Record.FrameBudgetMs
+ * are deferred to the next frame. A deferred sample is stamped with the time it is actually taken.
+ */
+UCLASS()
+class BLOODSTAINSYSTEM_API UBloodStainRecordSampler : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableWhenPaused() const override { return false; }
+
+	/** @return Sampling phase (fraction of SamplingInterval) for a new recorder, spread by a low-discrepancy sequence */
+	float AllocateSamplePhase();
+
+	/** Number of frames whose sampling exceeded BloodStain.Record.FrameBudgetMs */
+	int32 GetNumBudgetOverruns() const { return NumBudgetOverruns; }
+
+private:
+	/** Reused recorder lists, only valid during Tick */
+	TArray<URecordComponent*> ActiveRecorders;
+	TArray<URecordComponent*> DueRecorders;
+
+	/** Index into the active recorders to start from, the first deferred recorder goes first on the next frame */
+	int32 FirstRecorderIndex = 0;
+
+	/** Moving average of the game thread time spent per sample, used to predict the cost of a frame */
+	double AverageSampleSeconds = 0.0;
+
+	int32 NextPhaseIndex = 0;
+	int32 NumBudgetOverruns = 0;
+};
@@ -0,0 +1,151 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BloodStainFileOptions.h"
+#include "GhostData.h"
+#include "Containers/SpscQueue.h"
+#include <atomic>
+
+class IFileHandle;
+class FRecordFrameSlab;
+
+/**
+ * Background encoder of a streamed recording (FBloodStainRecordOptions::bStreamToDisk).
+ *
+ * The game thread hands sealed frame slabs over through a single-producer lock-free queue without copying them.
+ * A single worker task drains the queue : it unpacks each slab into a block, quantizes and encodes it with the
+ * recording's file options, compresses it, appends it to the stream file and returns the emptied slab to a pool for reuse.
+ * Only the slabs in flight are held in memory, the sealed blocks take their encoded size on disk. Once the recording
+ * stops, Finalize hands the closed stream to the recording file writer, which copies the blocks of each actor into
+ * the file as they are (see CopyActorBlocks).
+ *
+ * Each block is cooked on its own : it stores its own quantization ranges and static tracks, and the delta encoding
+ * starts over with a keyframe. Keyframe reduction never drops the boundary samples of a block, so it needs nothing
+ * from the blocks around it.
+ *
+ * Stream layout : a sequence of [int64 UncompressedSize][int64 Size][Size bytes], each block being stored exactly as in
+ * the EBloodStainFileSection::ActorFrameBlocks section of the recording file. The actor of each block is kept in memory.
+ */
+class BLOODSTAINSYSTEM_API FBloodStainStreamWriter : public TSharedFromThis<FBloodStainStreamWriter>
+{
+public:
+	FBloodStainStreamWriter(const FString& InStreamFilePath, const FBloodStainFileOptions& InFileOptions);
+	~FBloodStainStreamWriter();
+
+	/** Creates the stream file, @return false if it cannot be written */
+	bool Open();
+
+	/**
+	 * Queues a sealed slab to be encoded and appended in the background. Game thread only.
+	 * @param StreamActorIndex Index of the recorder within the stream
+	 * @param PrimaryComponentId Primary component of the recorder
+	 * @param ComponentTracks Track table of the recorder, covering every track of the slab
+	 * @param FrameSlab Frames of the block, owned by the writer until it is handed back by AcquireFrameSlab
+	 */
+	void AppendBlock(int32 StreamActorIndex, int32 PrimaryComponentId, const TArray<FRecordComponentTrack>& ComponentTracks, TSharedPtr<FRecordFrameSlab>&& FrameSlab);
+
+	/** @return An emptied slab of a block already written, nullptr if none is free yet. Game thread only */
+	TSharedPtr<FRecordFrameSlab> AcquireFrameSlab();
+
+	/**
+	 * Closes the stream once every block is written, then deletes it once OnStreamClosed returns.
+	 * OnStreamClosed is called on a worker thread, the blocks can be read with CopyActorBlocks and GetActorSummary
+	 * until it returns. bSuccess is false if a block could not be written.
+	 */
+	void Finalize(TUniqueFunction<void(bool bSuccess, const FBloodStainStreamWriter& Stream)>&& OnStreamClosed);
+
+	/** Frames written for a stream actor */
+	struct FStreamActorSummary
+	{
+		/** Frame count and time span */
+		FBloodStainActorIndexEntry IndexEntry;
+
+		/** Recorder frame index of the first frame, INDEX_NONE if no frame was written */
+		int32 FirstFrameIndex = INDEX_NONE;
+
+		/** Transform of the primary component in the first frame, unset if it was not recorded */
+		TOptional<FTransform> FirstPrimaryTransform;
+	};
+
+	/** @return The frames written for a stream actor. Only valid within Finalize's callback */
+	FStreamActorSummary GetActorSummary(int32 StreamActorIndex) const;
+
+	/**
+	 * Writes [int32 NumBlocks] and the encoded blocks of a stream actor to Ar, in recording order, without decoding them
+	 * (see EBloodStainFileSection::ActorFrameBlocks). Only valid within Finalize's callback.
+	 * @return false if the stream cannot be read or Ar cannot be written
+	 */
+	bool CopyActorBlocks(int32 StreamActorIndex, FArchive& Ar) const;
+
+	/** Closes and deletes the stream once every block is written (recording stopped without saving) */
+	void Discard();
+
+	const FBloodStainFileOptions& GetFileOptions() const { return FileOptions; }
+
+private:
+	enum class EStreamCommand : uint8
+	{
+		AppendBlock,
+		Finalize,
+		Discard
+	};
+
+	struct FStreamCommand
+	{
+		EStreamCommand Command = EStreamCommand::AppendBlock;
+		int32 StreamActorIndex = INDEX_NONE;
+		int32 PrimaryComponentId = INDEX_NONE;
+		TArray<FRecordComponentTrack> ComponentTracks;
+		TSharedPtr<FRecordFrameSlab> FrameSlab;
+		TUniqueFunction<void(bool bSuccess, const FBloodStainStreamWriter& Stream)> OnStreamClosed;
+	};
+
+	/** Location of a block in the stream file */
+	struct FStreamBlock
+	{
+		int32 StreamActorIndex = INDEX_NONE;
+		int64 Offset = 0;
+		int64 Size = 0;
+
+		/** Frames of the block only */
+		FStreamActorSummary Summary;
+	};
+
+	/** Pushes a command and schedules the worker if it is idle */
+	void Submit(FStreamCommand&& Command);
+
+	/** Worker task body, processes commands until the queue is empty */
+	void Drain();
+
+	void ProcessCommand(FStreamCommand& Command);
+	void WriteBlock(FStreamCommand& Command);
+
+	FString StreamFilePath;
+	FBloodStainFileOptions FileOptions;
+
+	/** Game thread to worker */
+	TSpscQueue<FStreamCommand> CommandQueue;
+
+	/** Worker to game thread, emptied slabs ready for reuse */
+	TSpscQueue<TSharedPtr<FRecordFrameSlab>> FreeSlabs;
+
+	/** Set while a worker task owns the consumer side of CommandQueue */
+	std::atomic<bool> bDrainScheduled = false;
+
+	/** Only accessed by the worker once the stream is open */
+	TUniquePtr<IFileHandle> FileHandle;
+
+	/** Set by a failed write, the following blocks are dropped and the stream is not saved */
+	bool bWriteFailed = false;
+
+	/** Every block written, in stream order. Only accessed by the worker */
+	TArray<FStreamBlock> Blocks;
+
+	/** Write position of the next block */
+	int64 StreamSize = 0;
+};
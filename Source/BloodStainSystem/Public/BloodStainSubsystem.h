@@ -10,18 +10,26 @@
 #include "GhostData.h"
 #include "BloodStainActor.h"
 #include "BloodStainFileOptions.h" 
+#include "BloodStainRecordCache.h"
+#include "BloodStainStreamWriter.h"
 #include "BloodStainSubsystem.generated.h"
 
 class AGhostPlayerController;
 class ABloodStainManager;
 class AReplayActor;
 class URecordComponent;
+class UBloodStainRecordSampler;
 class UReplayTerminatedActorManager;
 struct FBloodStainRecordOptions;
 struct FGameplayTagContainer;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBuildRecordingHeader, FName, GroupName);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBloodStainReadyOnClient, ABloodStainActor*, ReadyActor);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnRecordBodyEvicted, const FString&, FileName, const FString&, LevelName);
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnReplayStarted, bool, bSuccess, FGuid, PlaybackKey);
+
+/** Returns the significance in [0, 1] of a recorder using significance sampling */
+DECLARE_DELEGATE_RetVal_OneParam(float, FOnEvaluateRecordSignificance, const URecordComponent*);
 
 struct FIncomingClientFile
 {
@@ -30,6 +38,17 @@ struct FIncomingClientFile
 	int64 ExpectedSize;
 };
 
+/** A recorder that finished streaming, its encoded blocks are copied from the stream when its group is saved */
+struct FStreamedRecordActor
+{
+	FName ActorName;
+	int32 StreamActorIndex = INDEX_NONE;
+
+	/** Track table, primary component and raw component intervals (see URecordComponent::FinishStream) */
+	FRecordActorSaveData ActorData;
+	FInstancedStruct UserData;
+};
+
 /** @brief Recording group for one or more actors, saved as a single file.
  * 
  *	manages the spawn point, recording options, and active recorders.
@@ -62,6 +81,15 @@ struct FBloodStainRecordGroup
 	 *  If null, it is set to the middle position of the Actors. */
 	UPROPERTY()
 	TWeakObjectPtr<AActor> RecordingMainActor;
+
+	/** Writer of the group's stream file, only if RecordOptions.bStreamToDisk */
+	TSharedPtr<FBloodStainStreamWriter> StreamWriter;
+
+	/** Stream actor index of the next recorder */
+	int32 NumStreamActors = 0;
+
+	/** Streamed recorders that stopped (or are stopping with the group) and are saved with the group */
+	TArray<FStreamedRecordActor> FinishedStreamActors;
 };
 
 /** @brief Playback group: tracks active replay actors for a single replay session.
@@ -76,6 +104,15 @@ struct FBloodStainPlaybackGroup
 	TArray<TObjectPtr<AReplayActor>> ActiveReplayers;
 };
 
+/** A StartReplayFromFileAsync request waiting for its file to be loaded */
+struct FPendingReplayRequest
+{
+	TWeakObjectPtr<APlayerController> RequestingController;
+	FGuid PlaybackKey;
+	FBloodStainPlaybackOptions PlaybackOptions;
+	FOnReplayStarted OnReplayStarted;
+};
+
 USTRUCT()
 struct FPendingActorData
 {
@@ -102,24 +139,6 @@ struct FPendingGroup
 	TWeakObjectPtr<AActor> RecordingMainActor = nullptr;
 };
 
-USTRUCT()
-struct FCachedRecordData
-{
-	GENERATED_BODY()
-	
-	UPROPERTY()
-	FRecordSaveData RecordData;
-
-	UPROPERTY()
-	FDateTime Timestamp;
-
-	FCachedRecordData() = default;
-	FCachedRecordData(FRecordSaveData&& InData, const FDateTime& InTimestamp)
-		: RecordData(MoveTemp(InData))
-		, Timestamp(InTimestamp)
-	{}
-};
-
 /**
  * @brief BloodStain recording and playback subsystem.
  *
@@ -193,6 +212,34 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category="BloodStain|Record")
 	void StopRecordComponent(URecordComponent* RecordComponent, bool bSaveRecordingData = true);
+
+	/**
+	 *  @brief Takes a snapshot of the last seconds of a recording group without stopping it, e.g. for kill-cams.
+	 *  
+	 *  Only the frames inside the snapshot window are copied out of the recorders' ring buffers, recording continues
+	 *  without losing continuity. Actors terminated during the window are included. The snapshot is cooked immediately.
+	 *  
+	 *  @param GroupName         The recording group. If NAME_None, the default group is used.
+	 *  @param SnapshotDuration  Length of the snapshot in seconds, clamped to the group's MaxRecordTime.
+	 *  @param Actors            Actors to include. If empty, every actor of the group is included.
+	 *  @param OutSnapshot       The cooked recording, ready for playback or saving.
+	 *  @return True if at least one actor has frames in the window.
+	 */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|Record")
+	bool CreateRecordingSnapshot(FName GroupName, float SnapshotDuration, const TArray<AActor*>& Actors, FRecordSaveData& OutSnapshot);
+
+	/**
+	 *  @brief Takes a snapshot of the last seconds of a recording group without stopping it and saves it in the background.
+	 *  
+	 *  @param GroupName         The recording group. If NAME_None, the default group is used.
+	 *  @param SnapshotDuration  Length of the snapshot in seconds, clamped to the group's MaxRecordTime.
+	 *  @param Actors            Actors to include. If empty, every actor of the group is included.
+	 *  @param FileName          Name of the saved file. If NAME_None, "<GroupName>-Snapshot-<Timestamp>" is used.
+	 *  @return True if the snapshot was taken and queued for saving.
+	 *  @see CreateRecordingSnapshot
+	 */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|Record")
+	bool SaveRecordingSnapshot(FName GroupName, float SnapshotDuration, const TArray<AActor*>& Actors, FName FileName = NAME_None);
 	
 	/**
 	 *  @brief Starts a replay using a BloodStainActor instance in the world.
@@ -209,8 +256,7 @@ public:
 	/**
 	 *  @brief Starts a replay directly from a file.
 	 *  Loads the replay data from disk (if not cached) and spawns replay actors.
-	 *  
-	 *  TODO : Make this file I/O asynchronous in order to avoid hitches.
+	 *  The file is read on the game thread, use StartReplayFromFileAsync to avoid hitches.
 	 *  
 	 *  @param RequestingController
 	 *  @param FileName          The name of the replay file.
@@ -223,6 +269,56 @@ public:
 	bool StartReplayFromFile(APlayerController* RequestingController, const FString& FileName, const FString& LevelName, FGuid& OutGuid, FBloodStainPlaybackOptions
 	                         PlaybackOptions = FBloodStainPlaybackOptions());
 
+	/**
+	 *  @brief Asynchronous StartReplayFromFile.
+	 *  The file is read, decompressed and dequantized on a worker thread, only the replay actors are spawned on the game thread.
+	 *  Requests for a file already being loaded share the load. A cached replay starts immediately.
+	 *  
+	 *  @param RequestingController
+	 *  @param FileName          The name of the replay file.
+	 *  @param LevelName         The level where the replay was recorded.
+	 *  @param OnReplayStarted   Called on the game thread once the replay started or failed to. May be called before this function returns.
+	 *  @param PlaybackOptions   Playback settings (rate, looping, etc.).
+	 *  @return The playback key the replay will have, valid as soon as this returns. StopReplay with it cancels the pending request.
+	 *          Invalid on a client, where the server starts the replay.
+	 */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|Replay", meta=(AutoCreateRefTerm="OnReplayStarted"))
+	FGuid StartReplayFromFileAsync(APlayerController* RequestingController, const FString& FileName, const FString& LevelName, const FOnReplayStarted& OnReplayStarted,
+	                               FBloodStainPlaybackOptions PlaybackOptions = FBloodStainPlaybackOptions());
+
+	/** Returns if a StartReplayFromFileAsync request is still loading its file */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|Replay")
+	bool IsReplayLoading(const FGuid& InPlaybackKey) const;
+
+	/**
+	 *  @brief Starts a replay from recording data already in memory, e.g. a snapshot, without a file round-trip.
+	 *  The data is shared by reference, playback starts in the same frame. Standalone only.
+	 *  
+	 *  @param RecordSaveData         The cooked recording to play.
+	 *  @param PlaybackOptions        Playback settings (rate, looping, etc.).
+	 *  @param OutGuid                Returns the unique ID of the new playback session.
+	 *  @param bSaveFileInBackground  If true, the recording is also written to its file (Header.FileName / LevelName) in the background.
+	 *  @return True on success, false otherwise.
+	 */
+	bool StartReplayFromSaveData(const TSharedRef<const FRecordSaveData>& RecordSaveData, const FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid, bool bSaveFileInBackground = false);
+
+	/**
+	 *  @brief Kill-cam helper : snapshots the last seconds of a recording group and plays them back immediately.
+	 *  The group keeps recording.
+	 *  
+	 *  @param GroupName              The recording group. If NAME_None, the default group is used.
+	 *  @param SnapshotDuration       Length of the replay in seconds, clamped to the group's MaxRecordTime.
+	 *  @param Actors                 Actors to replay. If empty, every actor of the group is replayed.
+	 *  @param OutGuid                Returns the unique ID of the new playback session.
+	 *  @param PlaybackOptions        Playback settings (rate, looping, etc.).
+	 *  @param bSaveFileInBackground  If true, the snapshot is also saved to a file in the background.
+	 *  @return True on success, false otherwise.
+	 *  @see CreateRecordingSnapshot
+	 */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|Replay")
+	bool StartReplayFromSnapshot(FName GroupName, float SnapshotDuration, const TArray<AActor*>& Actors, FGuid& OutGuid,
+		FBloodStainPlaybackOptions PlaybackOptions = FBloodStainPlaybackOptions(), bool bSaveFileInBackground = false);
+
 	UFUNCTION(BlueprintCallable, Category="BloodStain|Replay")
 	bool IsPlaying(const FGuid& InPlaybackKey) const;
 	
@@ -271,6 +367,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category="BloodStain|Record")
 	void NotifyComponentDetached(AActor* TargetActor, USceneComponent* DetachedComponent);
 
+	/**
+	 *  @brief Notifies the recording system that the attachment hierarchy of a recorded actor changed in a way
+	 *  the recorder cannot detect itself (e.g. component tags changed). Rescans the hierarchy on the next sample.
+	 *  
+	 *  @param TargetActor    The actor that is being recorded.
+	 */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|Record")
+	void NotifyAttachmentsChanged(AActor* TargetActor);
+
 	/** Set Main Actor for specify the SpawnPointTransform position
 	 *  If null, it is set to the middle position of the Actors. */
 	UFUNCTION(BlueprintCallable, Category="BloodStain|Record")
@@ -281,6 +386,31 @@ public:
 
 	UFUNCTION()
 	void DeleteAllBloodStainActors();
+
+	/** Appends the RecordComponents of every active recording group, used by UBloodStainRecordSampler */
+	void GetActiveRecorders(TArray<URecordComponent*>& OutRecorders) const;
+
+	/** true while at least one recording group exists, the record sampler only ticks then */
+	bool HasActiveRecordGroups() const { return !BloodStainRecordGroups.IsEmpty(); }
+
+	/**
+	 *  @brief Forces the significance of a recorded actor, e.g. 1 for the dying player so it is always sampled at full rate.
+	 *  Only used if the actor's group records with bUseSignificanceSampling.
+	 *  
+	 *  @param TargetActor    The actor that is being recorded.
+	 *  @param Significance   Significance in [0, 1], a negative value restores the evaluated significance.
+	 */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|Record")
+	void SetRecordActorSignificance(AActor* TargetActor, float Significance);
+
+	/**
+	 * Significance of a recorder, in order : its override, 1 for the group main actor and player controlled pawns,
+	 * OnEvaluateRecordSignificance if bound, else the distance to the nearest player view (halved when not rendered).
+	 */
+	float EvaluateRecordSignificance(const URecordComponent* Recorder) const;
+
+	/** Game specific significance policy (gameplay importance), replaces the distance based evaluation */
+	FOnEvaluateRecordSignificance OnEvaluateRecordSignificance;
 public:
 	/**
 	 *	Finds all replay files for a given level and loads their headers into the cache.
@@ -311,6 +441,13 @@ public:
 	/** Loads full replay data (body) for a file, loading it from disk it not already cached */
 	UFUNCTION(BlueprintCallable, Category="BloodStain|File")
 	bool FindOrLoadRecordBodyData(const FString& FileName, const FString& LevelName, FRecordSaveData& OutData);
+
+	/**
+	 * @brief Same as FindOrLoadRecordBodyData, without copying the replay data.
+	 * The returned data is shared with the cache and must not be modified.
+	 * @return nullptr if the file cannot be loaded
+	 */
+	TSharedPtr<const FRecordSaveData> FindOrLoadSharedRecordBodyData(const FString& FileName, const FString& LevelName);
 	
 	/** Returns if the header data for a given replay file is currently in the memory cache. */
 	UFUNCTION(BlueprintCallable, Category="BloodStain|File")
@@ -344,6 +481,10 @@ public:
 	
 	UFUNCTION(BlueprintCallable, Category="BloodStain|File")
 	void ClearAllCachedData();
+
+	/** Memory held by the cached replay bodies, in bytes. The budget is BloodStain.Cache.BodyBudgetMB */
+	UFUNCTION(BlueprintCallable, Category="BloodStain|File")
+	int64 GetCachedBodyDataSize() const;
 	
 	UFUNCTION(BlueprintCallable, Category="BloodStain|File")
 	bool DeleteFile(const FString& FileName, const FString& LevelName);
@@ -406,30 +547,88 @@ public:
 	FInstancedStruct GetReplayUserHeaderData(const FName& GroupName);
 
 	void ClearReplayUserHeaderData(const FName& GroupName);
-	
+
+	/**
+	 * Moves the cooked records into InOutSaveData and takes the spawn point from the main actor's first frame.
+	 * Runs on the save task once every record is cooked, the frame buffers are moved and never copied.
+	 * @return false if no record has frames
+	 */
+	static bool AssembleCookedRecords(TArray<FDetachedRecordData>& Records, const FName& MainActorName, FRecordSaveData& InOutSaveData);
+
 private:
 	/**
 	 * @brief The core implementation for initiating a replay session in single-player mode.
 	 * Takes fully loaded replay data and spawns all necessary AReplayActor instances,
 	 * attaching and initializing a UPlayComponent to each one to begin playback.
+	 * The ghosts reference RecordSaveData, no replay data is copied.
+	 * @param PlaybackKey Key of the new session, a new one is created if invalid
 	 */
-	bool StartReplay_Standalone(const FRecordSaveData& RecordSaveData, const FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid);
+	bool StartReplay_Standalone(const TSharedRef<const FRecordSaveData>& RecordSaveData, const FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid,
+	                            const FGuid& PlaybackKey = FGuid());
 
 	/**
  	 * @brief Starts a replay session in networked mode.
  	 *
  	 * This function is intended for networked replay scenarios.
  	 * In network mode, each ReplayActor is responsible for deserializing, dequantizing, and decompressing its own data.
+ 	 * @param PlaybackKey Key of the new session, a new one is created if invalid
  	 */
 	bool StartReplay_Networked(APlayerController* RequestingController, const FString& FileName, const FString& LevelName, const FBloodStainFileHeader
 	                           & FileHeader, const FRecordHeaderData& RecordHeader, const TArray<uint8>& CompressedPayload, const
-	                           FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid);
+	                           FBloodStainPlaybackOptions& PlaybackOptions, FGuid& OutGuid, const FGuid& PlaybackKey = FGuid());
+
+	/** [Game thread] Caches the body and record header loaded by StartReplayFromFileAsync and starts the requests waiting for it. Loaded is null if the load failed */
+	void FinishAsyncBodyLoad(const FString& FileName, const FString& LevelName, const TSharedPtr<FRecordSaveData>& Loaded, const FDateTime& Timestamp);
+
+	/** [Game thread] Caches the record header and starts the networked requests waiting for a payload loaded by StartReplayFromFileAsync */
+	void FinishAsyncPayloadLoad(const FString& FileName, const FString& LevelName, bool bLoaded, const FBloodStainFileHeader& FileHeader, FRecordHeaderData&& RecordHeader, const TArray<uint8>& Payload);
+
+	/** Queues a StartReplayFromFileAsync request, @return true if the file is not being loaded yet */
+	bool AddPendingReplay(const FString& RelativeFilePath, FPendingReplayRequest&& Request);
+
+	/** Removes a pending StartReplayFromFileAsync request and reports it as failed, @return false if no request has this key */
+	bool CancelPendingReplay(const FGuid& PlaybackKey);
 	
 	/** Internal helper to package actor-specific data into the final save format.
 	 *  Aggregates multiple FRecordActorSaveData instances into a single FRecordSaveData.
 	 */
 	FRecordSaveData ConvertToSaveData(float EndTime, const FName& GroupName, const FName& FileName, const FName& LevelName, TArray<FRecordActorSaveData>& RecordActorDataArray);
 
+	/** @return File name of the group recording, "<GroupName>-<Timestamp>" unless set in the record options */
+	FName ResolveRecordFileName(const FName& GroupName, FBloodStainRecordGroup& RecordGroup) const;
+
+	/** Called on the game thread once a recording file is written, starts uploading it to the server from clients */
+	void OnRecordingFileSaved(const FString& FinalFilePath, const FRecordHeaderData& Header);
+
+	/** Writes the remaining frames of a streamed recorder and keeps its data until the group is saved */
+	void FinishStreamedRecorder(FBloodStainRecordGroup& RecordGroup, const AActor* Actor, URecordComponent* RecordComponent);
+
+	/**
+	 * Saves a group recorded in memory : the game thread only detaches the frame slabs and builds the header,
+	 * cooking, quantization and serialization run as background tasks.
+	 * @return false if the group has no recorder to save
+	 */
+	bool SaveQueuedRecording(const FName& GroupName);
+
+	/** Cooks every record in its own task, then assembles and saves the recording once they all completed */
+	void CookAndSaveRecording(TArray<FDetachedRecordData>&& Records, FRecordHeaderData&& Header, const FName& MainActorName, float SamplingInterval, float ClipStartTime, const FString& MapName, const FString& FileName);
+
+	/**
+	 * Copies the last SnapshotDuration seconds of the group's active and terminated recorders and builds the snapshot header.
+	 * @return false if the group cannot be snapshotted
+	 */
+	bool CollectSnapshotRecords(const FName& GroupName, float SnapshotDuration, const TArray<AActor*>& Actors, const FName& FileName,
+		TArray<FDetachedRecordData>& OutRecords, FRecordHeaderData& OutHeader, FName& OutMainActorName, float& OutClipStartTime);
+
+	/** Runs on a worker thread : writes a cooked recording and notifies the subsystem on the game thread if it is still alive */
+	static void SaveCookedRecording(const TWeakObjectPtr<UBloodStainSubsystem>& WeakSubsystem, FRecordSaveData&& RecordSaveData, const FString& MapName, const FString& FileName, const FBloodStainFileOptions& FileOptions);
+
+	/**
+	 * Saves a group recorded with RecordOptions.bStreamToDisk : the header is built here, then in the background the blocks
+	 * already encoded in the stream are copied to the recording file without being decoded (see SaveFrameBlocksToFile).
+	 */
+	void SaveStreamedRecording(const FName& GroupName);
+
 	/** @return true if a recording group is still valid */
 	bool IsValidReplayGroup(const FName& GroupName);
 	
@@ -462,6 +661,10 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "BloodStain|File")
 	FOnBuildRecordingHeader OnCompleteBuildRecordingHeader;
 
+	/** Called when a cached replay body is evicted to stay in the cache budget. Its header stays cached */
+	UPROPERTY(BlueprintAssignable, Category = "BloodStain|File")
+	FOnRecordBodyEvicted OnRecordBodyEvicted;
+
 	/** Distance to trace downwards to find the ground when spawning a BloodStainActor. */
 	static float LineTraceLength;
 
@@ -485,6 +688,11 @@ private:
 	UPROPERTY(Transient)
 	TMap<FGuid, FBloodStainPlaybackGroup> BloodStainPlaybackGroups;
 
+	/**
+	 * Key is "LevelName/FileName"
+	 * StartReplayFromFileAsync requests waiting for their file to be loaded, one load per file */
+	TMap<FString, TArray<FPendingReplayRequest>> PendingReplayLoads;
+
 	/**
 	 * Key is "LevelName/FileName" 
 	 * Cached replay data's headers */
@@ -493,13 +701,16 @@ private:
 	
 	/**
 	* Key is "LevelName/FileName"
-	 * Cached full replay data */
-	UPROPERTY()
-	TMap<FString, FCachedRecordData> CachedRecordings;
+	 * Cached full replay data, LRU evicted above its memory budget */
+	FBloodStainRecordCache CachedRecordings;
 
 	/** Manages data from actors that were destroyed mid-recording, holding it until the session is saved. */
 	UPROPERTY()
 	TObjectPtr<UReplayTerminatedActorManager> ReplayTerminatedActorManager;
+
+	/** Samples all active RecordComponents in one batch */
+	UPROPERTY()
+	TObjectPtr<UBloodStainRecordSampler> RecordSampler;
 	
 	/** Default material used for "Replaying actors" if recorded material is null or bUseGhostMaterial is true */
 	UPROPERTY()
@@ -22,12 +22,18 @@ class BLOODSTAINSYSTEM_API UGhostAnimInstance : public UAnimInstance
 public:
 	UGhostAnimInstance();
 
-	/** Apply external pose for current frame */
-	void SetTargetPose(const TArray<FTransform>& InPose);
+	/**
+	 * Apply external pose for current frame
+	 * @param InBoneIndices Mesh bone index of each pose entry, empty if the pose holds every bone in order
+	 */
+	void SetTargetPose(const TArray<FTransform>& InPose, const TArray<int32>& InBoneIndices);
 
 	/** Get read-only current bone pose */
 	const TArray<FTransform>& GetPose() const { return BonePose; }
 
+	/** Get mesh bone index of each pose entry, empty if the pose holds every bone */
+	const TArray<int32>& GetBoneIndices() const { return BoneIndices; }
+
 protected:
 	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
 	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override;
@@ -36,5 +42,8 @@ private:
 	/** Raw bone-space transforms passed from replay system */
 	TArray<FTransform> BonePose;
 
+	/** Mesh bone index of each BonePose entry, bones that were not recorded keep the reference pose */
+	TArray<int32> BoneIndices;
+
 	friend class FGhostAnimInstanceProxy;
 };
\ No newline at end of file
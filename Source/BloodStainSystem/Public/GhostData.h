@@ -45,10 +45,15 @@ struct FComponentRecord
 {
 	GENERATED_BODY()
 
-	/** Component name, used to find or create the component on replay */
+	/** Component name, used as the object name of the component created on replay */
 	UPROPERTY(BlueprintReadWrite, Category = "BloodStain")
 	FString ComponentName;
 
+	/** Per-recording component ID, interned once when the component joins the recording.
+	 *  Also the index of the component's track in FRecordActorSaveData::ComponentTracks */
+	UPROPERTY(BlueprintReadOnly, Category = "BloodStain")
+	int32 ComponentId = INDEX_NONE;
+
 	/** Name of the component this component is attached to (Parent Component Name). */
 	UPROPERTY(BlueprintReadWrite, Category = "BloodStain")
 	FString AttachParentComponentName;
@@ -85,6 +90,13 @@ struct FComponentRecord
 	bool bVisible = true;
 	
 	friend FArchive& operator<<(FArchive& Ar, FComponentRecord& ComponentRecord)
+	{
+		Ar << ComponentRecord.ComponentId;
+		return SerializeMetadata(Ar, ComponentRecord);
+	}
+
+	/** Serializes everything except the component ID (layout of EBloodStainFileVersion::Initial) */
+	static FArchive& SerializeMetadata(FArchive& Ar, FComponentRecord& ComponentRecord)
 	{
 		Ar << ComponentRecord.ComponentName;
 		Ar << ComponentRecord.AttachParentComponentName;
@@ -130,7 +142,7 @@ struct FComponentActiveInterval
 	
 	bool operator==(const FComponentActiveInterval& Other) const
 	{
-		return Meta.ComponentName == Other.Meta.ComponentName;
+		return Meta.ComponentId == Other.Meta.ComponentId;
 	}
 
 	friend FArchive& operator<<(FArchive& Ar, FComponentActiveInterval& Interval)
@@ -142,38 +154,66 @@ struct FComponentActiveInterval
 	}
 };
 
-/** @brief Array of Local-space transforms for all bones in a skeletal mesh component
+/** @brief Track table entry: one recorded scene component of an actor, indexed by FComponentRecord::ComponentId
+ *
+ *  Frames store component and bone transforms as dense blocks addressed by component ID,
+ *  so a component is resolved once per recording instead of once per frame.
  */
-USTRUCT(BlueprintType)
-struct FBoneComponentSpace
+USTRUCT()
+struct FRecordComponentTrack
 {
 	GENERATED_BODY()
 
-	/** Array of transforms for each bone in local component space */
-	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BloodStain")
-	TArray<FTransform> BoneTransforms;
+	/** Number of bones recorded per frame, 0 if the component is not a skeletal mesh */
+	UPROPERTY()
+	int32 NumBones = 0;
+
+	/** Mesh bone index of each recorded bone, empty if every bone of the mesh is recorded in order */
+	UPROPERTY()
+	TArray<int32> BoneIndices;
+
+	/** Offset of this track's first bone in FRecordFrame::BoneTransforms */
+	UPROPERTY()
+	int32 BoneOffset = 0;
+
+	/** Set when cooking if the component transform never changes, the file then stores it once */
+	UPROPERTY()
+	bool bStaticTransform = false;
+
+	/** One bit per bone, set when cooking if the bone transform never changes, the file then stores it once */
+	TBitArray<> StaticBones;
 
-	FBoneComponentSpace()
+	bool HasBones() const
 	{
-		
+		return NumBones > 0;
+	}
+
+	bool IsStaticBone(int32 BoneIndex) const
+	{
+		return StaticBones.IsValidIndex(BoneIndex) && StaticBones[BoneIndex];
 	}
 
-	explicit FBoneComponentSpace(const TArray<FTransform>& InBoneTransforms)
-		: BoneTransforms(InBoneTransforms)
+	/** @return Mesh bone index of the recorded bone */
+	int32 GetMeshBoneIndex(int32 BoneIndex) const
 	{
+		return BoneIndices.IsEmpty() ? BoneIndex : BoneIndices[BoneIndex];
 	}
 
-	friend FArchive& operator<<(FArchive& Ar, FBoneComponentSpace& BoneComponentSpace)
+	friend FArchive& operator<<(FArchive& Ar, FRecordComponentTrack& Track)
 	{
-		Ar << BoneComponentSpace.BoneTransforms;
+		Ar << Track.NumBones;
+		Ar << Track.BoneIndices;
+		Ar << Track.BoneOffset;
+		Ar << Track.bStaticTransform;
+		Ar << Track.StaticBones;
 		return Ar;
 	}
 };
 
-/** @brief Data recorded for a single frame, including transforms and component events
+/** @brief Data recorded for a single frame
  *
- * Contains all transforms for components and skeletal meshes attached in a single actor
- * as well as added/removed components.
+ * Contains the transforms of all components and skeletal mesh bones of a single actor,
+ * laid out by the actor's track table (FRecordActorSaveData::ComponentTracks).
  */
 USTRUCT(BlueprintType)
 struct FRecordFrame
@@ -184,13 +224,16 @@ struct FRecordFrame
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BloodStain")
 	float TimeStamp;
 
-	/** Map of components' name to their transforms at this frame */
+	/** Relative transforms of the components, indexed by component ID */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BloodStain")
-	TMap<FString, FTransform> RelativeTransforms;
+	TArray<FTransform> ComponentTransforms;
 
-	/** Map of skeletal mesh components' names to their bone transforms */
+	/** Local bone transforms of all skeletal mesh tracks, packed by FRecordComponentTrack::BoneOffset */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BloodStain")
-	TMap<FString, FBoneComponentSpace> SkeletalMeshBoneTransforms;
+	TArray<FTransform> BoneTransforms;
+
+	/** One bit per component ID, set if the component was recorded in this frame */
+	TBitArray<> RecordedTracks;
 	
 	/** Original frame index from the recorded data */
 	UPROPERTY()
@@ -201,12 +244,18 @@ struct FRecordFrame
 		,FrameIndex(0)
 	{
 	}
+
+	bool HasTrack(int32 TrackIndex) const
+	{
+		return RecordedTracks.IsValidIndex(TrackIndex) && RecordedTracks[TrackIndex];
+	}
 	
 	friend FArchive& operator<<(FArchive& Ar, FRecordFrame& Frame)
 	{
 		Ar << Frame.TimeStamp;
-		Ar << Frame.RelativeTransforms;
-		Ar << Frame.SkeletalMeshBoneTransforms;
+		Ar << Frame.ComponentTransforms;
+		Ar << Frame.BoneTransforms;
+		Ar << Frame.RecordedTracks;
 		Ar << Frame.FrameIndex;
 		return Ar;
 	}
@@ -270,14 +319,18 @@ struct FRecordActorSaveData
 {
 	GENERATED_BODY()
 
-	/** Name of the primary (root) component for this actor */
+	/** Component ID of the primary (root) component for this actor */
 	UPROPERTY()
-	FName PrimaryComponentName;
+	int32 PrimaryComponentId = INDEX_NONE;
 
 	/** Lifecycle intervals for each component */
 	UPROPERTY()
 	TArray<FComponentActiveInterval> ComponentIntervals;
 
+	/** Track table indexed by component ID, frames address their transform blocks through it */
+	UPROPERTY()
+	TArray<FRecordComponentTrack> ComponentTracks;
+
 	/** Combined min/max location for all components on this actor */
 	UPROPERTY()
 	FLocRange ComponentRanges;
@@ -286,13 +339,13 @@ struct FRecordActorSaveData
 	UPROPERTY()
 	FScaleRange ComponentScaleRanges; 
 
-	/** Per-skeletal-mesh-component min/max location ranges for all its bones */
+	/** Per-track min/max location ranges for all bones of a skeletal mesh track (indexed by track) */
 	UPROPERTY()
-	TMap<FString, FLocRange> BoneRanges;
+	TArray<FLocRange> BoneRanges;
 
-	/** Per-skeletal-mesh-component min/max scale ranges for all its bones */
+	/** Per-track min/max scale ranges for all bones of a skeletal mesh track (indexed by track) */
 	UPROPERTY()
-	TMap<FString, FScaleRange> BoneScaleRanges;
+	TArray<FScaleRange> BoneScaleRanges;
 
 	/** All recorded frames containing component transforms, bone transforms, and events */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "BloodStain")
@@ -302,11 +355,23 @@ struct FRecordActorSaveData
 	{
 		return RecordedFrames.Num() > 0 ? true : false;
 	}
+
+	/** @return Number of bone transforms in a frame covering every track */
+	int32 GetNumTrackBones() const
+	{
+		int32 NumTrackBones = 0;
+		for (const FRecordComponentTrack& Track : ComponentTracks)
+		{
+			NumTrackBones = FMath::Max(NumTrackBones, Track.BoneOffset + Track.NumBones);
+		}
+		return NumTrackBones;
+	}
 	
 	friend FArchive& operator<<(FArchive& Ar, FRecordActorSaveData& Data)
 	{
-		Ar << Data.PrimaryComponentName;
+		Ar << Data.PrimaryComponentId;
 		Ar << Data.ComponentIntervals;
+		Ar << Data.ComponentTracks;
 		Ar << Data.ComponentRanges;
 		Ar << Data.ComponentScaleRanges;
 		Ar << Data.BoneRanges;
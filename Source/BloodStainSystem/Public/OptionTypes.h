@@ -44,10 +44,30 @@ struct FBloodStainRecordOptions
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record")
 	float SamplingInterval = 0.1f;
 
+	/**
+	 * If true, sealed blocks of frames are encoded with the file options and written to a stream file in the background
+	 * while recording, so the recording is not limited by MaxRecordTime and only StreamBlockTime seconds of frames are
+	 * kept in memory. Saving copies the encoded blocks into the recording file.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record")
+	bool bStreamToDisk = false;
+
+	/** Seconds of frames per streamed block */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record", meta = (EditCondition = "bStreamToDisk", ClampMin = "0.1"))
+	float StreamBlockTime = 2.f;
+
 	/** If true, track mesh attachment changes in record component's tick */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Replay")
 	bool bTrackAttachmentChanges = true;
 
+	/**
+	 * If true, the attachment hierarchy is only rescanned after it has been marked dirty
+	 * (NotifyComponentAttached / NotifyComponentDetached / NotifyAttachmentsChanged, or a recorded parent gaining,
+	 * losing or unregistering a child), instead of on every sample.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Replay", meta = (EditCondition = "bTrackAttachmentChanges"))
+	bool bEventDrivenAttachmentTracking = true;
+
 	/** Save immediately if all recording actors in group is empty */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Replay")
 	bool bSaveImmediatelyIfGroupEmpty = false;
@@ -59,6 +79,59 @@ struct FBloodStainRecordOptions
 	/** If not none, components with this tag will not be recorded */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record")
 	FName ExcludedTag = NAME_None;
+
+	/**
+	 * If true, each recorder samples between SamplingInterval and MaxSamplingInterval depending on its significance
+	 * (see UBloodStainSubsystem::EvaluateRecordSignificance). Frames keep their actual timestamps.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record")
+	bool bUseSignificanceSampling = false;
+
+	/** Sampling interval of the least significant recorders, in seconds */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record", meta = (EditCondition = "bUseSignificanceSampling", ClampMin = "0"))
+	float MaxSamplingInterval = 0.5f;
+
+	/** Distance to the nearest player view below which a recorder is fully significant */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record", meta = (EditCondition = "bUseSignificanceSampling", ClampMin = "0"))
+	float SignificanceNearDistance = 1000.f;
+
+	/** Distance to the nearest player view beyond which a recorder has no significance */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record", meta = (EditCondition = "bUseSignificanceSampling", ClampMin = "0"))
+	float SignificanceFarDistance = 5000.f;
+
+	/**
+	 * If >= 0, skeletal meshes only record the bones required at this LOD, e.g. 2 for background actors.
+	 * Bones that are not recorded are replayed from the reference pose.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record", meta = (ClampMin = "-1"))
+	int32 BoneLODLevel = INDEX_NONE;
+
+	/** If not empty, skeletal meshes only record these bones (also filtered by BoneLODLevel) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record")
+	TArray<FName> RecordedBoneNames;
+
+	/**
+	 * If true, samples of a component (and its bones) that can be reconstructed by interpolating
+	 * the neighbouring keys within the tolerances below are dropped while recording.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record")
+	bool bUseKeyframeReduction = false;
+
+	/** Maximum location error (in cm) of a dropped component sample */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record", meta = (EditCondition = "bUseKeyframeReduction", ClampMin = "0"))
+	float ComponentLocationTolerance = 0.5f;
+
+	/** Maximum rotation error (in degrees) of a dropped component sample */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record", meta = (EditCondition = "bUseKeyframeReduction", ClampMin = "0"))
+	float ComponentRotationTolerance = 1.f;
+
+	/** Maximum location error (in cm) of a dropped bone sample, relative to its parent bone */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record", meta = (EditCondition = "bUseKeyframeReduction", ClampMin = "0"))
+	float BoneLocationTolerance = 0.1f;
+
+	/** Maximum rotation error (in degrees) of a dropped bone sample, relative to its parent bone */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Record", meta = (EditCondition = "bUseKeyframeReduction", ClampMin = "0"))
+	float BoneRotationTolerance = 1.f;
 	
 	friend FArchive& operator<<(FArchive& Ar, FBloodStainRecordOptions& Data)
 	{
@@ -69,10 +142,24 @@ struct FBloodStainRecordOptions
 		
 		Ar << Data.MaxRecordTime;
 		Ar << Data.SamplingInterval;
+		Ar << Data.bStreamToDisk;
+		Ar << Data.StreamBlockTime;
 		Ar << Data.bTrackAttachmentChanges;
+		Ar << Data.bEventDrivenAttachmentTracking;
 		Ar << Data.bSaveImmediatelyIfGroupEmpty;
 		Ar << Data.RequiredTag;
 		Ar << Data.ExcludedTag;
+		Ar << Data.bUseSignificanceSampling;
+		Ar << Data.MaxSamplingInterval;
+		Ar << Data.SignificanceNearDistance;
+		Ar << Data.SignificanceFarDistance;
+		Ar << Data.BoneLODLevel;
+		Ar << Data.RecordedBoneNames;
+		Ar << Data.bUseKeyframeReduction;
+		Ar << Data.ComponentLocationTolerance;
+		Ar << Data.ComponentRotationTolerance;
+		Ar << Data.BoneLocationTolerance;
+		Ar << Data.BoneRotationTolerance;
 		return Ar;
 	}
 };
@@ -16,25 +16,36 @@ class USkeletalMeshComponent;
 struct FIntervalTreeNode
 {
 	int32 Center;
-	TArray<FComponentActiveInterval*>    Intervals;
+	TArray<const FComponentActiveInterval*>    Intervals;
 	TUniquePtr<FIntervalTreeNode>  Left, Right;
 };
 
+/** Keys of one component track, built once in UPlayComponent::Initialize */
+struct FTrackKeyTimeline
+{
+	/** Frame indices holding a key of the track, ascending. Sparse if the recording used keyframe reduction */
+	TArray<int32> KeyFrames;
+
+	/** Set for keys that start a new active interval of the component, which must not be interpolated into */
+	TBitArray<> SegmentStarts;
+};
+
 USTRUCT()
 struct FSkelReplayInfo
 {
 	GENERATED_BODY()
 
 	FSkelReplayInfo() = default;
-	FSkelReplayInfo(USkeletalMeshComponent* InComp, const FString& InKey)
+	FSkelReplayInfo(USkeletalMeshComponent* InComp, int32 InComponentId)
 	  : Component(InComp)
-	  , ComponentName(InKey)
+	  , ComponentId(InComponentId)
 	{}
 
 	UPROPERTY()
 	TObjectPtr<USkeletalMeshComponent> Component = nullptr;
 	
-	FString	ComponentName;
+	/** Index into FRecordActorSaveData::ComponentTracks */
+	int32 ComponentId = INDEX_NONE;
 };
 
 /**
@@ -49,9 +60,12 @@ class BLOODSTAINSYSTEM_API UPlayComponent : public UActorComponent
 
 public:	
 	
-	void Initialize(FGuid PlaybackKey, const FRecordHeaderData& InRecordHeaderData, const FRecordActorSaveData& InReplayData, const FBloodStainPlaybackOptions& InPlaybackOptions);
+	void Initialize(FGuid PlaybackKey, const FRecordHeaderData& InRecordHeaderData, const TSharedRef<const FRecordActorSaveData>& InReplayData, const FBloodStainPlaybackOptions& InPlaybackOptions);
 	
 	void FinishReplay() const;
+
+	/** Releases the shared replay data so it is no longer pinned in the subsystem cache */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 	/** Calculate Playback State & Current Time.
 	 * @return false - if Playback is end */
@@ -69,25 +83,32 @@ public:
 public:
 	FGuid GetPlaybackKey() const;
 
-	FRecordActorSaveData GetReplayData() const { return ReplayData; }
+	/** Replay data shared with the subsystem cache and every other ghost of the same recording. Valid after Initialize */
+	const FRecordActorSaveData& GetReplayData() const { return *ReplayData; }
 
 	void SetPlaybackStartTime(const float StartTime) { PlaybackStartTime = StartTime; }
 	
 protected:
-	/** Apply Interpolation to Component between Two Frames */
-	void ApplyComponentTransforms(const FRecordFrame& Prev, const FRecordFrame& Next, float Alpha) const;
+	/** Apply Interpolation to Component between the Two Keys surrounding the current frame */
+	void ApplyComponentTransforms(float ElapsedTime) const;
 	
-	/** Apply Interpolation to Skeletal Bone between Two Frames */
-	void ApplySkeletalBoneTransforms(const FRecordFrame& Prev, const FRecordFrame& Next, float Alpha) const;
+	/** Apply Interpolation to Skeletal Bone between the Two Keys surrounding the current frame */
+	void ApplySkeletalBoneTransforms(float ElapsedTime) const;
+
+	/**
+	 * Finds the keys of a track around CurrentFrame.
+	 * @return false if the track has no key. OutPrevFrame == OutNextFrame if the transform is held
+	 */
+	bool FindTrackKeys(int32 ComponentId, float ElapsedTime, int32& OutPrevFrame, int32& OutNextFrame, float& OutAlpha) const;
 
 private:
 	/** Create & Attach, Register Component From FComponentRecord Data*/
-	USceneComponent* CreateComponentFromRecord(const FComponentRecord& Record, const TMap<FString, TObjectPtr<UObject>>& AssetCache) const;
+	USceneComponent* CreateComponentFromRecord(const FComponentRecord& Record, const TMap<FString, TObjectPtr<UObject>>& AssetCache, const TMap<FString, int32>& ComponentIdsByName) const;
 
 	void SeekFrame(int32 FrameIndex);
 	
-	static TUniquePtr<FIntervalTreeNode> BuildIntervalTree(const TArray<FComponentActiveInterval*>& InComponentIntervals);
-	static void QueryIntervalTree(FIntervalTreeNode* Node, int32 FrameIndex, TArray<FComponentActiveInterval*>& OutComponentIntervals);
+	static TUniquePtr<FIntervalTreeNode> BuildIntervalTree(const TArray<const FComponentActiveInterval*>& InComponentIntervals);
+	static void QueryIntervalTree(FIntervalTreeNode* Node, int32 FrameIndex, TArray<const FComponentActiveInterval*>& OutComponentIntervals);
 
 public:
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "BloodStain|Playback")
@@ -100,11 +121,18 @@ public:
 	FGuid PlaybackKey;
 
 protected:
-	UPROPERTY()
-	FRecordActorSaveData ReplayData;
+	/** Immutable, shared with the subsystem cache and every other ghost of the same recording */
+	TSharedPtr<const FRecordActorSaveData> ReplayData;
 
+	/** Reconstructed components indexed by FComponentRecord::ComponentId */
 	UPROPERTY()
-	TMap<FString, TObjectPtr<USceneComponent>> ReconstructedComponents;
+	TArray<TObjectPtr<USceneComponent>> ReconstructedComponents;
+
+	/** Scratch visibility per component ID, rebuilt by SeekFrame */
+	TBitArray<> VisibleComponents;
+
+	/** Indexed by component ID */
+	TArray<FTrackKeyTimeline> TrackKeyTimelines;
 
 	UPROPERTY()
 	TObjectPtr<AActor> ReplayActor;
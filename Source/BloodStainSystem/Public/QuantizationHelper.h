@@ -18,44 +18,108 @@
  */
 namespace BloodStainFileUtils_Internal
 {
+	/**
+	 * Per-file table of the strings of the component metadata (names, class, asset and material paths).
+	 * Each unique string is stored once, the metadata references it by index.
+	 */
+	struct FBloodStainStringTable
+	{
+		TArray<FString> Strings;
+
+		/** Only filled when saving */
+		TMap<FString, int32> Indices;
+
+		int32 Add(const FString& String);
+
+		/** Writes the index of String, or reads an index and resolves it (flags Ar as errored if out of range) */
+		void Serialize(FArchive& Ar, FString& String);
+
+		friend FArchive& operator<<(FArchive& Ar, FBloodStainStringTable& Table)
+		{
+			Ar << Table.Strings;
+			return Ar;
+		}
+	};
+
 	/**
 	 * Computes the min/max ranges for location and scale across all frames in the save data.
 	 * This is a prerequisite for 'Standard_Low' quantization.
 	 * @param SaveData The replay data to process. Ranges will be computed and stored within this struct.
 	 */
 	void ComputeRanges(FRecordSaveData& SaveData);
-	
+
+	/** Same as ComputeRanges, for a single actor */
+	void ComputeActorRanges(FRecordActorSaveData& ActorData);
+
 	/** 
 	 * Serializes a single FTransform to an archive using the specified quantization options.
 	 * @param Transform The source transform to serialize.
 	 * @param QuantOpts The quantization method and precision to use.
 	 * @param LocRange The location range, required for 'Standard_Low' quantization.
 	 * @param ScaleRange The scale range, required for 'Standard_Low' quantization.
+	 * @param RotationBits The rotation size, only used by 'SmallestThree' quantization.
 	 */
-	void SerializeQuantizedTransform(FArchive& Ar, const FTransform& Transform, const ETransformQuantizationMethod& QuantOpts, const FLocRange* LocRange = nullptr, const FScaleRange* ScaleRange = nullptr);
+	void SerializeQuantizedTransform(FArchive& Ar, const FTransform& Transform, const ETransformQuantizationMethod& QuantOpts, const FLocRange* LocRange = nullptr, const FScaleRange* ScaleRange = nullptr, int32 RotationBits = 38);
 
 	/**
 	 * Deserializes a quantized transform from an archive and reconstructs the FTransform.
 	 * @param QuantOpts The quantization options used during serialization.
 	 * @param LocRange The location range, only required for 'Standard_Low' option.
 	 * @param ScaleRange The scale range, only required for 'Standard_Low' option.
+	 * @param RotationBits The rotation size, only used by 'SmallestThree' option.
 	 * @return The reconstructed FTransform.
 	 */
-	FTransform DeserializeQuantizedTransform(FArchive& Ar, const ETransformQuantizationMethod& QuantOpts, const FLocRange* LocRange = nullptr, const FScaleRange* ScaleRange = nullptr);
+	FTransform DeserializeQuantizedTransform(FArchive& Ar, const ETransformQuantizationMethod& QuantOpts, const FLocRange* LocRange = nullptr, const FScaleRange* ScaleRange = nullptr, int32 RotationBits = 38);
+
+	/**
+	 * Serializes (or deserializes) the track table, quantization ranges and component intervals of an actor.
+	 * @param StringTable If set, the strings of the component intervals are stored in it and referenced by index.
+	 */
+	void SerializeActorMetadata(FArchive& Ar, FRecordActorSaveData& ActorData, FBloodStainStringTable* StringTable = nullptr);
 
 	/**
-	 * Serializes an entire FRecordSaveData object to a raw byte archive.
+	 * Serializes the frames and quantized transform blocks of an actor.
+	 * The quantization ranges must already be computed (see ComputeRanges).
+	 * @param Options Quantization and encoding (delta, keyframe interval) of the transform samples.
+	 */
+	BLOODSTAINSYSTEM_API void SerializeActorFrames(FArchive& RawAr, FRecordActorSaveData& ActorData, const FBloodStainFileOptions& Options);
+
+	/**
+	 * Reads back the output of SerializeActorFrames into ActorData.RecordedFrames.
+	 * The metadata of the actor must already be deserialized.
+	 * @return false if the data is corrupted.
+	 */
+	BLOODSTAINSYSTEM_API bool DeserializeActorFrames(FArchive& DataAr, FRecordActorSaveData& ActorData, const FBloodStainFileOptions& Options);
+
+	/**
+	 * Serializes an entire FRecordSaveData object to a raw byte archive, as a single blob (files before SectionTable).
 	 * Automatically computes ranges and quantizes all FTransform data according to the options.
 	 * @param SaveData The source replay data to serialize. Its range members will be modified.
-	 * @param QuantOpts The quantization options to apply to all transforms.
+	 * @param Options The quantization options to apply to all transforms, the delta encoding is ignored.
+	 */
+	void SerializeSaveData(FArchive& RawAr,FRecordSaveData& SaveData, const FBloodStainFileOptions& Options);
+
+	/**
+	 * Serializes a block of frames of a streamed actor with its own metadata, see EBloodStainFileSection::ActorFrameBlocks.
+	 * Computes the quantization ranges of the block, its static tracks must already be detected.
+	 * @param Block Track table and frames of the block, without component intervals
+	 * @param Options Quantization and encoding of the recording file, the codecs start over at every block
+	 */
+	void SerializeFrameBlock(FArchive& RawAr, FRecordActorSaveData& Block, const FBloodStainFileOptions& Options);
+
+	/**
+	 * Reads back the output of SerializeFrameBlock, the frames keep the track layout of the block.
+	 * @return false if the data is corrupted.
 	 */
-	void SerializeSaveData(FArchive& RawAr,FRecordSaveData& SaveData, ETransformQuantizationMethod& QuantOpts);
+	bool DeserializeFrameBlock(FArchive& DataAr, FRecordActorSaveData& OutBlock, const FBloodStainFileOptions& Options);
 
 	/**
 	 * Deserializes raw byte data from an archive into an FRecordSaveData object.
 	 * Reconstructs all quantized transforms back to their original FTransform format.
+	 * Payloads of older file versions are converted to the current in-memory layout.
 	 * @param OutData The FRecordSaveData object to populate with the deserialized data.
-	 * @param QuantOpts The quantization options used when the data was originally saved.
+	 * @param FileHeader The file header, providing the payload version and the quantization options used when saving.
+	 * @return false if the payload version is unsupported or the data is corrupted.
 	 */
-	void DeserializeSaveData(FArchive& DataAr, FRecordSaveData& OutData, const ETransformQuantizationMethod& QuantOpts);
+	bool DeserializeSaveData(FArchive& DataAr, FRecordSaveData& OutData, const FBloodStainFileHeader& FileHeader);
 }
@@ -130,4 +130,107 @@ struct FQuantizedTransform_Lowest
 		Ar << Q.Scale;
 		return Ar;
 	}
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Smallest-three quantized rotation with a configurable bit depth.
+ *
+ * The largest component of the unit quaternion is dropped (rebuilt from the other three) and its index stored in 2 bits.
+ * The three others lie within [-1/sqrt(2), 1/sqrt(2)] and are quantized on ComponentBits bits each, so unlike
+ * FQuatFixed48NoW / FQuatFixed32NoW precision does not degrade when W is close to 0.
+ */
+struct FQuatSmallestThree
+{
+	static constexpr int32 MinComponentBits = 9;
+	static constexpr int32 MaxComponentBits = 20;
+
+	/** [Index:2][A:ComponentBits][B:ComponentBits][C:ComponentBits] from the least significant bit */
+	uint64 Packed = 0;
+
+	FQuatSmallestThree() = default;
+
+	FQuatSmallestThree(const FQuat4f& Quat, int32 ComponentBits);
+
+	FQuat4f ToQuat(int32 ComponentBits) const;
+
+	/**
+	 * Bits per component for a total rotation size of RotationBits (FBloodStainFileOptions::RotationBits).
+	 * The size is rounded down to 2 + 3 * ComponentBits : 29, 38 and 47 are exact, 48 stores 47 bits.
+	 */
+	static int32 GetComponentBits(int32 RotationBits)
+	{
+		return FMath::Clamp((RotationBits - 2) / 3, MinComponentBits, MaxComponentBits);
+	}
+
+	/** Bytes used by EncodeBatch for NumQuats rotations */
+	static int32 GetBatchNumBytes(int32 NumQuats, int32 ComponentBits)
+	{
+		return static_cast<int32>((static_cast<int64>(NumQuats) * (2 + 3 * ComponentBits) + 7) / 8);
+	}
+
+	/** Appends the rotations to OutBytes, bit-packed back to back on 2 + 3 * ComponentBits bits each */
+	static void EncodeBatch(TConstArrayView<FQuat4f> Quats, int32 ComponentBits, TArray<uint8>& OutBytes);
+
+	/**
+	 * Reads back OutQuats.Num() rotations written by EncodeBatch.
+	 * @return false if Bytes is smaller than GetBatchNumBytes
+	 */
+	static bool DecodeBatch(TConstArrayView<uint8> Bytes, int32 ComponentBits, TArrayView<FQuat4f> OutQuats);
+
+	/** Only the bytes holding 2 + 3 * ComponentBits bits are serialized */
+	void Serialize(FArchive& Ar, int32 ComponentBits)
+	{
+		const int32 NumBytes = (2 + 3 * ComponentBits + 7) / 8;
+		if (Ar.IsLoading())
+		{
+			Packed = 0;
+		}
+		for (int32 ByteIndex = 0; ByteIndex < NumBytes; ++ByteIndex)
+		{
+			uint8 Byte = static_cast<uint8>(Packed >> (8 * ByteIndex));
+			Ar << Byte;
+			Packed |= static_cast<uint64>(Byte) << (8 * ByteIndex);
+		}
+	}
+};
+
+/**
+ * @brief Quantized transform with a smallest-three rotation.
+ *
+ * Uses:
+ *  - 0.01-unit quantization for Location (FVector_NetQuantize100),
+ *  - smallest-three rotation (FQuatSmallestThree) of FBloodStainFileOptions::RotationBits bits,
+ *  - 0.1-unit quantization for Scale (FVector_NetQuantize10).
+ */
+struct FQuantizedTransform_SmallestThree
+{
+	FVector_NetQuantize100 Location;
+
+	FQuatSmallestThree Rotation;
+
+	FVector_NetQuantize10 Scale;
+
+	FQuantizedTransform_SmallestThree() = default;
+
+	FQuantizedTransform_SmallestThree(const FTransform& T, int32 ComponentBits)
+		: Location(T.GetLocation())
+		, Rotation(FQuat4f(T.GetRotation()), ComponentBits)
+		, Scale(T.GetScale3D())
+	{}
+
+	FTransform ToTransform(int32 ComponentBits) const
+	{
+		FTransform T;
+		T.SetLocation(Location);
+		T.SetRotation(FQuat(Rotation.ToQuat(ComponentBits)));
+		T.SetScale3D(Scale);
+		return T;
+	}
+
+	void Serialize(FArchive& Ar, int32 ComponentBits)
+	{
+		Ar << Location;
+		Rotation.Serialize(Ar, ComponentBits);
+		Ar << Scale;
+	}
+};
@@ -9,10 +9,13 @@
 #include "GhostData.h"
 #include "OptionTypes.h"
 #include "Components/ActorComponent.h"
-#include "Containers/CircularQueue.h"
+#include "RecordFrameSlab.h"
+#include "BloodStainRecordDataUtils.h"
+#include "BloodStainStreamWriter.h"
 #include "RecordComponent.generated.h"
 
 class UMeshComponent;
+class USkeletalMeshComponent;
 
 
 /**
@@ -29,13 +32,64 @@ class BLOODSTAINSYSTEM_API URecordComponent : public UActorComponent
 public:	
 	URecordComponent();
 
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	void Initialize(const FBloodStainRecordOptions& InOptions, const float& InGroupStartTime);
 
-	// Cook Data from FrameQueue to GhostSaveData
-	FRecordActorSaveData CookQueuedFrames(const float& BaseTime);
+	/**
+	 * Moves the frame slab and track data out of the recorder without copying frames, to be cooked off the game thread.
+	 * The recorder must not sample anymore afterwards.
+	 */
+	FDetachedRecordData DetachRecordData();
+
+	/**
+	 * Copies the frames recorded from ClipStartTime and the track data, recording continues untouched.
+	 * @return Snapshot record without slab, to be cooked with BloodStainRecordDataUtils::CookDetachedRecord
+	 */
+	FDetachedRecordData SnapshotRecordData(float ClipStartTime) const;
+
+	/** Streams sealed blocks of frames to InStreamWriter instead of overwriting the oldest frames (RecordOptions.bStreamToDisk) */
+	void SetStreamWriter(const TSharedPtr<FBloodStainStreamWriter>& InStreamWriter, int32 InStreamActorIndex);
+
+	bool IsStreaming() const { return StreamWriter.IsValid(); }
+	int32 GetStreamActorIndex() const { return StreamActorIndex; }
+
+	/**
+	 * Writes the remaining frames to the stream and stops streaming.
+	 * @return Track table, primary component and raw component intervals, rebased onto the frames of the stream when it is saved
+	 */
+	FRecordActorSaveData FinishStream();
+
+	/**
+	 * Advances the sampling clock, called once per frame by UBloodStainRecordSampler.
+	 * @return true if a sample is due
+	 */
+	bool AdvanceSampleClock(float DeltaTime);
+
+	/** Offsets the sampling clock by a fraction of SamplingInterval, so recorders started together do not sample on the same frame */
+	void SetSamplePhase(float PhaseFraction);
+
+	/**
+	 * Sets the sampling interval used until the next sample, between RecordOptions.SamplingInterval (Significance = 1)
+	 * and RecordOptions.MaxSamplingInterval (Significance = 0).
+	 */
+	void SetSignificance(float Significance);
+
+	/** Overrides the evaluated significance of this recorder in [0, 1], a negative value restores the evaluation */
+	void SetSignificanceOverride(float InSignificance) { SignificanceOverride = InSignificance; }
+	float GetSignificanceOverride() const { return SignificanceOverride; }
+
+	/**
+	 * Game thread phase of a due sample : applies attachment changes and claims a frame slot.
+	 * CaptureSample must be called afterwards.
+	 */
+	void BeginSample();
+
+	/**
+	 * Reads the component and bone transforms into the slot claimed by BeginSample.
+	 * Only touches this recorder's own slab and scratch data, so recorders can be captured in parallel.
+	 */
+	void CaptureSample();
 	
 public:
 	/* Called when a new component attached to the owner */
@@ -44,6 +98,9 @@ public:
 	/* Called when a component detached from the owner */
 	void OnComponentDetached(USceneComponent* DetachedComponent);
 
+	/** Forces the attachment hierarchy to be rescanned on the next sample (RecordOptions.bEventDrivenAttachmentTracking) */
+	void MarkAttachmentsDirty() { bAttachmentsDirty = true; }
+
 	/** Recording group name */
 	UFUNCTION(BlueprintCallable, Category="BloodStain|Record")
 	FName GetRecordGroupName() const { return RecordOptions.RecordingGroupName; }
@@ -72,12 +129,21 @@ private:
 	 */
 	static void FillMaterialData(const UMeshComponent* InMeshComponent, FComponentRecord& OutRecord);
 	
+	/** Hands the filled slab over to the stream writer and continues on an empty (recycled) one */
+	void FlushStreamBlock();
+
 	/** Checks for newly attached or detached actors since the last frame and updates the recording state accordingly. */
 	void HandleAttachedActorChangesByBit();
 
 	/** Checks for newly attached or detached Scene components since the last frame and updates the recording state accordingly. */
 	void HandleSceneComponentChangesByBit();
 
+	/**
+	 * Cheap dirty check of the hierarchy seen by the last HandleSceneComponentChangesByBit :
+	 * @return true if a scanned component was unregistered or its number of attach children changed
+	 */
+	bool HasScannedHierarchyChanged() const;
+
 	/** Adds the given scene component to the list of components to be recorded. */
 	bool AddComponentToRecordList(USceneComponent* SceneComp);
 
@@ -85,6 +151,30 @@ private:
 	bool IsComponentSupported(const USceneComponent* SceneComp) const;
 
 	static FString CreateUniqueComponentName(const UActorComponent* Component);
+
+	/**
+	 * Keyframe reduction : drops the previous sample of the track if it and every sample dropped since the last key
+	 * can be reconstructed by interpolating between that key and the new sample.
+	 */
+	void ReduceTrackKeys(int32 ComponentId, int32 FrameIndex);
+
+	/** @return true if every sample of the track strictly between the two logical slab indices is within tolerance */
+	bool CanDropSamples(int32 ComponentId, int32 KeyIndex, int32 NewIndex) const;
+
+	/** Converts the component space pose of a physics-simulated skeletal mesh to the parent-local bones of the track in one pass */
+	static void CaptureRagdollBones(const USkeletalMeshComponent* SkeletalComp, const FRecordComponentTrack& Track, FTransform* OutBoneTransforms);
+
+	/**
+	 * Applies RecordOptions.BoneLODLevel / RecordedBoneNames to the skeletal mesh.
+	 * @param OutBoneIndices Mesh bone indices to record, left empty if every bone is recorded
+	 */
+	void BuildRecordedBoneIndices(const USkeletalMeshComponent* SkeletalComp, TArray<int32>& OutBoneIndices) const;
+
+	/**
+	 * Returns the per-recording ID of the component, interning it (and adding its track and bone block) on first use.
+	 * Only called when a component joins the recording, never while sampling.
+	 */
+	int32 InternComponentId(USceneComponent* SceneComp);
 	
 public:
 	/** Record Option */
@@ -97,30 +187,72 @@ protected:
 	
 	int32 CurrentFrameIndex;
 	float TimeSinceLastRecord;
+
+	/** Interval until the next sample, only differs from RecordOptions.SamplingInterval with significance sampling */
+	float CurrentSamplingInterval = 0.f;
+
+	/** Significance forced by gameplay code, negative if it is evaluated */
+	float SignificanceOverride = -1.f;
+
+	/** Slab slot claimed by BeginSample, INDEX_NONE when no sample is pending */
+	int32 PendingSampleSlot = INDEX_NONE;
 	
-	/** Records All frames up to MaxFrames */
-	TUniquePtr<TCircularQueue<FRecordFrame>> FrameQueuePtr;
+	/** Records All frames up to MaxFrames, samples overwrite the oldest frame in place */
+	TSharedPtr<FRecordFrameSlab> FrameSlabPtr;
+
+	/** Set when the recording is streamed to disk, the slab is then flushed as a block when full */
+	TSharedPtr<FBloodStainStreamWriter> StreamWriter;
+	int32 StreamActorIndex = INDEX_NONE;
 
 	/** Component currently owned */
 	UPROPERTY()
 	TArray<TObjectPtr<USceneComponent>> OwnedComponentsForRecord;
+
+	/** Component ID of each entry in OwnedComponentsForRecord (same order) */
+	TArray<int32> OwnedComponentIds;
 	
 	/** Component Intervals for each component, used to track when components were attached/detached */
 	UPROPERTY()
 	TArray<FComponentActiveInterval> ComponentActiveIntervals;
 
 	/**
-	 * Key is FComponentActiveInterval::FComponentRecord::ComponentName
+	 * Key is FComponentActiveInterval::FComponentRecord::ComponentId
 	 * O(log N) access when detaching
 	 */
-	TMap<FString, int32> IntervalIndexMap;
+	TMap<int32, int32> IntervalIndexMap;
+
+	/** Track table shared by all recorded frames, indexed by component ID */
+	TArray<FRecordComponentTrack> ComponentTracks;
+
+	/** Interned component IDs, value is the index into ComponentTracks */
+	TMap<TObjectPtr<USceneComponent>, int32> ComponentIdMap;
+
+	/** Total number of bone transforms per frame across all tracks */
+	int32 NumTrackBones = 0;
+
+	/** Keyframe reduction state of a track, in recorded frame indices */
+	struct FTrackReductionState
+	{
+		/** Last sample kept as a key */
+		int32 KeyFrame = INDEX_NONE;
+		
+		/** Latest sample, kept until the next sample decides whether it can be dropped */
+		int32 CandidateFrame = INDEX_NONE;
+	};
+
+	/** Indexed by component ID, only used if RecordOptions.bUseKeyframeReduction */
+	TArray<FTrackReductionState> TrackReductionStates;
+
+	/** Upper bound of consecutive dropped samples, bounds the cost of CanDropSamples */
+	static constexpr int32 MaxKeyframeGap = 10;
 
 	FInstancedStruct InstancedStruct;
 
 private:
-	FName PrimaryComponentName;
+	int32 PrimaryComponentId = INDEX_NONE;
 	
-	TMap<FString, TSharedPtr<FComponentRecord>> MetaDataCache;
+	/** Key is FComponentRecord::ComponentId */
+	TMap<int32, TSharedPtr<FComponentRecord>> MetaDataCache;
 	TMap<TObjectPtr<AActor>, int32 > AttachedActorIndexMap;
 	TArray<TObjectPtr<AActor>> AttachedIndexToActor;
 	TBitArray<> PrevAttachedBits;
@@ -130,6 +262,13 @@ private:
 	TArray<TObjectPtr<USceneComponent>> IndexToAttachedComponent;
 	TBitArray<> PrevComponentBits;
 	TBitArray<> CurComponentBits;
+
+	/** Set by attachment notifications, the hierarchy is rescanned on the next sample */
+	bool bAttachmentsDirty = true;
+
+	/** Every component of the hierarchy seen by the last scan, with its number of attach children at that time */
+	TArray<TWeakObjectPtr<USceneComponent>> ScannedComponents;
+	TArray<int32> ScannedChildCounts;
 	
 };
 
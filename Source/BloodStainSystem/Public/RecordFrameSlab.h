@@ -0,0 +1,76 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FRecordFrame;
+
+/**
+ * Fixed-capacity ring of recorded frames used by URecordComponent.
+ *
+ * Every frame slot owns a fixed stride of the component / bone transform pools, so a new sample overwrites the
+ * oldest slot in place. Memory is only (re)allocated by Initialize and when an attached component widens the stride.
+ * Frames are addressed by logical index, 0 being the oldest frame still in the ring.
+ */
+class BLOODSTAINSYSTEM_API FRecordFrameSlab
+{
+public:
+	/** Allocates the ring for InCapacity frames of NumTracks component transforms and NumTrackBones bone transforms */
+	void Initialize(int32 InCapacity, int32 NumTracks, int32 NumTrackBones);
+
+	/** Widens the per-frame stride, repacking the frames already recorded. New tracks are left unrecorded */
+	void Reserve(int32 NumTracks, int32 NumTrackBones);
+
+	/**
+	 * Claims the slot for a new frame, overwriting the oldest frame when the ring is full.
+	 * @return Slot to pass to the Get/Mark accessors below
+	 */
+	int32 AddFrame(float TimeStamp, int32 FrameIndex);
+
+	/** Discards the oldest frame */
+	void PopOldest();
+
+	/** Discards every frame, keeping the allocation */
+	void Reset();
+
+	FTransform* GetComponentTransforms(int32 Slot) { return ComponentPool.GetData() + Slot * TrackStride; }
+	FTransform* GetBoneTransforms(int32 Slot) { return BonePool.GetData() + Slot * BoneStride; }
+	const FTransform* GetComponentTransforms(int32 Slot) const { return ComponentPool.GetData() + Slot * TrackStride; }
+	const FTransform* GetBoneTransforms(int32 Slot) const { return BonePool.GetData() + Slot * BoneStride; }
+	void MarkRecorded(int32 Slot, int32 TrackIndex) { RecordedBits[Slot * TrackStride + TrackIndex] = true; }
+
+	/** Drops the key of a track, its transforms stay in the slot until the slot is reused */
+	void ClearRecorded(int32 Slot, int32 TrackIndex) { RecordedBits[Slot * TrackStride + TrackIndex] = false; }
+
+	/** @return Logical index of the frame recorded with FrameIndex, INDEX_NONE if it has left the ring */
+	int32 FindIndex(int32 FrameIndex) const;
+
+	/** Copies the frame at the logical index into a standalone FRecordFrame (allocates, used when cooking) */
+	void CopyFrame(int32 Index, FRecordFrame& OutFrame) const;
+
+	int32 Num() const { return NumFrames; }
+	bool IsEmpty() const { return NumFrames == 0; }
+	int32 GetCapacity() const { return Capacity; }
+	float GetTimeStamp(int32 Index) const { return TimeStamps[ToSlot(Index)]; }
+	int32 GetFrameIndex(int32 Index) const { return FrameIndices[ToSlot(Index)]; }
+	int32 ToSlot(int32 Index) const { return (Head + Index) % Capacity; }
+
+private:
+	TArray<FTransform> ComponentPool;
+	TArray<FTransform> BonePool;
+	TBitArray<> RecordedBits;
+	TArray<float> TimeStamps;
+	TArray<int32> FrameIndices;
+
+	int32 Capacity = 0;
+	int32 TrackStride = 0;
+	int32 BoneStride = 0;
+
+	/** Slot of the oldest frame */
+	int32 Head = 0;
+	int32 NumFrames = 0;
+};
@@ -35,8 +35,9 @@ public:
 	/** Returns the PlayComponent SubObject. */
 	UPlayComponent* GetPlayComponent() const;
 
+	/** @param InActorData Shared, immutable actor data. Usually aliases an entry of a shared FRecordSaveData */
 	void InitializeReplayLocal(const FGuid& InPlaybackKey, const FRecordHeaderData& InHeader,
-	                           const FRecordActorSaveData& InActorData,
+	                           const TSharedRef<const FRecordActorSaveData>& InActorData,
 	                           const FBloodStainPlaybackOptions& InOptions);
 
 	/** [SERVER-ONLY] : Initializes the replay by sending a compressed payload to all clients.
@@ -85,7 +86,7 @@ protected:
 
 	/** [CLIENT-ONLY] Decompresses the final payload and spawns the visual actors for the replay. */
 	void Client_FinalizeAndSpawnVisuals();
-	void Client_FinalizeAndSpawnVisuals(const FRecordSaveData& AllReplayData);
+	void Client_FinalizeAndSpawnVisuals(const TSharedRef<const FRecordSaveData>& AllReplayData);
 
 	bool bIsOrchestrator = false;
 
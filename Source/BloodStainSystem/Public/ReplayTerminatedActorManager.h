@@ -10,7 +10,8 @@
 #include "OptionTypes.h"
 #include "UObject/Object.h"
 #include "Tickable.h"
-#include "Containers/CircularQueue.h"
+#include "RecordFrameSlab.h"
+#include "BloodStainRecordDataUtils.h"
 #include "ReplayTerminatedActorManager.generated.h"
 
 struct FRecordActorSaveData;
@@ -27,11 +28,17 @@ class BLOODSTAINSYSTEM_API UReplayTerminatedActorManager : public UObject, publi
 
 public:
 	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return !ExpiryHeap.IsEmpty(); }
 	virtual TStatId GetStatId() const override;
 
-	/** Cook Data from FrameQueue to GhostSaveData */
-	TArray<FRecordActorSaveData> CookQueuedFrames(const FName& GroupName, const float& BaseTime, TArray<FName>& OutActorNameArray, TArray<FInstancedStruct>&
-	                                              OutInstancedStructArray);
+	/** Moves the frame slabs of the group's terminated recorders into OutRecords and forgets the group */
+	void DetachRecordGroup(const FName& GroupName, TArray<FDetachedRecordData>& OutRecords);
+
+	/**
+	 * Copies the frames recorded from ClipStartTime by the group's terminated recorders, the buffers are kept.
+	 * @param ActorNames Actors to copy, every actor of the group if null
+	 */
+	void SnapshotRecordGroup(const FName& GroupName, float ClipStartTime, const TSet<FName>* ActorNames, TArray<FDetachedRecordData>& OutRecords) const;
 
 	/** if the group already exists, RecordComponent join the group */
 	void AddToRecordGroup(const FName& GroupName, URecordComponent* RecordComponent);
@@ -41,8 +48,11 @@ public:
 	bool ContainsGroup(const FName& GroupName) const;
 
 private:
-	/** Remove old frameData from managing record groups */
-	void CollectRecordGroups(float DeltaTime);
+	/** Remove old frameData from managing record groups, only visits the buffers whose oldest frame has expired */
+	void CollectRecordGroups();
+
+	/** Queues the next expiry of a buffer, i.e. the world time its oldest frame leaves the MaxRecordTime window */
+	void ScheduleExpiry(const FName& GroupName, int32 RecordId, float StartTime, const FRecordFrameSlab& FrameSlab, float MaxRecordTime);
 
 public:
 	FOnRecordGroupRemove OnRecordGroupRemoveByCollecting;
@@ -51,21 +61,35 @@ private:
 	/** Data that each Record Component is saving */
 	struct FRecordComponentData
 	{
-		FName ActorName = NAME_None;
-		
-		float TimeSinceLastRecord = 0.0f;
 		float StartTime = 0.f;
 
-		TSharedPtr<TCircularQueue<FRecordFrame>> FrameQueuePtr = nullptr;
-		FRecordActorSaveData GhostSaveData = FRecordActorSaveData();
-		TArray<FComponentActiveInterval> ComponentIntervals;
-		FInstancedStruct InstancedStruct = FInstancedStruct();
+		FDetachedRecordData Record;
 	};
 	
 	struct FRecordGroupData
 	{
 		FBloodStainRecordOptions RecordOptions;
-		TArray<FRecordComponentData> RecordComponentData;
+
+		/** Key is the record ID referenced by FExpiryEntry */
+		TMap<int32, FRecordComponentData> RecordComponentData;
 	};
 	TMap<FName, FRecordGroupData> RecordGroups;
+
+	/** Expiry of the oldest frame of a terminated buffer */
+	struct FExpiryEntry
+	{
+		float ExpiryTime = 0.f;
+		FName GroupName = NAME_None;
+		int32 RecordId = INDEX_NONE;
+
+		bool operator<(const FExpiryEntry& Other) const { return ExpiryTime < Other.ExpiryTime; }
+	};
+
+	/**
+	 * Min-heap of buffer expiries, one entry per buffer.
+	 * Entries of buffers that were saved or cleared in the meantime are discarded when they reach the top.
+	 */
+	TArray<FExpiryEntry> ExpiryHeap;
+
+	int32 NextRecordId = 0;
 };
@@ -0,0 +1,23 @@
+/*
+ * Copyright 2025 TenToTen, All Rights Reserved.
+ */
+
+using UnrealBuildTool;
+
+public class BloodStainSystemTests : ModuleRules
+{
+	public BloodStainSystemTests(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+		
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Engine",
+				"BloodStainSystem"
+			}
+		);
+	}
+}
@@ -0,0 +1,7 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, BloodStainSystemTests)
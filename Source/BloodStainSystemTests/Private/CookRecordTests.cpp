@@ -0,0 +1,73 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+#include "BloodStainFileOptions.h"
+#include "BloodStainRecordDataUtils.h"
+#include "GhostData.h"
+#include "Misc/AutomationTest.h"
+#include "QuantizationHelper.h"
+#include "Serialization/BufferArchive.h"
+#include "Serialization/MemoryReader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBloodStainReducedTrackClipTest, "BloodStain.Cook.ReducedTrackMovingOutsideClip",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/**
+ * A track moving at constant speed keeps no key inside the clip window but the last one, the previous key was
+ * recorded before the window. Cooking must restore the first sample as a key and must not flag the track static.
+ */
+bool FBloodStainReducedTrackClipTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumFrames = 10;
+	constexpr int32 FirstFrameIndex = 100;
+
+	FRecordActorSaveData SaveData;
+	SaveData.PrimaryComponentId = 0;
+	SaveData.ComponentTracks.AddDefaulted();
+	SaveData.BoneRanges.AddDefaulted();
+	SaveData.BoneScaleRanges.AddDefaulted();
+
+	// The dropped samples keep their transform, only their key bit is cleared by the reduction
+	TArray<FRecordFrame> RawFrames;
+	for (int32 Index = 0; Index < NumFrames; ++Index)
+	{
+		FRecordFrame& Frame = RawFrames.AddDefaulted_GetRef();
+		Frame.FrameIndex = FirstFrameIndex + Index;
+		Frame.TimeStamp = Index * 0.1f;
+		Frame.ComponentTransforms.Add(FTransform(FVector(Index * 10.0, 0.0, 0.0)));
+		Frame.RecordedTracks.Add(Index == NumFrames - 1);
+	}
+
+	FComponentRecord Meta;
+	Meta.ComponentId = 0;
+	Meta.ComponentName = TEXT("Root");
+	TArray<FComponentActiveInterval> Intervals;
+	Intervals.Emplace(Meta, 0, INT32_MAX);
+
+	if (!TestTrue(TEXT("Frames are cooked"), BloodStainRecordDataUtils::CookFrames(MoveTemp(RawFrames), SaveData, Intervals)))
+	{
+		return false;
+	}
+	TestTrue(TEXT("First sample of the window is restored as a key"), SaveData.RecordedFrames[0].HasTrack(0));
+	TestFalse(TEXT("Moving track is not static"), SaveData.ComponentTracks[0].bStaticTransform);
+
+	FBloodStainFileOptions Options;
+	Options.QuantizationOption = ETransformQuantizationMethod::None;
+	FBufferArchive Writer;
+	BloodStainFileUtils_Internal::SerializeActorFrames(Writer, SaveData, Options);
+
+	FMemoryReader Reader(Writer, true);
+	SaveData.RecordedFrames.Reset();
+	if (!TestTrue(TEXT("Frames are decoded"), BloodStainFileUtils_Internal::DeserializeActorFrames(Reader, SaveData, Options)))
+	{
+		return false;
+	}
+	TestEqual(TEXT("First key keeps its location"), SaveData.RecordedFrames[0].ComponentTransforms[0].GetLocation().X, 0.0);
+	TestEqual(TEXT("Last key keeps its location"), SaveData.RecordedFrames.Last().ComponentTransforms[0].GetLocation().X, (NumFrames - 1) * 10.0);
+	return true;
+}
+
+#endif
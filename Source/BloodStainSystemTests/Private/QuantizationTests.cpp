@@ -0,0 +1,131 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+#include "BloodStainFileOptions.h"
+#include "GhostData.h"
+#include "Misc/AutomationTest.h"
+#include "QuantizationHelper.h"
+#include "Serialization/BufferArchive.h"
+#include "Serialization/MemoryReader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace BloodStainSystemTests_Internal
+{
+	/** Rotations crossing W = 0 and changing their largest component, plus half turns about arbitrary axes (W = 0) */
+	TArray<FQuat> MakeRotationsAroundWZero()
+	{
+		TArray<FQuat> Rotations;
+		const FVector Axes[] = { FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector, FVector(1.0, 2.0, -3.0).GetSafeNormal() };
+		for (const FVector& Axis : Axes)
+		{
+			for (double Degrees = 150.0; Degrees <= 210.0; Degrees += 2.5)
+			{
+				Rotations.Add(FQuat(Axis, FMath::DegreesToRadians(Degrees)));
+			}
+			Rotations.Add(FQuat(Axis, UE_DOUBLE_PI));
+		}
+
+		// A full turn about Z moves the largest component from W to Z and back
+		for (double Degrees = 0.0; Degrees < 360.0; Degrees += 10.0)
+		{
+			Rotations.Add(FQuat(FVector::ZAxisVector, FMath::DegreesToRadians(Degrees)));
+		}
+		return Rotations;
+	}
+
+	/** Round-trips the rotations as the samples of a single component track through Serialize/DeserializeActorFrames */
+	bool RoundTripRotations(const TArray<FQuat>& Rotations, const FBloodStainFileOptions& Options, TArray<FQuat>& OutRotations)
+	{
+		FRecordActorSaveData ActorData;
+		ActorData.ComponentTracks.AddDefaulted();
+		ActorData.BoneRanges.AddDefaulted();
+		ActorData.BoneScaleRanges.AddDefaulted();
+		for (int32 FrameIndex = 0; FrameIndex < Rotations.Num(); ++FrameIndex)
+		{
+			FRecordFrame& Frame = ActorData.RecordedFrames.AddDefaulted_GetRef();
+			Frame.FrameIndex = FrameIndex;
+			Frame.TimeStamp = FrameIndex * 0.1f;
+			Frame.ComponentTransforms.Add(FTransform(Rotations[FrameIndex]));
+			Frame.RecordedTracks.Add(true);
+		}
+
+		FBufferArchive Writer;
+		BloodStainFileUtils_Internal::SerializeActorFrames(Writer, ActorData, Options);
+
+		FMemoryReader Reader(Writer, true);
+		ActorData.RecordedFrames.Reset();
+		if (!BloodStainFileUtils_Internal::DeserializeActorFrames(Reader, ActorData, Options))
+		{
+			return false;
+		}
+
+		OutRotations.Reset(ActorData.RecordedFrames.Num());
+		for (const FRecordFrame& Frame : ActorData.RecordedFrames)
+		{
+			OutRotations.Add(Frame.ComponentTransforms[0].GetRotation());
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBloodStainRotationRoundTripTest, "BloodStain.Quantization.RotationRoundTripNearWZero",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/**
+ * Rotations close to W = 0 must survive every encoding with the precision of the quantization method,
+ * SmallestThree at each of its usual bit depths.
+ */
+bool FBloodStainRotationRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace BloodStainSystemTests_Internal;
+
+	const TArray<FQuat> Rotations = MakeRotationsAroundWZero();
+	const ETransformEncodingMethod Encodings[] = { ETransformEncodingMethod::None, ETransformEncodingMethod::Delta, ETransformEncodingMethod::LinearPrediction };
+
+	struct FCase
+	{
+		ETransformQuantizationMethod Method;
+		int32 RotationBits;
+		double Tolerance;
+	};
+	// Without delta encoding, FQuatFixed48NoW rebuilds W from the three others, about 0.01 rad off when W is close to 0
+	const FCase Cases[] = {
+		{ ETransformQuantizationMethod::Standard_High, 38, 0.02 },
+		{ ETransformQuantizationMethod::SmallestThree, 29, 4.0 * UE_SQRT_2 / ((1 << FQuatSmallestThree::GetComponentBits(29)) - 1) },
+		{ ETransformQuantizationMethod::SmallestThree, 38, 4.0 * UE_SQRT_2 / ((1 << FQuatSmallestThree::GetComponentBits(38)) - 1) },
+		{ ETransformQuantizationMethod::SmallestThree, 47, 4.0 * UE_SQRT_2 / ((1 << FQuatSmallestThree::GetComponentBits(47)) - 1) },
+	};
+
+	for (const FCase& Case : Cases)
+	{
+		for (const ETransformEncodingMethod Encoding : Encodings)
+		{
+			FBloodStainFileOptions Options;
+			Options.QuantizationOption = Case.Method;
+			Options.RotationBits = Case.RotationBits;
+			Options.EncodingOption = Encoding;
+			Options.KeyframeInterval = 8;
+
+			const FString Context = FString::Printf(TEXT("%s, %d bits, %s"), *UEnum::GetValueAsString(Case.Method), Case.RotationBits, *UEnum::GetValueAsString(Encoding));
+
+			TArray<FQuat> Decoded;
+			if (!TestTrue(FString::Printf(TEXT("Frames are decoded (%s)"), *Context), RoundTripRotations(Rotations, Options, Decoded))
+				|| !TestEqual(FString::Printf(TEXT("Frame count (%s)"), *Context), Decoded.Num(), Rotations.Num()))
+			{
+				continue;
+			}
+
+			double MaxError = 0.0;
+			for (int32 Index = 0; Index < Rotations.Num(); ++Index)
+			{
+				MaxError = FMath::Max(MaxError, Rotations[Index].AngularDistance(Decoded[Index]));
+			}
+			TestTrue(FString::Printf(TEXT("Max angular error %f within %f (%s)"), MaxError, Case.Tolerance, *Context), MaxError <= Case.Tolerance);
+		}
+	}
+	return true;
+}
+
+#endif
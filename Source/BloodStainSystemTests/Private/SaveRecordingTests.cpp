@@ -0,0 +1,298 @@
+/*
+* Copyright 2025 TenToTen, All Rights Reserved.
+*/
+
+#include "BloodStainFileUtils.h"
+#include "BloodStainRecordDataUtils.h"
+#include "BloodStainStreamWriter.h"
+#include "BloodStainSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GhostData.h"
+#include "HAL/Event.h"
+#include "HAL/MallocBase.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "RecordComponent.h"
+#include "RecordFrameSlab.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace BloodStainSystemTests_Internal
+{
+	/**
+	 * Forwards every call to the allocator it replaces and counts the allocations of at least MinSize bytes
+	 * made by the thread that installed it. GMalloc is restored when the scope ends.
+	 */
+	class FScopedLargeAllocationCounter final : public FMalloc
+	{
+	public:
+		explicit FScopedLargeAllocationCounter(SIZE_T InMinSize)
+			: InnerMalloc(GMalloc)
+			, MinSize(InMinSize)
+			, OwnerThreadId(FPlatformTLS::GetCurrentThreadId())
+		{
+			GMalloc = this;
+		}
+
+		virtual ~FScopedLargeAllocationCounter() override
+		{
+			GMalloc = InnerMalloc;
+		}
+
+		int32 GetCount() const { return Count; }
+
+		virtual void* Malloc(SIZE_T Size, uint32 Alignment) override
+		{
+			Track(Size);
+			return InnerMalloc->Malloc(Size, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Size, uint32 Alignment) override
+		{
+			Track(Size);
+			return InnerMalloc->TryMalloc(Size, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Size, uint32 Alignment) override
+		{
+			Track(Size);
+			return InnerMalloc->Realloc(Original, Size, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Size, uint32 Alignment) override
+		{
+			Track(Size);
+			return InnerMalloc->TryRealloc(Original, Size, Alignment);
+		}
+
+		virtual void Free(void* Original) override { InnerMalloc->Free(Original); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return InnerMalloc->GetAllocationSize(Original, SizeOut); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return InnerMalloc->QuantizeSize(Count, Alignment); }
+		virtual void Trim(bool bTrimThreadCaches) override { InnerMalloc->Trim(bTrimThreadCaches); }
+		virtual bool IsInternallyThreadSafe() const override { return InnerMalloc->IsInternallyThreadSafe(); }
+		virtual const TCHAR* GetDescriptiveName() override { return InnerMalloc->GetDescriptiveName(); }
+
+	private:
+		void Track(SIZE_T Size)
+		{
+			if (Size >= MinSize && FPlatformTLS::GetCurrentThreadId() == OwnerThreadId)
+			{
+				++Count;
+			}
+		}
+
+		FMalloc* InnerMalloc;
+		SIZE_T MinSize;
+		uint32 OwnerThreadId;
+		int32 Count = 0;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBloodStainMoveOnlySaveTest, "BloodStain.Save.MoveOnlySavePath",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/**
+ * Records a static actor, then detaches, cooks, assembles and saves it the way CookAndSaveRecording does.
+ * Only cooking may allocate a buffer the size of the frame array, the hand-off and SaveToFile(&&) must move it.
+ */
+bool FBloodStainMoveOnlySaveTest::RunTest(const FString& Parameters)
+{
+	using namespace BloodStainSystemTests_Internal;
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	AActor* Actor = World->SpawnActor<AActor>();
+	USceneComponent* Root = NewObject<USceneComponent>(Actor, TEXT("Root"));
+	Actor->SetRootComponent(Root);
+	Root->RegisterComponent();
+	URecordComponent* Recorder = NewObject<URecordComponent>(Actor, TEXT("Recorder"));
+	Recorder->RegisterComponent();
+
+	FBloodStainRecordOptions Options;
+	Options.SamplingInterval = 0.05f;
+	Options.MaxRecordTime = 100.f;
+	Recorder->Initialize(Options, World->GetTimeSeconds());
+
+	const int32 NumFrames = FMath::CeilToInt(Options.MaxRecordTime / Options.SamplingInterval);
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		World->TimeSeconds += Options.SamplingInterval;
+		Recorder->BeginSample();
+		Recorder->CaptureSample();
+	}
+
+	const SIZE_T FrameArraySize = NumFrames * sizeof(FRecordFrame);
+	FDetachedRecordData Record = Recorder->DetachRecordData();
+
+	{
+		FScopedLargeAllocationCounter Counter(FrameArraySize);
+		TestTrue(TEXT("Record is cooked"), BloodStainRecordDataUtils::CookDetachedRecord(Options.SamplingInterval, 0.f, Record));
+		TestEqual(TEXT("Cooking copies the frames out of the slab once"), Counter.GetCount(), 1);
+	}
+	TestEqual(TEXT("Every sample is cooked"), Record.GhostSaveData.RecordedFrames.Num(), NumFrames);
+
+	const FRecordFrame* CookedFrames = Record.GhostSaveData.RecordedFrames.GetData();
+	const FName MainActorName = Record.ActorName;
+	TArray<FDetachedRecordData> Records;
+	Records.Add(MoveTemp(Record));
+
+	FRecordSaveData SaveData;
+	{
+		FScopedLargeAllocationCounter Counter(FrameArraySize);
+		TestTrue(TEXT("Cooked records are assembled"), UBloodStainSubsystem::AssembleCookedRecords(Records, MainActorName, SaveData));
+		TestEqual(TEXT("Hand-off does not copy the frames"), Counter.GetCount(), 0);
+	}
+	if (TestEqual(TEXT("Every record is handed off"), SaveData.RecordActorDataArray.Num(), 1))
+	{
+		TestTrue(TEXT("Hand-off moves the cooked frame buffer"), SaveData.RecordActorDataArray[0].RecordedFrames.GetData() == CookedFrames);
+	}
+	TestEqual(TEXT("Hand-off moves the user data"), SaveData.Header.RecordActorUserData.Num(), 1);
+
+	const FString LevelName = TEXT("BloodStainSystemTests");
+	const FString FileName = TEXT("MoveOnlySavePath");
+	{
+		FScopedLargeAllocationCounter Counter(FrameArraySize);
+		TestTrue(TEXT("Recording is saved"), BloodStainFileUtils::SaveToFile(MoveTemp(SaveData), LevelName, FileName));
+		TestEqual(TEXT("SaveToFile(&&) does not copy the frames"), Counter.GetCount(), 0);
+	}
+	BloodStainFileUtils::DeleteFile(FileName, LevelName);
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBloodStainSaveFrameBlocksTest, "BloodStain.Save.StreamedFrameBlocks",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/**
+ * Streams two actors in blocks the way streamed recordings are written, the second one attaching a component after
+ * the first block, then saves them with SaveFrameBlocksToFile. The file must load back as a regular recording.
+ */
+bool FBloodStainSaveFrameBlocksTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumActors = 2;
+	constexpr int32 NumBlocks = 3;
+	constexpr int32 NumBlockFrames = 10;
+	constexpr int32 NumFrames = NumBlocks * NumBlockFrames;
+
+	FBloodStainFileOptions Options;
+	Options.QuantizationOption = ETransformQuantizationMethod::Standard_Low;
+	Options.EncodingOption = ETransformEncodingMethod::Delta;
+	Options.KeyframeInterval = 4;
+
+	const FString StreamFilePath = FPaths::ProjectSavedDir() / TEXT("BloodStainSystemTests") / TEXT("StreamedFrameBlocks.stream");
+	const TSharedRef<FBloodStainStreamWriter> Stream = MakeShared<FBloodStainStreamWriter>(StreamFilePath, Options);
+	if (!TestTrue(TEXT("Stream is opened"), Stream->Open()))
+	{
+		return false;
+	}
+
+	auto MakeTracks = [](int32 NumTracks)
+	{
+		TArray<FRecordComponentTrack> Tracks;
+		Tracks.SetNum(NumTracks);
+		return Tracks;
+	};
+
+	for (int32 BlockIndex = 0; BlockIndex < NumBlocks; ++BlockIndex)
+	{
+		for (int32 ActorIndex = 0; ActorIndex < NumActors; ++ActorIndex)
+		{
+			const bool bAttached = ActorIndex == 1 && BlockIndex > 0;
+			const int32 NumTracks = bAttached ? 2 : 1;
+
+			TSharedPtr<FRecordFrameSlab> FrameSlab = MakeShared<FRecordFrameSlab>();
+			FrameSlab->Initialize(NumBlockFrames + 1, NumTracks, 0);
+			for (int32 Index = 0; Index < NumBlockFrames; ++Index)
+			{
+				const int32 FrameIndex = BlockIndex * NumBlockFrames + Index;
+				const int32 Slot = FrameSlab->AddFrame(FrameIndex * 0.1f, FrameIndex);
+				FrameSlab->GetComponentTransforms(Slot)[0] = FTransform(FVector(FrameIndex * 10.0, ActorIndex * 100.0, 0.0));
+				FrameSlab->MarkRecorded(Slot, 0);
+				if (bAttached)
+				{
+					FrameSlab->GetComponentTransforms(Slot)[1] = FTransform(FVector(0.0, 0.0, FrameIndex));
+					FrameSlab->MarkRecorded(Slot, 1);
+				}
+			}
+			Stream->AppendBlock(ActorIndex, 0, MakeTracks(NumTracks), MoveTemp(FrameSlab));
+		}
+	}
+
+	FRecordSaveData SaveData;
+	for (int32 ActorIndex = 0; ActorIndex < NumActors; ++ActorIndex)
+	{
+		FRecordActorSaveData& ActorData = SaveData.RecordActorDataArray.AddDefaulted_GetRef();
+		ActorData.PrimaryComponentId = 0;
+		ActorData.ComponentTracks = MakeTracks(ActorIndex == 1 ? 2 : 1);
+		SaveData.Header.RecordActorUserData.AddDefaulted();
+	}
+
+	const FString LevelName = TEXT("BloodStainSystemTests");
+	const FString FileName = TEXT("StreamedFrameBlocks");
+	bool bSaved = false;
+	TArray<FBloodStainActorIndexEntry> IndexEntries;
+	FEvent* StreamClosed = FPlatformProcess::GetSynchEventFromPool();
+	Stream->Finalize([&](bool bSuccess, const FBloodStainStreamWriter& ClosedStream)
+	{
+		for (int32 ActorIndex = 0; ActorIndex < NumActors; ++ActorIndex)
+		{
+			IndexEntries.Add(ClosedStream.GetActorSummary(ActorIndex).IndexEntry);
+		}
+		bSaved = bSuccess && BloodStainFileUtils::SaveFrameBlocksToFile(SaveData, IndexEntries, [&ClosedStream](int32 ActorIndex, FArchive& FileWriter)
+		{
+			return ClosedStream.CopyActorBlocks(ActorIndex, FileWriter);
+		}, LevelName, FileName, ClosedStream.GetFileOptions());
+		StreamClosed->Trigger();
+	});
+	const bool bClosed = StreamClosed->Wait(FTimespan::FromSeconds(10.0));
+	FPlatformProcess::ReturnSynchEventToPool(StreamClosed);
+	if (!TestTrue(TEXT("Stream is closed"), bClosed) || !TestTrue(TEXT("Recording is saved"), bSaved))
+	{
+		return false;
+	}
+	TestEqual(TEXT("Frame count of the index"), IndexEntries[0].NumFrames, NumFrames);
+	TestEqual(TEXT("End time of the index"), IndexEntries[1].EndTime, (NumFrames - 1) * 0.1f);
+
+	FRecordSaveData Loaded;
+	const bool bLoaded = BloodStainFileUtils::LoadFromFile(FileName, LevelName, Loaded);
+	BloodStainFileUtils::DeleteFile(FileName, LevelName);
+	if (!TestTrue(TEXT("Recording is loaded"), bLoaded) || !TestEqual(TEXT("Actor count"), Loaded.RecordActorDataArray.Num(), NumActors))
+	{
+		return false;
+	}
+
+	for (int32 ActorIndex = 0; ActorIndex < NumActors; ++ActorIndex)
+	{
+		const TArray<FRecordFrame>& Frames = Loaded.RecordActorDataArray[ActorIndex].RecordedFrames;
+		if (!TestEqual(TEXT("Frame count"), Frames.Num(), NumFrames))
+		{
+			continue;
+		}
+
+		for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			const FRecordFrame& Frame = Frames[FrameIndex];
+			TestTrue(TEXT("Root location"), Frame.ComponentTransforms[0].GetLocation().Equals(FVector(FrameIndex * 10.0, ActorIndex * 100.0, 0.0), 0.1));
+			if (ActorIndex == 1)
+			{
+				const bool bAttached = FrameIndex >= NumBlockFrames;
+				TestEqual(TEXT("Attached component is recorded from its first block"), Frame.HasTrack(1), bAttached);
+				if (bAttached)
+				{
+					TestTrue(TEXT("Attached component location"), Frame.ComponentTransforms[1].GetLocation().Equals(FVector(0.0, 0.0, FrameIndex), 0.1));
+				}
+			}
+		}
+	}
+	return true;
+}
+
+#endif